@@ -12,6 +12,9 @@ enum class BuzzPatternId : uint8_t {
   ERROR_LOOP
 };
 
+// Buzzer dimiliki task ui: setelah tasksStart(), API di bawah dari task lain
+// hanya mengantrekan perintah (BUZZ_QUEUE_LEN); sebelumnya dieksekusi langsung.
+
 // Init LEDC untuk buzzer (mengambil konstanta dari config.h)
 void buzzerInit();
 
@@ -21,9 +24,16 @@ void buzzSetEnabled(bool enabled);
 // Mainkan pattern preset (lihat BuzzPatternId). buzzPattern(BuzzPatternId::NONE) mematikan pattern aktif.
 void buzzPattern(BuzzPatternId pattern);
 
-// Panggil rutin di loop
+// Dijalankan task ui; sebelum task jalan boleh dipanggil langsung (nada
+// factory reset saat boot)
 void buzzTick(uint32_t now);
 
+// Task ui: ms sampai deadline step berikut (UINT32_MAX = diam), lalu tunggu
+// perintah antrean maksimal maxMs
+uint32_t buzzNextDueMs(uint32_t now);
+void buzzWaitCmd(uint32_t maxMs);
+uint32_t buzzCmdDrops();   // antrean penuh
+
 // Penghenti paksa (mematikan output buzzer)
 void buzzStop();
 
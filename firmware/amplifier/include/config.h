@@ -21,6 +21,17 @@
 // ============================================================================
 //  DS18B20 (heatsink sensor)
 #define DS18B20_PIN            27
+//  Multi-probe: ROM dienumerasi sekali saat boot lalu di-cache di NVS
+//  ("jacktor_ds18") → index slot tetap walau urutan search berubah.
+//  Satu konversi broadcast (Skip ROM) untuk semua probe, scratchpad dibaca
+//  per alamat (satu probe per tick, cek CRC8). Probe baru mengisi slot kosong
+//  atau menggantikan slot yang probe-nya tidak ditemukan lagi.
+#define DS18B20_MAX_SENSORS    4
+#define DS18B20_NAMES          { "heat_l", "heat_r", "trafo", "psu" }
+#define DS18B20_RES_BITS       { 11, 11, 10, 10 }   // 9..12 bit (94..750 ms)
+#define DS18B20_HEATSINK_MASK  0x03                 // slot heatsink → heat_c
+#define DS18B20_PERIOD_MS      1000
+#define DS18B20_STALE_READS    3                    // gagal berturut → NAN
 
 //  Firmware meta
 // ============================================================================
@@ -39,6 +50,7 @@
 #define FEAT_RTC_TEMP_TELEMETRY      1   // kirim rtc_c di telemetri
 #define FEAT_RTC_SYNC_POLICY         1   // offset>2s + rate-limit 24h
 #define FEAT_SMPS_PROTECT_ENABLE     1
+#define FEAT_SMPS_HW_TRIP            1   // comparator ADS1115 → ALERT → ISR buka relay
 #define FEAT_FILTER_DS18B20_SOFT     0   // filter software opsional
 
 #define PC_DETECT_ACTIVE_LOW         1
@@ -65,6 +77,15 @@
 // ============================================================================
 #define SERIAL_BAUD_USB          115200      // USB-CDC monitor
 #define SERIAL_BAUD_LINK         115200      // UART2 ke Panel (telemetri & command)
+#define LINK_RX_BUFFER_BYTES     4096        // buffer RX UART2; diiklankan ke panel via frame credit
+#define LINK_TX_QUEUE_MAX        8           // frame non-telemetri yang ditahan saat kredit panel habis
+#define LINK_TEL_FRAME_EST       1280        // estimasi frame telemetri penuh (cek kredit sebelum build)
+
+// Anggaran RX per tick (agar banjir command tidak menunda powerTick/proteksi SMPS)
+#define LINK_RX_BYTE_BUDGET      1024        // byte UART dibaca per tick
+#define LINK_RX_TIME_BUDGET_US   4000        // waktu eksekusi command per tick (urgent tidak dibatasi)
+#define LINK_RX_QUEUE_MAX        8           // antrean admission baris command
+#define LINK_LOW_PRIO_MIN_MS     100         // jarak minimum command prioritas rendah (buzz/sub/diag/cmd_stats)
 
 // Logging UART internal (Serial) -- default aktif
 #ifndef LOG_ENABLE
@@ -90,19 +111,40 @@
 
 
 // ============================================================================
-//  I²C backbone (RTC + ADS1115 + OLED)
+//  I²C backbone (RTC + ADS1115 + OLED) — dijadwalkan i2c_bus.cpp
+//  - Voltmeter (HIGH) selalu didahulukan; RTC/OLED dalam anggaran per tick
+//  - Page OLED dipecah per I2C_OLED_CHUNK_TILES tile (8 byte/tile)
+//  - DS3231 maks 400 kHz; OLED SSD1306 umumnya stabil di 1 MHz (opsional)
 // ============================================================================
 #define I2C_SDA                  21
 #define I2C_SCL                  22
+#define I2C_BUS_CLOCK_HZ         400000
+#define I2C_OLED_CLOCK_HZ        400000       // 1000000 bila modul OLED mendukung
+#define I2C_BUS_QUEUE_MAX        16
+#define I2C_BUS_HIGH_RESERVE     4            // slot antrean khusus job HIGH (voltmeter)
+#define I2C_BUS_TICK_BUDGET_US   3000         // job NORMAL/LOW per tick
+#define I2C_OLED_CHUNK_TILES     8            // 64 byte per transaksi OLED
+// Isolasi fault per device: timeout transaksi dibatasi, device yang gagal
+// I2C_FAIL_OFFLINE kali berturut ditandai offline dan dilewati; probe ulang
+// dengan backoff eksponensial MIN..MAX. SDA macet LOW → recovery 9 clock SCL.
+#define I2C_TIMEOUT_MS           5
+#define I2C_FAIL_OFFLINE         3
+#define I2C_BACKOFF_MIN_MS       250
+#define I2C_BACKOFF_MAX_MS       30000
+#define I2C_RECOVER_MIN_GAP_MS   1000
 
 
 // ============================================================================
 //  RTC DS3231
 //  - Panel yang mengatur sync waktu → Amplifier (rate-limit & hanya bila offset besar)
-//  - SQW 1 Hz dipakai untuk pacing telemetri saat STANDBY
+//  - SQW 1 Hz dipakai untuk pacing telemetri saat STANDBY dan sebagai detak
+//    jam software (waktu dibaca dari cache, bukan I2C tiap frame)
 // ============================================================================
 #define RTC_I2C_ADDR             0x68
 #define RTC_SQW_PIN              35     // Input SQW 1 Hz
+#define RTC_SQW_EDGE             FALLING  // DS3231: register detik berganti di tepi turun
+#define RTC_SQW_TIMEOUT_MS       1500   // tanpa tepi selama ini → jam jalan dari millis()
+#define RTC_CLOCK_VERIFY_MS      3600000UL  // bandingkan jam software dengan RTC tiap 1 jam
 #define RTC_SYNC_MIN_OFFS_SEC    2      // Tulis RTC hanya jika offset > 2s
 #define RTC_SYNC_MIN_INTERVAL_H  24     // Rate limit sync (jam): 24h
 
@@ -123,7 +165,15 @@
 //  - Gunakan nilai REAL hasil pengukuran agar akurat
 // ============================================================================
 #define ADS_I2C_ADDR             0x48
-#define ADS_CHANNEL              0       // 0..3 (single-ended)
+#define ADS_CHANNEL              0       // AIN SMPS 0..3 (single-ended)
+#define ADS_SAMPLE_INTERVAL_US   2000    // jarak konversi (860 SPS ≈ 1,2 ms/konversi)
+#define ADS_SCOPE_INTERVAL_US    1163    // scope mode: konversi back-to-back (1/860 s)
+// Scope: ADS mode continuous + ALERT sebagai conversion-ready (pulsa per
+// sampel → ISR catat waktu). Tick safety 1 ms lebih pendek dari konversi,
+// jadi tiap sampel terbaca → 860 SPS. Selama capture comparator UV tidak
+// aktif; proteksi software tetap cek tiap sampel. 0 = single-shot per tick
+// (≈ 500 SPS, konversi baru hanya bisa dimulai tiap 2 tick).
+#define ADS_SCOPE_CONTINUOUS     1
 #define R1_OHMS                  201200.0f  // 201.2 kΩ
 #define R2_OHMS                  9650.0f    // 9.65 kΩ
 
@@ -131,6 +181,48 @@
 // (0.10 V dipilih agar tidak terkunci 0.0V namun tetap menolak noise)
 #define VOLT_MIN_VALID_V         0.10f
 
+// Rail tambahan di input ADS1115 lain (sekuencer round-robin, non-blocking).
+// Channel logis tetap: 0=SMPS (ADS_CHANNEL, comparator + scope), 1=rail
+// negatif, 2=aux 12 V, 3=shunt arus. Nilai = V_pin × SCALE + OFFSET.
+//  - Rail negatif: divider R1 ke −V, R2 ke +3,3 V → SCALE=(R1+R2)/R2,
+//    OFFSET=3,3×(1−SCALE)
+//  - Shunt: V_pin = I × R_shunt × gain_amp → SCALE = 1/(R_shunt×gain) [A/V]
+// TRIP_MIN/MAX: batas hook proteksi (NAN = tanpa trip) saat relay ON.
+#define ADS_NEG_ENABLE           1
+#define ADS_NEG_AIN              1
+#define ADS_NEG_GAIN             GAIN_ONE
+#define ADS_NEG_RATE             RATE_ADS1115_475SPS
+#define ADS_NEG_PERIOD_MS        100
+#define ADS_NEG_SCALE            21.0f        // 200k / 10k
+#define ADS_NEG_OFFSET           (-66.0f)     // 3,3 × (1 − 21)
+#define ADS_NEG_TRIP_MIN         NAN
+#define ADS_NEG_TRIP_MAX         (-50.0f)     // rail negatif hilang/melemah
+
+#define ADS_AUX12_ENABLE         1
+#define ADS_AUX12_AIN            2
+#define ADS_AUX12_GAIN           GAIN_ONE
+#define ADS_AUX12_RATE           RATE_ADS1115_475SPS
+#define ADS_AUX12_PERIOD_MS      250
+#define ADS_AUX12_SCALE          4.0f         // 30k / 10k
+#define ADS_AUX12_OFFSET         0.0f
+#define ADS_AUX12_TRIP_MIN       NAN
+#define ADS_AUX12_TRIP_MAX       NAN
+
+#define ADS_SHUNT_ENABLE         1
+#define ADS_SHUNT_AIN            3
+#define ADS_SHUNT_GAIN           GAIN_TWO     // ±2,048 V
+#define ADS_SHUNT_RATE           RATE_ADS1115_860SPS
+#define ADS_SHUNT_PERIOD_MS      20
+#define ADS_SHUNT_SCALE          4.0f         // 5 mΩ × 50 V/V → 4 A/V
+#define ADS_SHUNT_OFFSET         0.0f
+#define ADS_SHUNT_TRIP_MIN       NAN
+#define ADS_SHUNT_TRIP_MAX       NAN
+
+#define ADS_RAIL_TRIP_SAMPLES    3            // sampel berturut di luar batas sebelum trip
+// Anggaran waktu bus ADS per detik; channel 0 (proteksi) tidak pernah ditunda,
+// channel lain ditunda bila anggaran jendela 1 s sudah terpakai.
+#define ADS_BUS_BUDGET_US        150000
+
 
 // ============================================================================
 //  Proteksi SMPS 65V
@@ -142,6 +234,20 @@
 #define SMPS_RECOVERY_V          SMPS_REC_V
 #define SMPS_PROTECT_BYPASS      (!FEAT_SMPS_PROTECT_ENABLE)
 
+// Scope mode (capture tegangan SMPS 860 SPS, lihat scope.h)
+//  - SCOPE_BUF_SAMPLES int16 di RAM (2 byte/sampel)
+//  - trigger default = smps_cut + SCOPE_TRIG_MARGIN_V bila trig_v tidak diberikan
+#define SCOPE_BUF_SAMPLES        2048
+#define SCOPE_PRE_DEFAULT        512
+#define SCOPE_TRIG_MARGIN_V      3.0f
+#define SCOPE_CHUNK_SAMPLES      128     // 256 byte → ±344 karakter base64 per frame
+#define SCOPE_STATS_WINDOW_MS    1000    // jendela min/avg/max berjalan
+
+// Trip hardware (FEAT_SMPS_HW_TRIP): comparator window ADS1115 dengan ambang
+// bawah = cutoff lewat divider R1/R2; ALERT (open-drain, aktif LOW) ke GPIO.
+// ISR membuka relay tanpa menunggu loop; recovery tetap lewat software.
+#define ADS_ALERT_PIN            19
+
 
 // ============================================================================
 //  Bluetooth module
@@ -171,7 +277,7 @@
 
 
 // ============================================================================
-//  Fan PWM (tanpa tachometer) + kurva AUTO 3-titik
+//  Fan PWM (tanpa tachometer) + kurva AUTO N-titik (fan_ctrl.cpp)
 //  - Mode: AUTO / CUSTOM / FAILSAFE (persist di NVS)
 //  - Boot test opsional agar kipas “ngeroll” sebentar
 // ============================================================================
@@ -189,7 +295,8 @@
 #define FAN_DEFAULT_MODE         0
 #define FAN_CUSTOM_DUTY          640    // dipakai jika mode CUSTOM
 
-// Kurva AUTO (titik suhu → duty)
+// Kurva AUTO default (titik suhu → duty); kurva 2..8 titik bisa diganti
+// lewat command fan_curve (disimpan di blob NVS), dikompilasi ke LUT 1 °C.
 // Duty 0..1023; atur sesuai karakter kipas & heatsink
 #define FAN_AUTO_T1_C            40.0f
 #define FAN_AUTO_T2_C            60.0f
@@ -198,6 +305,19 @@
 #define FAN_AUTO_D2              650
 #define FAN_AUTO_D3              1023
 
+// Loop kontrol AUTO: hysteresis turun, slew limit, PI opsional (fan_pi).
+// Parameter di-tuning dengan simulator host tools/fan_sim.cpp.
+#define FAN_CTRL_PERIOD_MS       100
+#define FAN_HYST_C               2.0f
+#define FAN_SLEW_UP_PER_S        400.0f   // duty/s (naik cepat)
+#define FAN_SLEW_DOWN_PER_S      40.0f    // duty/s (turun pelan, tidak "ngos-ngosan")
+#define FAN_DUTY_DEADBAND        16.0f    // koreksi < ini diabaikan
+#define FAN_PI_SETPOINT_C        55.0f
+#define FAN_PI_KP                25.0f    // duty per °C
+#define FAN_PI_KI                0.5f     // duty per °C·s
+#define FAN_PI_INTEG_MAX         400.0f
+#define FAN_SENSOR_FAIL_DUTY     ((FAN_AUTO_D1 + FAN_AUTO_D2) / 2)
+
 // Duty fallback bila FAILSAFE
 #define FAN_FALLBACK_DUTY        900
 
@@ -237,6 +357,10 @@
 #define SPK_PROTECT_ACTIVE_HIGH  1      // LED ON = normal
 #define SPK_PROTECT_FAULT_MS     1500
 
+// Status BT, LED protector & PC detect dibaca lewat ISR CHANGE (gpio_edge.cpp),
+// bukan digitalRead tiap loop; timer debounce/latch dihitung dari waktu tepi
+#define GPIO_EDGE_QUEUE          32     // pangkat 2
+
 
 // ============================================================================
 //  Analyzer (ala Webspector) — I²S ADC internal
@@ -258,6 +382,117 @@
 #define ANA_BANDS                16           // boleh 17 jika UI panel masih ada ruang
 
 
+// ============================================================================
+//  Penjadwal loop (sched.cpp)
+//  - Job periodik/one-shot didaftarkan modul saat init; loop tidur sampai
+//    deadline terdekat (dibatasi SCHED_MAX_SLEEP_MS agar RX link tetap cepat)
+//  - Per job: late (mulai > SCHED_LATE_MS dari deadline) & overrun (> budget)
+// ============================================================================
+#define SCHED_MAX_JOBS           16
+#define SCHED_LATE_MS            5
+#define SCHED_MAX_SLEEP_MS       5
+//                               periode ms / anggaran µs (job task comms)
+#define SCHED_DS18_MS            10           // state machine DS18B20 (1 scratchpad/job)
+#define SCHED_DS18_BUDGET_US     12000        // 1-Wire bit-bang ±10 ms per probe
+#define SCHED_TEMP_MS            1000         // suhu RTC + histogram statistik
+#define SCHED_TEMP_BUDGET_US     500
+#define SCHED_NVS_MS             100
+#define SCHED_NVS_BUDGET_US      40000        // commit flash
+#define SCHED_STATS_MS           250
+#define SCHED_STATS_BUDGET_US    40000
+
+// ============================================================================
+//  Task FreeRTOS (tasks.cpp)
+//  - safety   : ADS/proteksi SMPS & rail, protector speaker, kipas/thermal;
+//               periodik vTaskDelayUntil, prioritas tertinggi
+//  - comms    : loopTask Arduino (link UART, BT/PC detect, job sched)
+//  - ui       : OLED + buzzer (perintah lewat antrean), job I2C non-ADS
+//  - analyzer : I2S + FFT di core 0, terpisah dari jalur safety
+//  Lock: powerLock → bus I2C (urutan tetap). Semua task di-watchdog.
+// ============================================================================
+#define SAFETY_PERIOD_MS         1
+#define SAFETY_TASK_PRIO         10
+#define SAFETY_TASK_CORE         1
+#define SAFETY_TASK_STACK        4096
+#define UI_FRAME_MS              33
+#define UI_TASK_PRIO             2
+#define UI_TASK_CORE             1
+#define UI_TASK_STACK            4096
+#define ANA_TASK_PRIO            1
+#define ANA_TASK_CORE            0
+#define ANA_TASK_STACK           6144         // buffer FFT di static, stack untuk I2S
+#define ANA_TASK_WAIT_MS         1000         // tidur saat analyzer nonaktif
+#define TASK_WDT_TIMEOUT_S       5
+#define TASK_LOAD_WINDOW_MS      1000
+#define BUZZ_QUEUE_LEN           8
+#define SAFETY_EVT_QUEUE_LEN     8
+#define SAFETY_HEAT_FULL_FAN_C   85.0f        // suhu maks → kipas penuh (hyst FAN_HYST_C)
+#define I2C_LOCK_TIMEOUT_MS      20
+
+// ============================================================================
+//  Load shedding loop comms (shed.cpp)
+//  - Urutan: OLED setengah FPS → telemetri keyframe (kerja di core 1)
+//  - Naik satu level per jendela dengan ≥ SHED_MIN_OVERRUNS overrun (commit
+//    flash tidak dihitung); turun satu level setelah SHED_RESTORE_WINDOWS
+//    jendela lega (< SHED_HEADROOM_PCT % anggaran)
+// ============================================================================
+#define SHED_LOOP_BUDGET_US      25000        // > 1 baca DS18B20 (±12 ms) + link
+#define SHED_WINDOW_MS           500
+#define SHED_MIN_OVERRUNS        3            // overrun tunggal (spike) tidak men-shed
+#define SHED_RESTORE_WINDOWS     6            // 3 s lega sebelum pulih satu level
+#define SHED_HEADROOM_PCT        50
+#define SHED_TEL_KEYFRAME_MS     1000         // level telemetri: 1 frame penuh/detik
+
+// ============================================================================
+//  Profiler jalur panas (perf.cpp) — command {"perf":"show|hist|reset"}
+//  - Siklus CPU per seksi (sensors/power/comms/ota/ui/buzz/analyzer)
+//  - Histogram log2, 2 bin per oktaf: bin terakhir = ≥ 2^(BINS/2) siklus
+// ============================================================================
+#ifndef PERF_ENABLE
+#define PERF_ENABLE              1            // 0 = PERF_SCOPE() tanpa biaya
+#endif
+#define PERF_HIST_BINS           48           // 2^24 siklus ≈ 70 ms @240 MHz
+
+// ============================================================================
+//  Trace event (trace.cpp) — command {"trace":"dump|status|clear"}
+//  - Record 12 byte di ring RAM; dump = chunk base64 "trace_chunk"
+//  - Host: tools/trace2chrome.cpp → JSON Chrome/Perfetto
+// ============================================================================
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE             1            // 0 = traceEmit() kosong
+#endif
+#define TRACE_RECORDS            512          // pangkat 2; 512 × 12 B = 6 KiB
+#define TRACE_CHUNK_RECS         32           // record per frame trace_chunk
+
+
+// ============================================================================
+//  NVS write-behind (state.cpp)
+//  - Setter hanya mengubah cache RAM + tandai dirty
+//  - stateTick() commit setelah sepi NVS_WRITE_DEBOUNCE_MS, atau paling
+//    lambat NVS_WRITE_MAX_DELAY_MS sejak perubahan pertama (slider terus digeser)
+//  - stateFlush() dipanggil saat power OFF, OTA, factory reset, reboot
+// ============================================================================
+#define NVS_WRITE_DEBOUNCE_MS    1500
+#define NVS_WRITE_MAX_DELAY_MS   10000
+
+
+// ============================================================================
+//  Statistik seumur hidup (stats.cpp) — namespace NVS "jacktor_stats"
+//  - Counter + histogram waktu di RAM, disimpan tiap STATS_SAVE_INTERVAL_MS
+//  - Flush juga saat power OFF (dibatasi STATS_FLUSH_MIN_GAP_MS), OTA, reboot
+//  - Histogram: bin 0 = < MIN, bin terakhir = di atas rentang
+// ============================================================================
+#define STATS_SAVE_INTERVAL_MS   (15UL * 60UL * 1000UL)   // 15 menit
+#define STATS_FLUSH_MIN_GAP_MS   (60UL * 1000UL)
+#define STATS_HEAT_BINS          10
+#define STATS_HEAT_MIN_C         20.0f
+#define STATS_HEAT_STEP_C        10.0f        // <20, 20–30, …, 90–100, ≥100
+#define STATS_VOLT_BINS          10
+#define STATS_VOLT_MIN_V         44.0f
+#define STATS_VOLT_STEP_V        2.0f         // <44, 44–46, …, ≥60
+#define STATS_FAN_BINS           8            // duty 0..1023 / 128 per bin
+
+
 // ============================================================================
 //  Telemetry pacing
 //  - Saat ON   : realtime cepat (mis. 10 Hz)
@@ -267,6 +502,11 @@
 #define TELEMETRY_HZ_ACTIVE      10
 #define TELEMETRY_HZ_STANDBY     1
 
+// Langganan telemetri per topik (command "sub"): power|thermal|analyzer|nvs|errors|features
+// - Tanpa langganan → frame monolitik lama di atas (kompatibel)
+// - Dengan langganan → frame parsial {..,"partial":true,data:{hanya topik jatuh tempo}}
+#define TELEMETRY_TOPIC_MAX_HZ   50           // batas atas rate per topik
+
 
 // ============================================================================
 //  OTA via UART (Panel) — ukuran maksimum file .bin
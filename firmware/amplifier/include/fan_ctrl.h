@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+
+// Kontroler kipas AUTO tanpa dependensi Arduino → dipakai firmware (power.cpp)
+// dan simulator host tools/fan_sim.cpp (model termal heatsink).
+//
+// Kurva N titik (suhu → duty) dikompilasi ke LUT resolusi 1 °C; per langkah
+// hanya lookup + hysteresis + (opsional) koreksi PI + slew limit.
+
+#define FAN_CURVE_MAX_POINTS 8      // bagian dari ABI blob NVS (state.cpp)
+#define FAN_LUT_SIZE         128    // 0..127 °C
+
+struct FanCurve {
+  uint8_t  n;                            // 2..FAN_CURVE_MAX_POINTS
+  uint8_t  tC[FAN_CURVE_MAX_POINTS];     // naik ketat, °C
+  uint16_t duty[FAN_CURVE_MAX_POINTS];   // 0..1023
+};
+
+struct FanCtrlParams {
+  bool     pi;            // koreksi PI di atas feed-forward LUT
+  float    setpointC;
+  float    kp;            // duty per °C
+  float    ki;            // duty per °C·s
+  float    integMax;      // batas |integral| (duty)
+  float    hystC;         // duty baru turun setelah suhu turun hystC
+  float    slewUpPerS;    // duty/s
+  float    slewDownPerS;
+  float    deadband;      // selisih duty minimum agar keluaran bergerak
+  uint16_t failDuty;      // suhu NAN
+};
+
+struct FanCtrl {
+  FanCtrlParams p;
+  uint16_t lut[FAN_LUT_SIZE];
+  float    tEff;          // suhu setelah hysteresis
+  float    integ;
+  float    duty;          // keluaran setelah slew (float agar slew kecil tetap maju)
+  bool     primed;
+};
+
+bool     fanCurveValid(const FanCurve &c);
+void     fanCurveDefault(FanCurve &c);          // dari FAN_AUTO_* (config.h)
+
+void     fanCtrlInit(FanCtrl &c, const FanCtrlParams &p, const FanCurve &curve);
+void     fanCtrlSetCurve(FanCtrl &c, const FanCurve &curve);   // kompilasi LUT
+uint16_t fanCtrlLut(const FanCtrl &c, float tC);
+
+// Satu langkah kontrol; dtS = detik sejak langkah sebelumnya
+uint16_t fanCtrlStep(FanCtrl &c, float tC, float dtS);
+
+// Mode lain (CUSTOM/FAILSAFE) memegang kipas: ikuti duty-nya agar kembali
+// ke AUTO tanpa lompatan, integral dibuang
+void     fanCtrlTrack(FanCtrl &c, uint16_t duty);
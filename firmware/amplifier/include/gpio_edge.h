@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+
+// Edge capture input GPIO lambat (status BT, LED speaker protector, PC detect).
+// ISR CHANGE mencatat (sumber, level, waktu) ke ring SPSC lock-free; loop
+// menguras antrean lewat gpioEdgeService(). Debounce/latch di power.cpp
+// dihitung dari waktu tepi (ISR), bukan dari kapan loop sempat melihatnya.
+// Tepi dengan level sama dengan level terakhir (glitch GPIO36/39 saat ADC/
+// WiFi aktif, bounce yang terlewat) dibuang di ISR.
+
+enum class EdgeSrc : uint8_t {
+  BtStatus = 0,
+  SpkLed,
+  PcDetect,
+  Count
+};
+
+void     gpioEdgeInit();                     // setelah pinMode ketiga pin
+
+// Kuras antrean; return jumlah event yang diproses. Antrean penuh → level
+// dibaca ulang langsung dari pin dengan waktu tepi = now (konservatif).
+uint8_t  gpioEdgeService(uint32_t now);
+
+bool     gpioEdgeLevel(EdgeSrc s);           // level pin mentah terakhir (HIGH = true)
+uint32_t gpioEdgeSinceMs(EdgeSrc s);         // millis() saat tepi terakhir
+
+struct GpioEdgeStats {
+  uint32_t edges[(uint8_t)EdgeSrc::Count];
+  uint32_t dupes;        // tepi tanpa perubahan level (dibuang di ISR)
+  uint32_t overflows;    // antrean penuh → resync
+  uint8_t  queuePeak;
+  uint32_t lagMaxUs;     // ISR → diproses loop (terlama)
+};
+void     gpioEdgeGetStats(GpioEdgeStats &out);
+const char* gpioEdgeName(EdgeSrc s);
@@ -0,0 +1,79 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Penjadwal transaksi I²C bersama (RTC, ADS1115, OLED) di satu bus Wire.
+// Modul lain tidak memanggil Wire langsung dari loop; transaksi diantrikan
+// sebagai job dengan prioritas lalu dieksekusi i2cBusTick():
+//  - I2C_PRIO_HIGH  : semua dijalankan tiap tick (voltmeter/proteksi)
+//  - NORMAL / LOW   : dalam anggaran waktu I2C_BUS_TICK_BUDGET_US per tick,
+//                     minimal satu job agar tidak kelaparan
+// Transfer besar (page OLED) dipecah jadi beberapa job kecil oleh pemanggil.
+// Bus dipakai lintas task di bawah mutex: task safety hanya menjalankan
+// job HIGH (voltmeter), task ui/comms menjalankan NORMAL/LOW.
+// Device yang gagal berturut-turut jadi offline: submit/run langsung ditolak
+// (mode degradasi, tanpa menunggu timeout) dan bus yang mem-probe ulang
+// dengan backoff eksponensial. Pemanggil cukup cek i2cBusDevOnline().
+
+enum class I2cDev : uint8_t {
+  Rtc = 0,
+  Ads,
+  Oled,
+  Count
+};
+
+enum I2cPrio : uint8_t {
+  I2C_PRIO_HIGH   = 0,
+  I2C_PRIO_NORMAL = 1,
+  I2C_PRIO_LOW    = 2,
+};
+
+// Job dieksekusi di konteks loop; arg bebas (mis. koordinat tile OLED).
+// Return false bila transaksi gagal.
+typedef bool (*I2cJobFn)(uint32_t arg);
+
+void i2cBusInit();
+void i2cBusTick(uint32_t now, I2cPrio minPrio = I2C_PRIO_HIGH, I2cPrio maxPrio = I2C_PRIO_LOW);
+
+// Antrikan job; false bila antrean penuh (pemanggil boleh coba lagi).
+// NORMAL/LOW tidak boleh memakai I2C_BUS_HIGH_RESERVE slot terakhir.
+bool i2cBusSubmit(I2cDev dev, I2cPrio prio, I2cJobFn fn, uint32_t arg, uint16_t estBytes);
+
+// Jalankan langsung (boot, set RTC); tetap dihitung di statistik.
+bool i2cBusRun(I2cDev dev, I2cJobFn fn, uint32_t arg, uint16_t estBytes);
+
+struct I2cDevStats {
+  uint32_t jobs;
+  uint32_t fails;
+  uint32_t bytes;        // perkiraan payload
+  uint32_t busyUs;       // total waktu eksekusi
+  uint32_t latMaxUs;     // antre + eksekusi terlama
+  uint32_t latAvgUs;
+  bool     online;
+  uint32_t backoffMs;    // jeda probe berikutnya saat offline
+  uint32_t skipped;      // job ditolak karena offline
+  uint32_t offlineCount; // transisi online → offline
+};
+
+struct I2cBusStats {
+  uint32_t clockHz;
+  uint8_t  utilPct;      // busy / jendela 1 detik terakhir
+  uint8_t  queue;
+  uint8_t  queuePeak;
+  uint32_t drops;        // submit ditolak (antrean penuh)
+  uint32_t deferred;     // submit NORMAL/LOW ditolak karena slot cadangan HIGH
+  uint32_t budgetHits;   // tick berhenti karena anggaran habis
+  uint32_t recoveries;   // recovery bus (toggle SCL)
+  uint32_t lockTimeouts; // mutex bus tidak didapat dalam I2C_LOCK_TIMEOUT_MS
+  I2cDevStats dev[(uint8_t)I2cDev::Count];
+};
+
+void i2cBusGetStats(I2cBusStats &out);
+uint8_t i2cBusQueued();   // job masih antre (loop jangan tidur)
+
+bool i2cBusDevOnline(I2cDev dev);
+
+// Probe alamat (write kosong, ACK = ada); untuk job yang library-nya tidak
+// melaporkan error (RTClib, U8g2). Hanya dari dalam job.
+bool i2cBusProbe(uint8_t addr);
+const char* i2cDevName(I2cDev dev);
@@ -9,7 +9,8 @@ enum class OtaStatus : uint8_t {
   Failed
 };
 
-// Init/loop helper untuk state mesin OTA via UART
+// Init state mesin OTA via UART; otaTick = job one-shot sched yang
+// menjalankan reboot tertunda setelah otaEnd(true)
 void otaInit();
 void otaTick(uint32_t now);
 
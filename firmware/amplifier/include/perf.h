@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include "config.h"
+
+#if defined(ESP_PLATFORM)
+  #include <xtensa/hal.h>
+#else
+  #include <time.h>
+#endif
+
+// Profiler jalur panas berbasis cycle counter CPU.
+// Tiap seksi bernama mencatat min/max/rata-rata + histogram log2 (2 bin per
+// oktaf, ukuran tetap) sehingga p50/p99 bisa diperkirakan tanpa menyimpan
+// sampel. Satu seksi hanya dicatat dari satu task (tanpa lock); task yang
+// dipin ke satu core membaca CCOUNT core yang sama di awal dan akhir.
+// PERF_ENABLE 0 → PERF_SCOPE() kosong (tanpa biaya).
+//  - ESP32  : xthal_get_ccount() (siklus CPU)
+//  - native : clock_gettime(CLOCK_MONOTONIC) dalam ns (cpu_mhz = 1000)
+
+enum class PerfSec : uint8_t {
+  SensorsTick = 0,   // comms: jam SQW
+  PowerSafety,       // safety: ADS/proteksi/kipas
+  PowerTick,         // comms: event safety, BT, PC detect
+  CommsTick,         // comms: RX/TX link
+  SchedRun,          // comms: job ds18/temp/nvs/stats/reboot
+  OtaWrite,          // comms: tulis chunk OTA ke flash
+  UiTick,            // ui: render + kirim frame OLED
+  BuzzTick,          // ui: step buzzer
+  Analyzer,          // analyzer: FFT + VU
+  Count
+};
+
+static inline uint32_t perfCycles() {
+#if defined(ESP_PLATFORM)
+  return xthal_get_ccount();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+#endif
+}
+
+void        perfRecord(PerfSec s, uint32_t cycles);
+void        perfReset();
+const char* perfName(PerfSec s);
+uint32_t    perfCyclesPerUs();
+
+struct PerfStats {
+  uint32_t count;
+  uint32_t minCyc;
+  uint32_t avgCyc;
+  uint32_t maxCyc;
+  uint32_t p50Cyc;       // batas atas bin histogram (dibatasi max)
+  uint32_t p99Cyc;
+  uint32_t hist[PERF_HIST_BINS];
+};
+bool        perfGet(PerfSec s, PerfStats &out);
+uint32_t    perfBinLowCyc(uint8_t bin);   // batas bawah bin histogram
+
+#if PERF_ENABLE
+struct PerfScope {
+  PerfSec  sec;
+  uint32_t t0;
+  explicit PerfScope(PerfSec s) : sec(s), t0(perfCycles()) {}
+  ~PerfScope() { perfRecord(sec, perfCycles() - t0); }
+};
+  #define PERF_CAT2(a, b) a##b
+  #define PERF_CAT(a, b)  PERF_CAT2(a, b)
+  #define PERF_SCOPE(sec) PerfScope PERF_CAT(_perfScope, __LINE__)(PerfSec::sec)
+#else
+  #define PERF_SCOPE(sec) do {} while (0)
+#endif
@@ -4,7 +4,11 @@
 // Inisialisasi GPIO (relay, fan PWM, BT, selector/power speaker, monitor, dll.)
 void powerInit();
 
-// Tick rutin (panggil di loop)
+// Task safety (tiap SAFETY_PERIOD_MS): voltmeter ADS, proteksi SMPS/rail,
+// monitor protector speaker, kipas + override thermal
+void powerSafetyTick(uint32_t now);
+
+// Tick task comms: log event safety, logika BT/PC detect
 void powerTick(uint32_t now);
 
 // Relay utama (aktif HIGH/LOW sesuai config)
@@ -29,5 +33,42 @@ void powerSetOtaActive(bool on);
 // Fault monitor speaker protector LED
 bool powerSpkProtectFault();
 
+// Bit per channel ADS (1=neg_v, 2=aux12_v, 3=shunt_a) yang trip; dilepas
+// saat relay dimatikan lewat powerSetMainRelay(false).
+uint8_t powerRailFaultMask();
+
+// Jarak terlama antar cek proteksi SMPS (µs) sejak pembacaan terakhir;
+// reset=true mengosongkan puncak setelah dibaca (untuk uji latensi).
+uint32_t powerProtectMaxGapUs(bool reset);
+
+// Trip undervolt SMPS: hw = ALERT ADS1115 → ISR, sw = polling loop.
+// latency = mulai konversi ADS → relay dibuka ISR; ack = ISR → loop menyusul.
+struct SmpsTripStats {
+  bool     hwEnabled;
+  bool     armed;
+  uint32_t hwTrips;
+  uint32_t swTrips;
+  uint32_t latLastUs;
+  uint32_t latMaxUs;
+  uint32_t ackMaxUs;
+};
+void powerGetSmpsTripStats(SmpsTripStats &out);
+
+// Kontrol kipas (fan_ctrl.cpp); writes = tulis LEDC aktual (hanya saat duty berubah)
+struct FanStats {
+  uint16_t duty;
+  uint32_t writes;
+  bool     pi;
+  float    tEffC;     // suhu setelah hysteresis (NAN = belum/sensor gagal)
+  float    integ;     // integral PI (duty)
+  uint16_t lutMin;    // duty LUT pada 0 °C / 127 °C
+  uint16_t lutMax;
+  bool     hot;       // override thermal: duty penuh >= SAFETY_HEAT_FULL_FAN_C
+};
+void powerGetFanStats(FanStats &out);
+
+// Event safety yang hilang karena antrean penuh
+uint32_t powerSafetyEvtDrops();
+
 // Input mode string (untuk telemetri/UI ringkas)
 const char* powerInputModeStr();
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+#include <Arduino.h>
+
+// Penjadwal job kooperatif (deadline) untuk loop utama.
+// Modul mendaftarkan job periodik atau one-shot saat init; schedRun()
+// menjalankan job yang sudah jatuh tempo (urutan pendaftaran = prioritas),
+// schedIdle() menidurkan loop sampai deadline terdekat alih-alih tiap modul
+// mengecek millis() sendiri di setiap iterasi.
+//  - Periodik : deadline maju per periode (fase tetap); bila tertinggal satu
+//               periode penuh, fase disetel ulang (tidak ada ledakan catch-up)
+//  - One-shot : tidak aktif sampai schedArm(); setelah jalan kembali nonaktif
+//  - schedCancel() menonaktifkan job jenis apa pun (mis. analyzer saat
+//    standby); schedArm() mengaktifkannya lagi
+//  - late     : mulai > SCHED_LATE_MS setelah deadline
+//  - overrun  : durasi > anggaran budgetUs (0 = tanpa anggaran)
+// Berjalan di task comms (loopTask). Proteksi, UI/buzzer dan analyzer punya
+// task sendiri (tasks.h); job di sini hanya housekeeping yang toleran latensi.
+
+typedef void (*SchedFn)(uint32_t now);
+typedef int8_t SchedId;            // -1 = tabel penuh
+
+SchedId schedEvery(const char *name, SchedFn fn, uint32_t periodMs, uint32_t budgetUs);
+SchedId schedOnce(const char *name, SchedFn fn, uint32_t budgetUs);
+
+void    schedArm(SchedId id, uint32_t delayMs);   // (re)arm; periodik: fase mulai dari sini
+void    schedCancel(SchedId id);
+bool    schedArmed(SchedId id);
+
+void    schedInit();               // paling awal di appInit (catat task loop)
+void    schedRun(uint32_t now);
+
+// Tidur sampai deadline job terdekat, dibatasi maxWaitUs (jalur cepat) dan
+// SCHED_MAX_SLEEP_MS. Sisa < 1 tick RTOS → tidak tidur.
+void    schedIdle(uint32_t maxWaitUs);
+
+// Bangunkan loop lebih awal dari ISR (tepi GPIO, SQW RTC)
+void    schedWakeFromIsr();
+
+struct SchedJobStats {
+  const char *name;
+  uint32_t periodMs;     // 0 = one-shot
+  uint32_t budgetUs;
+  uint32_t runs;
+  uint32_t late;
+  uint32_t overruns;
+  uint32_t skipped;      // periode terlewat (fase disetel ulang)
+  uint32_t maxUs;
+  uint32_t lateMaxMs;
+};
+
+struct SchedStats {
+  uint16_t loopsPerS;    // iterasi appTick per detik (jendela 1 detik)
+  uint8_t  sleepPct;     // porsi waktu loop tidur
+  uint32_t isrWakes;     // tidur dipotong ISR
+  uint8_t  jobs;
+};
+
+void    schedGetStats(SchedStats &out);
+bool    schedGetJobStats(uint8_t idx, SchedJobStats &out);
@@ -0,0 +1,59 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// "Scope mode" tegangan SMPS: sampel mentah ADS1115 (860 SPS) masuk ring
+// buffer RAM; trigger undervoltage (level) atau manual, dengan pre-trigger.
+// Hasil dibekukan sampai di-dump (chunk biner base64 oleh comms) / di-arm lagi.
+// Di luar capture, setiap sampel tetap masuk statistik min/avg/max per jendela
+// SCOPE_STATS_WINDOW_MS (hanya compare + jumlah, tanpa buffer).
+
+enum class ScopeState : uint8_t {
+  Idle = 0,
+  Armed,       // isi ring, tunggu trigger
+  Triggered,   // kumpulkan sampel pasca-trigger
+  Done,        // capture beku, siap dump
+};
+
+const char* scopeStateToStr(ScopeState s);
+
+struct ScopeInfo {
+  ScopeState state;
+  bool     manual;      // trigger dari command
+  int16_t  trigCode;    // ambang (kode ADC); INT16_MIN = hanya manual
+  uint16_t pre;         // sampel sebelum trigger (aktual)
+  uint16_t count;       // total sampel capture
+  uint32_t periodUs;    // rata-rata jarak sampel pasca-trigger
+  uint32_t maxGapUs;    // jarak terlama antar sampel selama capture
+  uint32_t trigAgoMs;   // umur capture
+};
+
+struct ScopeRunStats {
+  int16_t  minCode;
+  int16_t  maxCode;
+  int32_t  avgCode;
+  uint32_t samples;     // jumlah sampel di jendela terakhir (≈ SPS)
+};
+
+void  scopeInit();
+
+// Dari job ADS (konteks loop); t = micros() saat konversi dimulai
+void  scopeOnSample(int16_t raw, uint32_t t);
+
+// true saat Armed/Triggered → sensors memacu ADS ke laju maksimum
+bool  scopeFast();
+
+// pre/total dibatasi SCOPE_BUF_SAMPLES; trigCode INT16_MIN = manual saja
+bool  scopeArm(int16_t trigCode, uint16_t pre, uint16_t total);
+bool  scopeTrigger();
+void  scopeAbort();
+
+ScopeState scopeState();
+void  scopeGetInfo(ScopeInfo &out);
+void  scopeGetRunStats(ScopeRunStats &out);
+
+// Salin sampel capture (urut waktu) mulai off; return jumlah tersalin
+uint16_t scopeRead(uint16_t off, int16_t *out, uint16_t n);
+
+// true sekali setiap capture selesai (untuk auto-dump)
+bool  scopeConsumeDone();
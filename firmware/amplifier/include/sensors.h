@@ -4,10 +4,61 @@
 
 // ---- Voltage & Temperature ----
 void  sensorsInit();
-void  sensorsTick(uint32_t now);
+void  sensorsTick(uint32_t now);        // task comms: jam SQW
+void  sensorsSafetyTick(uint32_t now);  // task safety: antre konversi ADS (voltmeter)
 
 float getVoltageInstant();   // Volt (ADS1115, tanpa smoothing)
-float getHeatsinkC();        // °C (DS18B20) atau NAN jika invalid
+
+// Comparator ADS1115 (FEAT_SMPS_HW_TRIP): ALERT aktif bila tegangan riil <
+// vReal; ambang ditulis ke ADS saat berubah. Waktu mulai konversi terakhir
+// aman dibaca dari ISR (untuk latensi trip).
+void  sensorsSetUvTripV(float vReal);
+uint32_t sensorsAdsConvStartUs();
+
+// Scope (ADS_SCOPE_CONTINUOUS): ALERT jadi conversion-ready. ISR ALERT
+// memanggil sensorsAdsAlertIsr() dulu; true = pulsa sampel, bukan trip.
+bool  sensorsAdsAlertIsr();
+bool  sensorsAdsRdyMode();
+
+// Sekuencer ADS1115: channel logis 0=smps_v, 1=neg_v, 2=aux12_v, 3=shunt_a
+// (lihat ADS_* di config.h). Nilai NAN bila channel nonaktif/belum terbaca.
+// Hook dipanggil dari konteks loop setiap sampel baru channel tsb.
+#define ADS_NUM_CH 4
+typedef void (*AdsChHook)(uint8_t ch, float value);
+float sensorsAdsChValue(uint8_t ch);
+const char* sensorsAdsChName(uint8_t ch);
+void  sensorsSetAdsHook(uint8_t ch, AdsChHook fn);
+
+struct AdsSeqStats {
+  uint32_t busUsPerS;    // waktu bus ADS di jendela 1 s terakhir
+  uint32_t budgetUs;     // ADS_BUS_BUDGET_US
+  uint32_t deferred;     // channel aux ditunda karena anggaran
+  uint32_t samples[ADS_NUM_CH];
+};
+void  sensorsGetAdsStats(AdsSeqStats &out);
+
+// Konversi kode mentah ADS1115 ↔ volt riil SMPS (divider + gain aktif)
+int16_t sensorsVoltToAdsCode(float vReal);
+float sensorsAdsCodeToVolt(int16_t raw);
+float getHeatsinkC();        // °C maks. probe heatsink (DS18B20) atau NAN jika invalid
+
+// DS18B20 multi-probe: slot tetap (urutan ROM di NVS), lihat DS18B20_* di config.h
+uint8_t     sensorsTempCount();           // DS18B20_MAX_SENSORS
+float       sensorsTempC(uint8_t idx);    // °C atau NAN (kosong/gagal)
+const char* sensorsTempName(uint8_t idx);
+bool        sensorsTempRom(uint8_t idx, char* out, size_t n);  // hex 16 digit
+float       sensorsTempMaxC();            // maks. probe valid (untuk kipas) atau NAN
+bool        sensorsTempFault();           // tidak ada probe / slot terdaftar gagal
+
+struct DsTempStats {
+  uint8_t  found;        // probe ditemukan saat enumerasi boot
+  uint8_t  known;        // slot terisi ROM (cache NVS)
+  uint16_t convMs;       // waktu tunggu konversi (resolusi tertinggi)
+  uint32_t crcErrors;
+  uint32_t misses;       // tidak ada presence pulse
+  uint32_t readUsMax;    // baca scratchpad terlama (blocking per tick)
+};
+void  sensorsGetTempStats(DsTempStats& out);
 float sensorsGetRtcTempC();  // °C RTC internal (DS3231) atau NAN
 
 // ---- Analyzer (FFT 16-band) ----
@@ -15,8 +66,26 @@ void  analyzerGetBytes(uint8_t* out, size_t n);  // 0..255 per band
 void  analyzerGetVu(uint8_t& outVu);             // 0..255 mono VU
 void  sensorsSetAnalyzerEnabled(bool en);        // matikan saat standby
 
+// Badan task analyzer (core 0): tunggu sampel I2S / enable (tidak dihitung
+// beban), lalu FFT + publish band/VU
+void  analyzerWait(uint32_t maxMs);
+void  analyzerWork(uint32_t now);
+
 // ---- RTC/SQW utils ----
 bool  sensorsGetTimeISO(char* out, size_t n);    // "YYYY-MM-DDTHH:MM:SSZ"
 bool  sensorsSqwConsumeTick();                   // true jika ada pulse 1 Hz
 bool  sensorsGetUnixTime(uint32_t& epochOut);    // epoch detik (UTC)
+bool  sensorsGetTime(uint32_t& epochOut, uint16_t& msOut);  // + milidetik (interpolasi)
 bool  sensorsSetUnixTime(uint32_t epoch);        // set RTC ke epoch UTC
+
+// Waktu di atas dari jam software (tanpa I2C); RTC hanya dibaca saat boot,
+// setelah set, dan verifikasi tiap RTC_CLOCK_VERIFY_MS.
+struct RtcClockStats {
+  bool     valid;
+  bool     sqwOk;      // tepi SQW datang teratur
+  uint32_t edges;
+  uint32_t rtcReads;   // bacaan I2C waktu sejak boot
+  uint32_t sqwLost;    // berapa kali SQW hilang (fallback millis)
+  int32_t  lastStepS;  // koreksi detik saat anchor ulang terakhir
+};
+void  sensorsGetClockStats(RtcClockStats& out);
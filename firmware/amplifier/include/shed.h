@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+
+// Monitor anggaran waktu loop comms + load shedding bertingkat.
+// Tiap iterasi appTick() melapor durasinya (wall-clock, termasuk preempt
+// task ui/safety). Per jendela SHED_WINDOW_MS:
+//  - ≥ SHED_MIN_OVERRUNS iterasi > SHED_LOOP_BUDGET_US → naik satu level
+//  - SHED_RESTORE_WINDOWS jendela berturut-turut dengan iterasi terlama
+//    < SHED_HEADROOM_PCT % anggaran         → turun satu level
+// Iterasi berisi commit flash (shedExcuseIter) tidak dihitung: lamanya
+// sudah dianggarkan SCHED_*_BUDGET_US dan tidak bisa di-shed.
+// Level kumulatif, hanya kerja yang bersaing dengan loop comms di core 1
+// (analyzer di core 0 tidak ikut):
+//  1 Oled      : frame OLED 2 × UI_FRAME_MS (task ui prioritas > comms)
+//  2 Telemetry : telemetri hanya keyframe tiap SHED_TEL_KEYFRAME_MS
+// Setiap keputusan dihitung (enter/exit per level) dan di-log
+// ("shed_<level>" warn / "restore_<level>" info).
+
+enum class ShedLevel : uint8_t { None = 0, Oled, Telemetry, Count };
+
+void        shedLoopSample(uint32_t now, uint32_t iterUs);   // task comms
+void        shedExcuseIter();   // iterasi comms ini berisi commit flash
+ShedLevel   shedLevel();
+const char* shedLevelName(ShedLevel l);
+
+struct ShedStats {
+  ShedLevel level;
+  uint32_t  budgetUs;
+  uint32_t  overruns;       // iterasi > anggaran
+  uint32_t  excused;        // iterasi commit flash (tidak dihitung)
+  uint32_t  iterMaxUs;      // terlama sejak boot
+  uint32_t  enters[(uint8_t)ShedLevel::Count];   // index 0 tidak dipakai
+  uint32_t  exits[(uint8_t)ShedLevel::Count];
+};
+void        shedGetStats(ShedStats &out);
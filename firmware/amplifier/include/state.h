@@ -1,5 +1,6 @@
 #pragma once
 #include <Arduino.h>
+#include "fan_ctrl.h"
 
 // Mode kipas yang dipersist di NVS
 enum class FanMode : uint8_t {
@@ -25,6 +26,18 @@ void     stateSetFanMode(FanMode m);
 uint16_t stateGetFanCustomDuty();            // 0..1023
 void     stateSetFanCustomDuty(uint16_t d);
 
+// Kurva AUTO 2..FAN_CURVE_MAX_POINTS titik; set ditolak (false) bila tidak
+// valid. Rev naik tiap kurva berubah (termasuk load/factory reset); ganjil
+// selama ditulis. Task lain membaca lewat stateSnapshotFanCurve: false bila
+// penulisan sedang/baru berjalan (coba lagi nanti).
+void     stateGetFanCurve(FanCurve &out);
+bool     stateSetFanCurve(const FanCurve &c);
+uint32_t stateFanCurveRev();
+bool     stateSnapshotFanCurve(FanCurve &out, uint32_t &rev);
+
+bool     stateFanPi();                       // koreksi PI di mode AUTO
+void     stateSetFanPi(bool en);
+
 bool     stateSmpsBypass();
 void     stateSetSmpsBypass(bool en);
 
@@ -44,6 +57,50 @@ void     stateSetBtAutoOffMs(uint32_t ms);
 uint32_t stateLastRtcSync();
 void     stateSetLastRtcSync(uint32_t t);
 
+// Etag setting (CRC32 semua setting kecuali rtc_sync). Diperbarui tiap
+// setter yang benar-benar mengubah nilai; isi sama → etag sama.
+uint32_t stateSettingsEtag();
+
+// -------- Write-behind NVS --------
+// Semua setting disimpan sebagai satu blob berversi + CRC (key "cfg").
+// Setter hanya mengubah cache RAM dan menandai key dirty; stateTick()
+// menulis ulang blob sekali setelah periode sepi (NVS_WRITE_DEBOUNCE_MS).
+// Setter dengan nilai sama seperti cache tidak menandai apa pun.
+bool     stateFlush();                       // commit semua key dirty sekarang; false = gagal (tetap dirty)
+bool     stateDirty();
+
+// Batch: setter di antara Begin/End tidak memicu commit di tengah batch
+// (boleh nested). End return = jumlah key dirty baru dari batch.
+void     stateBatchBegin();
+uint8_t  stateBatchEnd();
+
+// Asal setting saat boot
+enum class StateLoadSrc : uint8_t {
+  None     = 0,   // NVS kosong → default
+  Blob     = 1,   // blob versi terkini
+  Migrated = 2,   // blob versi lama, ditulis ulang ke versi terkini
+  Legacy   = 3,   // key per-setting lama, dimigrasi ke blob lalu dihapus
+  Corrupt  = 4    // blob rusak (CRC/magic) → default, blob ditulis ulang
+};
+
+const char* stateLoadSrcToStr(StateLoadSrc src);
+
+struct StateNvsStats {
+  uint32_t setCalls;      // pemanggilan setter
+  uint32_t writes;        // put blob NVS aktual
+  uint32_t avoided;       // setter yang tidak butuh put (nilai sama / digabung)
+  uint32_t flushes;       // commit batch dirty
+  uint32_t flushMaxUs;    // commit terlama (µs)
+  uint32_t writeFails;    // put blob gagal (partisi penuh/aus) → dicoba ulang
+  uint16_t dirtyMask;     // key yang menunggu commit
+  uint32_t loadUs;        // durasi load setting saat boot (µs)
+  StateLoadSrc loadSrc;
+  uint8_t  blobVersion;
+  uint32_t entriesUsed;   // entri NVS terpakai (seluruh partisi)
+  uint32_t entriesFree;
+};
+void     stateGetNvsStats(StateNvsStats &out);
+
 // -------- Runtime flags (tidak dipersist) --------
 bool     powerIsOn();
 bool     powerIsStandby();
@@ -52,5 +109,5 @@ void     powerSetOn(bool on);
 // Safe mode compile-time flag (for diagnostics)
 bool     stateSafeModeSoft();
 
-// Tick ops (placeholder untuk housekeeping NVS)
-void     stateTick();
+// Tick: commit write-behind NVS bila sudah jatuh tempo
+void     stateTick(uint32_t now);
@@ -0,0 +1,38 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Statistik operasi seumur hidup (untuk rencana perawatan). Disimpan di
+// namespace NVS sendiri sehingga TIDAK ikut terhapus factory reset.
+// Akumulasi di RAM; ditulis ke NVS paling sering tiap STATS_SAVE_INTERVAL_MS
+// (hanya bila berubah) + saat shutdown terkendali (statsFlush).
+
+struct LifetimeStats {
+  uint32_t uptimeS;        // total MCU hidup (detik)
+  uint32_t onS;            // total relay utama ON (detik)
+  uint32_t boots;
+  uint32_t relayCycles;    // transisi relay OFF → ON
+  uint32_t smpsTrips;      // cut-off proteksi undervoltage SMPS
+  uint32_t spkFaults;      // fault speaker protector (latched)
+  uint32_t saves;          // jumlah tulis NVS statistik
+  // Histogram waktu (detik per bin). Bin 0 = di bawah MIN, bin terakhir =
+  // di atas rentang; sisanya selebar STEP.
+  uint32_t heatS[STATS_HEAT_BINS];
+  uint32_t voltS[STATS_VOLT_BINS];   // hanya saat relay ON
+  uint32_t fanS[STATS_FAN_BINS];
+};
+
+void statsInit();
+void statsTick(uint32_t now);       // akumulasi waktu + simpan periodik
+// Simpan sekarang bila ada perubahan; force=false menghormati
+// STATS_FLUSH_MIN_GAP_MS (power OFF berulang tidak menguras flash).
+void statsFlush(bool force = true);
+void statsReset();                  // nolkan semua counter (boots ikut nol)
+void statsGet(LifetimeStats &out);
+
+// ---- Feed dari powerTick()/sensorsTick() ----
+void statsOnRelay(bool on);         // dipanggil tiap relay diterapkan
+void statsOnSmpsTrip();
+void statsOnSpkFault();
+void statsOnFanDuty(uint16_t duty); // duty terakhir (0..1023)
+void statsOnSensors1Hz(float heatC, float smpsV);  // satu sampel = 1 detik
@@ -0,0 +1,40 @@
+#pragma once
+#include <Arduino.h>
+
+// Arsitektur task FreeRTOS amplifier.
+//  - Safety   : prioritas tertinggi, periodik SAFETY_PERIOD_MS (vTaskDelayUntil);
+//               ADS/proteksi SMPS & rail, protector speaker, kipas/thermal.
+//               Tidak menyentuh link/log: kejadian dikirim lewat antrean.
+//  - Comms    : loopTask Arduino (appTick): link UART, BT/PC detect, job sched.
+//  - Ui       : OLED + buzzer; perintah buzzer dari task lain lewat antrean.
+//  - Analyzer : I2S + FFT di core terpisah; hasil dipublikasi via spinlock.
+// Semua task terdaftar di task watchdog (TASK_WDT_TIMEOUT_S).
+
+enum class TaskId : uint8_t { Safety = 0, Comms, Ui, Analyzer, Count };
+
+// Buat task safety/ui/analyzer + daftarkan loopTask sebagai comms.
+// Dipanggil paling akhir di appInit (semua modul sudah init).
+void tasksStart();
+bool tasksRunning();
+bool tasksIsCurrent(TaskId id);
+TaskId tasksCurrent();   // Count = ISR / task lain
+
+// Bangunkan task yang menunggu notifikasi (mis. analyzer on/off)
+void tasksNotify(TaskId id);
+
+// Akhir satu iterasi kerja: akumulasi beban (jendela TASK_LOAD_WINDOW_MS)
+// + reset watchdog task pemanggil
+void tasksIterDone(TaskId id, uint32_t busyUs);
+
+struct TaskStats {
+  const char *name;
+  uint8_t  core;
+  uint8_t  prio;
+  uint8_t  loadPct;      // porsi CPU sibuk di jendela terakhir
+  uint32_t stackFree;    // high-water mark (byte)
+  uint32_t maxUs;        // iterasi terlama
+  uint32_t lateMaxUs;    // safety: bangun terlambat dari jadwal
+  uint32_t overruns;     // safety: iterasi > SAFETY_PERIOD_MS
+};
+bool tasksGetStats(TaskId id, TaskStats &out);
+const char* taskName(TaskId id);
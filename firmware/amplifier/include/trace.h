@@ -0,0 +1,92 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// Trace event biner ring RAM (lock-free, dipanggil dari semua task).
+// Record 12 byte: waktu (micros, 32 bit), id event, task penulis, dua argumen.
+// Penulis mengambil slot dengan atomic fetch_add lalu mengisi slot itu; ring
+// berputar (record terlama tertimpa). Saat "trace dump" ring dibekukan
+// (penulis baru dihitung sebagai drop) lalu dikirim chunk base64 oleh comms;
+// tools/trace2chrome.cpp mengubah hasil tangkapan ke JSON Chrome/Perfetto.
+// Header ini juga dipakai tool host (tanpa Arduino).
+
+enum class TraceKind : uint8_t {
+  Instant,   // titik; a/b = argumen
+  Counter,   // nilai a (grafik tangga di timeline)
+  Span,      // durasi b µs berakhir di ts; a = argumen
+};
+
+//  ident          nama          jenis    arti a / b
+#define TRACE_EVENTS(X)                                                          \
+  X(Relay,         "relay",        Counter, "on")                               \
+  X(SmpsTrip,      "smps_trip",    Instant, "a: 0=sw 1=hw 2=rail, b: mV")      \
+  X(SpkProtect,    "spk_ok",       Counter, "LED protector ON")                 \
+  X(BtMode,        "bt_mode",      Counter, "1=BT 0=AUX")                       \
+  X(BtHw,          "bt_hw",        Counter, "modul BT ON")                      \
+  X(FanDuty,       "fan_duty",     Counter, "duty 0..1023")                     \
+  X(Telemetry,     "telemetry",    Instant, "a: mask topik (0xFFFF=penuh)")     \
+  X(TelHeld,       "tel_held",     Instant, "flow control menahan telemetri")   \
+  X(Cmd,           "cmd",          Span,    "a: index CMD_SPECS, b: µs")        \
+  X(OtaBegin,      "ota_begin",    Instant, "b: ukuran")                        \
+  X(OtaWrite,      "ota_write",    Span,    "a: byte, b: µs")                   \
+  X(OtaEnd,        "ota_end",      Instant, "a: 1=ok 0=gagal 2=abort")          \
+  X(Buzz,          "buzz",         Counter, "pola (0=stop, 255=custom)")        \
+  X(Ds18Read,      "ds18_read",    Span,    "a: probe, b: µs")                  \
+  X(Fft,           "fft",          Span,    "b: µs")                            \
+  X(Sqw,           "sqw",          Instant, "a: tepi baru")
+
+#define TRACE_ID_ROW(ident, name, kind, doc) ident,
+enum class TraceEv : uint8_t {
+  TRACE_EVENTS(TRACE_ID_ROW)
+  Count
+};
+#undef TRACE_ID_ROW
+
+struct TraceEvInfo {
+  const char *name;
+  TraceKind   kind;
+};
+
+#define TRACE_INFO_ROW(ident, name, kind, doc) {name, TraceKind::kind},
+inline constexpr TraceEvInfo TRACE_EV_INFO[] = {
+  TRACE_EVENTS(TRACE_INFO_ROW)
+};
+#undef TRACE_INFO_ROW
+
+static_assert(sizeof(TRACE_EV_INFO) / sizeof(TRACE_EV_INFO[0]) == (size_t)TraceEv::Count,
+              "TRACE_EV_INFO harus sejajar dengan TraceEv");
+
+// Layout kabel (little-endian, tanpa padding)
+struct TraceRec {
+  uint32_t tsUs;
+  uint8_t  id;       // TraceEv
+  uint8_t  task;     // TaskId; TRACE_TASK_OTHER = ISR/sebelum task jalan
+  uint16_t a;
+  uint32_t b;
+};
+static_assert(sizeof(TraceRec) == 12, "TraceRec harus 12 byte");
+
+#define TRACE_TASK_OTHER 0xFF
+
+#if TRACE_ENABLE && defined(ARDUINO)
+void traceEmit(TraceEv ev, uint16_t a = 0, uint32_t b = 0);
+// Span: ts = akhir, b = durasi sejak t0Us (micros())
+void traceSpan(TraceEv ev, uint32_t t0Us, uint16_t a = 0);
+#else
+static inline void traceEmit(TraceEv, uint16_t = 0, uint32_t = 0) {}
+static inline void traceSpan(TraceEv, uint32_t, uint16_t = 0) {}
+#endif
+
+// Sisi comms (dump)
+struct TraceStats {
+  uint32_t written;    // total record sejak boot/clear
+  uint32_t drops;      // ditolak saat ring beku
+  uint16_t count;      // record valid di ring
+  bool     frozen;
+};
+void     traceGetStats(TraceStats &out);
+void     traceClear();
+void     traceFreeze(bool frozen);
+// Salin record ke-off .. (urut lama → baru) dari ring beku; return jumlah
+uint16_t traceRead(uint16_t off, TraceRec *out, uint16_t maxN);
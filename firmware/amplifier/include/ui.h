@@ -4,9 +4,21 @@
 // Init OLED & buffer, panggil sekali dari setup()
 void uiInit();
 
-// Tick refresh UI; panggil rutin dari loop()
+// Tick refresh UI; dijalankan task ui tiap UI_FRAME_MS. Retained mode: gambar ulang
+// hanya bila nilai terikat (jam, tegangan, suhu, VU, status) berubah, lalu
+// kirim hanya page SSD1306 yang berubah.
 void uiTick(uint32_t now);
 
+// Statistik trafik I2C OLED (perkiraan byte termasuk overhead perintah)
+struct UiStats {
+  uint32_t bytesPerSec;   // jendela 1 detik terakhir
+  uint32_t bytesTotal;
+  uint32_t redraws;       // gambar ulang karena model berubah
+  uint32_t chunksSent;    // transaksi area OLED (≤ I2C_OLED_CHUNK_TILES tile)
+  uint32_t skipped;       // tick tanpa perubahan
+};
+void uiGetStats(UiStats &out);
+
 // --------- Layar/Scene ---------
 void uiShowSplash(const char* title);                // splash awal
 void uiBootLogLine(const char* label, bool ok);      // baris boot log: OK/FAIL
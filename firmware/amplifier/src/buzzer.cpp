@@ -1,5 +1,7 @@
 #include "buzzer.h"
 #include "config.h"
+#include "tasks.h"
+#include "trace.h"
 
 #include <driver/ledc.h>
 
@@ -77,6 +79,18 @@ static bool                     gOutputActive   = false;
 static bool                     gCustomActive   = false;
 static uint32_t                 gCustomEndMs    = 0;
 
+// Perintah dari task lain → antrean, dieksekusi task ui (pemilik LEDC buzzer)
+enum class BuzzOp : uint8_t { Pattern, Custom, Stop, Enable };
+struct BuzzCmd {
+  BuzzOp   op;
+  uint8_t  arg;        // pattern id / enable
+  uint16_t duty;
+  uint16_t durMs;
+  uint32_t freqHz;
+};
+static QueueHandle_t            sCmdQ           = nullptr;
+static uint32_t                 sCmdDrops       = 0;
+
 static inline uint32_t ms() { return millis(); }
 
 static void buzzerOff() {
@@ -108,16 +122,15 @@ static void startStep(uint32_t now) {
   gOutputActive = true;
 }
 
-void buzzerInit() {
-  ledcSetup(BUZZER_PWM_CH, BUZZER_PWM_BASE_FREQ, BUZZER_PWM_RES_BITS);
-  ledcAttachPin(BUZZER_PIN, BUZZER_PWM_CH);
-  buzzerOff();
-  gCurrent = nullptr;
-  gCustomActive = false;
-  gEnabled = true;
+// Sebelum task ui jalan (boot, factory reset combo) atau dari task ui
+// sendiri, perintah langsung dieksekusi
+static bool buzzPost(const BuzzCmd &c) {
+  if (!sCmdQ || !tasksRunning() || tasksIsCurrent(TaskId::Ui)) return false;
+  if (xQueueSend(sCmdQ, &c, 0) != pdTRUE) ++sCmdDrops;   // membangunkan task ui
+  return true;
 }
 
-void buzzSetEnabled(bool enabled) {
+static void applyEnabled(bool enabled) {
   gEnabled = enabled;
   if (!gEnabled) {
     gCurrent = nullptr;
@@ -126,7 +139,7 @@ void buzzSetEnabled(bool enabled) {
   }
 }
 
-void buzzPattern(BuzzPatternId pattern) {
+static void applyPattern(BuzzPatternId pattern) {
   if (!gEnabled) {
     return;
   }
@@ -146,13 +159,73 @@ void buzzPattern(BuzzPatternId pattern) {
   startStep(gPatternStartMs);
 }
 
-void buzzStop() {
+static void applyStop() {
   gCurrent = nullptr;
   gCustomActive = false;
   buzzerOff();
 }
 
+static void applyCustom(uint32_t freqHz, uint16_t duty, uint16_t msDur) {
+  if (!gEnabled) {
+    return;
+  }
+  if (freqHz == 0 || msDur == 0 || duty == 0) {
+    applyStop();
+    return;
+  }
+  gCurrent = nullptr;
+  gCustomActive = true;
+  gCustomEndMs = ms() + msDur;
+  if (duty > ((1u << BUZZER_PWM_RES_BITS) - 1)) {
+    duty = (1u << BUZZER_PWM_RES_BITS) - 1;
+  }
+  ledcSetup(BUZZER_PWM_CH, freqHz, BUZZER_PWM_RES_BITS);
+  ledcWrite(BUZZER_PWM_CH, duty);
+  gOutputActive = true;
+}
+
+static void applyCmd(const BuzzCmd &c) {
+  if (c.op != BuzzOp::Enable) {
+    uint16_t v = c.op == BuzzOp::Pattern ? c.arg : c.op == BuzzOp::Custom ? 255 : 0;
+    traceEmit(TraceEv::Buzz, v, c.op == BuzzOp::Custom ? c.freqHz : 0);
+  }
+  switch (c.op) {
+    case BuzzOp::Pattern: applyPattern((BuzzPatternId)c.arg); break;
+    case BuzzOp::Custom:  applyCustom(c.freqHz, c.duty, c.durMs); break;
+    case BuzzOp::Stop:    applyStop(); break;
+    case BuzzOp::Enable:  applyEnabled(c.arg != 0); break;
+  }
+}
+
+void buzzerInit() {
+  ledcSetup(BUZZER_PWM_CH, BUZZER_PWM_BASE_FREQ, BUZZER_PWM_RES_BITS);
+  ledcAttachPin(BUZZER_PIN, BUZZER_PWM_CH);
+  buzzerOff();
+  gCurrent = nullptr;
+  gCustomActive = false;
+  gEnabled = true;
+  if (!sCmdQ) sCmdQ = xQueueCreate(BUZZ_QUEUE_LEN, sizeof(BuzzCmd));
+}
+
+void buzzSetEnabled(bool enabled) {
+  BuzzCmd c = { BuzzOp::Enable, (uint8_t)(enabled ? 1 : 0), 0, 0, 0 };
+  if (!buzzPost(c)) applyEnabled(enabled);
+}
+
+void buzzPattern(BuzzPatternId pattern) {
+  BuzzCmd c = { BuzzOp::Pattern, (uint8_t)pattern, 0, 0, 0 };
+  if (!buzzPost(c)) applyPattern(pattern);
+}
+
+void buzzStop() {
+  BuzzCmd c = { BuzzOp::Stop, 0, 0, 0, 0 };
+  if (!buzzPost(c)) applyStop();
+}
+
 void buzzTick(uint32_t now) {
+  // Setelah task ui jalan, hanya task ui yang menyentuh state/LEDC buzzer
+  if (tasksRunning() && !tasksIsCurrent(TaskId::Ui)) return;
+
   if (!gEnabled) {
     buzzerOff();
     return;
@@ -200,23 +273,38 @@ void buzzTick(uint32_t now) {
   }
 }
 
-void buzzerCustom(uint32_t freqHz, uint16_t duty, uint16_t msDur) {
-  if (!gEnabled) {
-    return;
+// Deadline berikut (akhir step, akhir nada kustom, awal siklus ulang)
+uint32_t buzzNextDueMs(uint32_t now) {
+  uint32_t due;
+  if (gCustomActive) {
+    due = gCustomEndMs;
+  } else if (!gCurrent) {
+    return UINT32_MAX;
+  } else if (gStepIndex >= gCurrent->count) {
+    due = gNextCycleMs;
+  } else {
+    due = gStepEndMs;
   }
-  if (freqHz == 0 || msDur == 0 || duty == 0) {
-    buzzStop();
+  int32_t dt = (int32_t)(due - now);
+  return dt > 0 ? (uint32_t)dt : 0;
+}
+
+void buzzWaitCmd(uint32_t maxMs) {
+  if (!sCmdQ) {
+    vTaskDelay(pdMS_TO_TICKS(maxMs));
     return;
   }
-  gCurrent = nullptr;
-  gCustomActive = true;
-  gCustomEndMs = ms() + msDur;
-  if (duty > ((1u << BUZZER_PWM_RES_BITS) - 1)) {
-    duty = (1u << BUZZER_PWM_RES_BITS) - 1;
-  }
-  ledcSetup(BUZZER_PWM_CH, freqHz, BUZZER_PWM_RES_BITS);
-  ledcWrite(BUZZER_PWM_CH, duty);
-  gOutputActive = true;
+  BuzzCmd c;
+  if (xQueueReceive(sCmdQ, &c, pdMS_TO_TICKS(maxMs)) != pdTRUE) return;
+  applyCmd(c);
+  while (xQueueReceive(sCmdQ, &c, 0) == pdTRUE) applyCmd(c);
+}
+
+uint32_t buzzCmdDrops() { return sCmdDrops; }
+
+void buzzerCustom(uint32_t freqHz, uint16_t duty, uint16_t msDur) {
+  BuzzCmd c = { BuzzOp::Custom, 0, duty, msDur, freqHz };
+  if (!buzzPost(c)) applyCustom(freqHz, duty, msDur);
 }
 
 bool buzzerIsActive() {
@@ -1,11 +1,23 @@
 #include "comms.h"
 #include "config.h"
 #include "state.h"
+#include "stats.h"
 #include "power.h"
 #include "sensors.h"
 #include "buzzer.h"
 #include "ota.h"
+#include "ui.h"
+#include "i2c_bus.h"
+#include "gpio_edge.h"
+#include "sched.h"
+#include "tasks.h"
+#include "scope.h"
+#include "perf.h"
+#include "shed.h"
+#include "trace.h"
 #include "main.h"
+#include "cmd_schema.h"
+#include "link_flow.h"
 
 #include <ArduinoJson.h>
 #include <mbedtls/base64.h>
@@ -23,6 +35,30 @@ static HardwareSerial &linkSerial = espSerial;
 
 // -------------------- RX line buffer --------------------
 static String   rxLine;
+
+// Antrean admission: baris lengkap menunggu eksekusi dengan prioritas.
+// Urgent (power:false, ota_abort) selalu dieksekusi & tidak terkena
+// anggaran waktu; low (buzz/sub/diag/cmd_stats) dibatasi ratenya.
+enum RxPrio : uint8_t {
+  RX_PRIO_LOW    = 0,
+  RX_PRIO_NORMAL = 1,
+  RX_PRIO_URGENT = 2
+};
+
+struct RxEntry {
+  String  line;
+  uint8_t prio;
+};
+static RxEntry  sRxQ[LINK_RX_QUEUE_MAX];
+static uint8_t  sRxqCount       = 0;
+static uint8_t  sRxqPeak        = 0;
+static uint32_t sLastLowMs      = 0;
+static bool     sLowSeen        = false;
+static uint32_t sRxUrgent       = 0;
+static uint32_t sRxRateLimited  = 0;
+static uint32_t sRxBusy         = 0;   // ditolak/digusur karena antrean penuh
+static uint32_t sRxByteBudgetHits = 0;
+static uint32_t sRxTimeBudgetHits = 0;
 static uint32_t lastRxBlink = 0;
 static uint32_t lastTxBlink = 0;
 
@@ -42,14 +78,91 @@ static inline void ledActivityTick(uint32_t now) {
   }
 }
 
-template <typename TDoc>
-static void sendDoc(const TDoc &doc) {
-  String out;
-  serializeJson(doc, out);
+// Request ID (opsional) dari baris cmd yang sedang diproses; di-echo ke semua
+// frame balasan (ack/ota/log) selama handler berjalan.
+static bool     sHasReqId = false;
+static uint32_t sReqId    = 0;
+
+// -------------------- Flow control (credit) -------------
+// Lihat link_flow.h. Frame non-telemetri yang tidak dapat kredit ditahan
+// di antrean (urutan dijaga); telemetri tidak pernah diantre — frame yang
+// jatuh tempo saat kredit habis digabung ke frame berikutnya (snapshot).
+static LinkFlow sFlow = {};
+static String   sTxQueue[LINK_TX_QUEUE_MAX];
+static uint8_t  sTxqHead      = 0;
+static uint8_t  sTxqCount     = 0;
+static uint32_t sTxqDrops     = 0;
+static uint32_t sTelCoalesced = 0;
+static bool     sTelHeld      = false;
+
+static constexpr uint32_t LINK_RX_WINDOW = LINK_RX_BUFFER_BYTES - LINK_CREDIT_RESERVE;
+
+static void linkWrite(const String &out) {
   linkSerial.println(out);
+  linkFlowOnSent(sFlow, out.length() + 2);  // println → "\r\n"
   ledTxPulse();
 }
 
+static void flushTxQueue(uint32_t now) {
+  while (sTxqCount > 0) {
+    String &out = sTxQueue[sTxqHead];
+    if (!linkFlowCanSend(sFlow, out.length() + 2, now)) return;
+    linkWrite(out);
+    out = String();
+    sTxqHead = (uint8_t)((sTxqHead + 1) % LINK_TX_QUEUE_MAX);
+    --sTxqCount;
+  }
+}
+
+static void advertiseCredit(uint32_t now) {
+  if (!linkFlowShouldAdvertise(sFlow, LINK_RX_WINDOW, now)) return;
+  char buf[72];
+  snprintf(buf, sizeof(buf), "{\"type\":\"credit\",\"rx\":%lu,\"win\":%lu}",
+           (unsigned long)sFlow.rxBytes, (unsigned long)LINK_RX_WINDOW);
+  linkFlowMarkAdvertised(sFlow, now);
+  linkWrite(String(buf));
+}
+
+// true = telemetri harus ditahan tick ini (kredit/antrean belum lega)
+static bool telemetryHeld(size_t estBytes, uint32_t now) {
+  if (sTxqCount == 0 && linkFlowCanSend(sFlow, estBytes, now)) {
+    sTelHeld = false;
+    return false;
+  }
+  if (!sTelHeld) {
+    sTelHeld = true;
+    ++sTelCoalesced;
+    traceEmit(TraceEv::TelHeld);
+  }
+  return true;
+}
+
+static void sendDoc(JsonObject root) {
+  if (sHasReqId && root["id"].isNull()) {
+    root["id"] = sReqId;
+  }
+  String out;
+  serializeJson(root, out);
+  if (sTxqCount == 0 && linkFlowCanSend(sFlow, out.length() + 2, ms())) {
+    linkWrite(out);
+    return;
+  }
+  if (strcmp(root["type"] | "", "telemetry") == 0) {
+    ++sTelCoalesced;  // estimasi meleset; frame berikutnya membawa snapshot baru
+    return;
+  }
+  ++sFlow.stalls;
+  if (sTxqCount >= LINK_TX_QUEUE_MAX) {
+    // Buang frame tertua agar balasan terbaru tetap sampai
+    sTxQueue[sTxqHead] = String();
+    sTxqHead = (uint8_t)((sTxqHead + 1) % LINK_TX_QUEUE_MAX);
+    --sTxqCount;
+    ++sTxqDrops;
+  }
+  sTxQueue[(sTxqHead + sTxqCount) % LINK_TX_QUEUE_MAX] = out;
+  ++sTxqCount;
+}
+
 static bool equalsIgnoreCase(const char *a, const char *b) {
   if (!a || !b) return false;
   while (*a && *b) {
@@ -80,20 +193,16 @@ static bool variantIsNumber(const JsonVariant &v) {
          v.is<float>() || v.is<double>();
 }
 
-#define HANDLE_IF_PRESENT(key, handler)           \
-  do {                                            \
-    JsonVariant value = cmd[key];                 \
-    if (!value.isNull()) {                        \
-      handler(value);                             \
-    }                                             \
-  } while (0)
-
+// Dari jam software (tanpa I2C); time_ms = milidetik interpolasi dalam detik
 static void writeTimeISO(JsonObject obj) {
   char buf[24];
   if (!sensorsGetTimeISO(buf, sizeof(buf)) || strlen(buf) < 20) {
     snprintf(buf, sizeof(buf), "1970-01-01T00:00:00Z");
   }
   obj["time"] = buf;
+  uint32_t epoch;
+  uint16_t ms;
+  obj["time_ms"] = sensorsGetTime(epoch, ms) ? ms : 0;
 }
 
 static void setFloatOrNull(JsonObject obj, const char *key, float value) {
@@ -104,12 +213,35 @@ static void setFloatOrNull(JsonObject obj, const char *key, float value) {
   }
 }
 
-static void writeNvsSnapshot(JsonObject root) {
-  JsonObject nv = root["nvs"].to<JsonObject>();
+// -------------------- NV sync (etag) --------------------
+// Setelah host menyinkronkan etag (nv_get, atau nv_digest yang tidak
+// stale), telemetri periodik hanya membawa "nv_etag"; blok nvs{} penuh
+// cukup diambil ulang via nv_get saat etag berubah.
+static bool sNvSynced = false;
+
+static void writeEtag(JsonObject obj, const char *key) {
+  char buf[9];
+  snprintf(buf, sizeof(buf), "%08lx", (unsigned long)stateSettingsEtag());
+  obj[key] = buf;
+}
+
+static void writeFanCurve(JsonArray arr) {
+  FanCurve c;
+  stateGetFanCurve(c);
+  for (uint8_t i = 0; i < c.n; ++i) {
+    JsonArray pt = arr.add<JsonArray>();
+    pt.add(c.tC[i]);
+    pt.add(c.duty[i]);
+  }
+}
+
+static void writeNvsFields(JsonObject nv) {
   FanMode mode = stateGetFanMode();
   nv["fan_mode"]     = static_cast<uint8_t>(mode);
   nv["fan_mode_str"] = fanModeToStr(mode);
   nv["fan_duty"]     = stateGetFanCustomDuty();
+  writeFanCurve(nv["fan_curve"].to<JsonArray>());
+  nv["fan_pi"]       = stateFanPi();
   nv["spk_big"]      = stateSpeakerIsBig();
   nv["spk_pwr"]      = stateSpeakerPowerOn();
   nv["bt_en"]        = stateBtEnabled();
@@ -119,6 +251,13 @@ static void writeNvsSnapshot(JsonObject root) {
   nv["smps_rec"]     = stateSmpsRecoveryV();
 }
 
+static void writeNvsSnapshot(JsonObject root) {
+  writeEtag(root, "nv_etag");
+  if (!sNvSynced) {
+    writeNvsFields(root["nvs"].to<JsonObject>());
+  }
+}
+
 static void writeFeatures(JsonObject root) {
   JsonObject feats = root["features"].to<JsonObject>();
   feats["pc_detect"]        = static_cast<bool>(FEAT_PC_DETECT_ENABLE);
@@ -135,19 +274,53 @@ static void writeFeatures(JsonObject root) {
 
 static void writeErrors(JsonArray arr) {
   float v = getVoltageInstant();
-  if (!stateSmpsBypass()) {
+  bool adsOnline = i2cBusDevOnline(I2cDev::Ads);
+  // ADS offline → tegangan 0 bukan berarti NO_POWER; laporkan I2C_ADS_FAIL
+  if (!stateSmpsBypass() && adsOnline) {
     if (v == 0.0f) {
       arr.add("NO_POWER");
     } else if (v < stateSmpsCutoffV()) {
       arr.add("LOW_VOLTAGE");
     }
   }
-  if (isnan(getHeatsinkC())) {
+  if (sensorsTempFault()) {
     arr.add("SENSOR_FAIL");
   }
   if (powerSpkProtectFault()) {
     arr.add("SPEAKER_PROTECT_FAIL");
   }
+  if (powerRailFaultMask() != 0) {
+    arr.add("RAIL_FAULT");
+  }
+  if (!i2cBusDevOnline(I2cDev::Rtc)) {
+    arr.add("I2C_RTC_FAIL");
+  }
+  if (!adsOnline) {
+    arr.add("I2C_ADS_FAIL");
+  }
+  if (!i2cBusDevOnline(I2cDev::Oled)) {
+    arr.add("I2C_OLED_FAIL");
+  }
+}
+
+// Suhu DS18B20 per slot (urutan DS18B20_NAMES); null = kosong/gagal
+static void writeTemps(JsonObject data) {
+  JsonArray temps = data["temps"].to<JsonArray>();
+  for (uint8_t i = 0; i < sensorsTempCount(); ++i) {
+    float t = sensorsTempC(i);
+    if (std::isnan(t)) temps.add(nullptr);
+    else temps.add(t);
+  }
+}
+
+// Rail ADS ringkas: [smps_v, neg_v, aux12_v, shunt_a]; null = nonaktif/belum ada
+static void writeRails(JsonObject data) {
+  JsonArray rails = data["rails"].to<JsonArray>();
+  for (uint8_t ch = 0; ch < ADS_NUM_CH; ++ch) {
+    float v = sensorsAdsChValue(ch);
+    if (std::isnan(v)) rails.add(nullptr);
+    else               rails.add(std::round(v * 100.0f) / 100.0f);
+  }
 }
 
 static void writeAnalyzer(JsonObject data) {
@@ -175,7 +348,9 @@ static void sendTelemetry() {
   data["ota_ready"] = otaReady;
 
   data["smps_v"] = getVoltageInstant();
+  writeRails(data);
   setFloatOrNull(data, "heat_c", getHeatsinkC());
+  writeTemps(data);
   setFloatOrNull(data, "rtc_c", sensorsGetRtcTempC());
 
   JsonObject inputs = data["inputs"].to<JsonObject>();
@@ -196,7 +371,357 @@ static void sendTelemetry() {
   sendDoc(root);
 }
 
-template <typename TValue>
+// -------------------- Batch context ---------------------
+// Selama batch aktif, sendAckOk/sendAckErr tidak mengirim frame; hasil per
+// key dicatat ke results dan nada ACK dibunyikan sekali di akhir batch.
+struct CmdBatch {
+  JsonObject results;
+  bool       failed;
+  float      pendingCut;  // NAN bila smps_cut tidak ada di batch
+  float      pendingRec;  // NAN bila smps_rec tidak ada di batch
+};
+static CmdBatch *sBatch = nullptr;
+
+static float effectiveSmpsCut() {
+  return (sBatch && !std::isnan(sBatch->pendingCut)) ? sBatch->pendingCut : stateSmpsCutoffV();
+}
+
+static float effectiveSmpsRec() {
+  return (sBatch && !std::isnan(sBatch->pendingRec)) ? sBatch->pendingRec : stateSmpsRecoveryV();
+}
+
+// Counter diagnostik (topik "diag" & command "diag")
+// Min/avg/max tegangan SMPS di jendela SCOPE_STATS_WINDOW_MS terakhir
+static void writeScopeRun(JsonObject obj) {
+  ScopeRunStats rs;
+  scopeGetRunStats(rs);
+  JsonObject run = obj["run"].to<JsonObject>();
+  run["sps"] = rs.samples * 1000UL / SCOPE_STATS_WINDOW_MS;
+  if (rs.samples == 0) return;
+  run["min_v"] = sensorsAdsCodeToVolt(rs.minCode);
+  run["avg_v"] = sensorsAdsCodeToVolt((int16_t)rs.avgCode);
+  run["max_v"] = sensorsAdsCodeToVolt(rs.maxCode);
+}
+
+static void writeDiag(JsonObject diag) {
+  JsonObject link = diag["link"].to<JsonObject>();
+  link["fc"]            = sFlow.enabled;
+  link["inflight"]      = linkFlowInflight(sFlow);
+  link["panel_win"]     = sFlow.peerWin;
+  link["tx_bytes"]      = sFlow.txBytes;
+  link["rx_bytes"]      = sFlow.rxBytes;
+  link["stalls"]        = sFlow.stalls;
+  link["resyncs"]       = sFlow.resyncs;
+  link["credits"]       = sFlow.credits;
+  link["txq"]           = sTxqCount;
+  link["txq_drops"]     = sTxqDrops;
+  link["tel_coalesced"] = sTelCoalesced;
+
+  JsonObject rx = diag["rx"].to<JsonObject>();
+  rx["q"]                = sRxqCount;
+  rx["q_peak"]           = sRxqPeak;
+  rx["urgent"]           = sRxUrgent;
+  rx["rate_limited"]     = sRxRateLimited;
+  rx["busy"]             = sRxBusy;
+  rx["byte_budget_hits"] = sRxByteBudgetHits;
+  rx["time_budget_hits"] = sRxTimeBudgetHits;
+
+  StateNvsStats nvs;
+  stateGetNvsStats(nvs);
+  JsonObject nv = diag["nvs"].to<JsonObject>();
+  nv["set_calls"]    = nvs.setCalls;
+  nv["writes"]       = nvs.writes;
+  nv["avoided"]      = nvs.avoided;
+  nv["flushes"]      = nvs.flushes;
+  nv["flush_max_us"] = nvs.flushMaxUs;
+  nv["write_fails"]  = nvs.writeFails;
+  nv["dirty"]        = nvs.dirtyMask;
+  nv["load_us"]      = nvs.loadUs;
+  nv["load_src"]     = stateLoadSrcToStr(nvs.loadSrc);
+  nv["blob_ver"]     = nvs.blobVersion;
+  nv["entries_used"] = nvs.entriesUsed;
+  nv["entries_free"] = nvs.entriesFree;
+
+  I2cBusStats bus;
+  i2cBusGetStats(bus);
+  JsonObject i2c = diag["i2c"].to<JsonObject>();
+  i2c["clk_hz"]      = bus.clockHz;
+  i2c["util_pct"]    = bus.utilPct;
+  i2c["q"]           = bus.queue;
+  i2c["q_peak"]      = bus.queuePeak;
+  i2c["drops"]       = bus.drops;
+  i2c["deferred"]    = bus.deferred;
+  i2c["budget_hits"] = bus.budgetHits;
+  i2c["recoveries"]  = bus.recoveries;
+  i2c["lock_to"]     = bus.lockTimeouts;
+  for (uint8_t d = 0; d < (uint8_t)I2cDev::Count; ++d) {
+    const I2cDevStats &ds = bus.dev[d];
+    JsonObject o = i2c[i2cDevName((I2cDev)d)].to<JsonObject>();
+    o["jobs"]       = ds.jobs;
+    o["fails"]      = ds.fails;
+    o["bytes"]      = ds.bytes;
+    o["busy_us"]    = ds.busyUs;
+    o["lat_avg_us"] = ds.latAvgUs;
+    o["lat_max_us"] = ds.latMaxUs;
+    o["online"]     = ds.online;
+    o["backoff_ms"] = ds.backoffMs;
+    o["skipped"]    = ds.skipped;
+    o["offline_n"]  = ds.offlineCount;
+  }
+
+  SmpsTripStats trip;
+  powerGetSmpsTripStats(trip);
+  JsonObject tr = diag["smps_trip"].to<JsonObject>();
+  tr["hw"]         = trip.hwEnabled;
+  tr["armed"]      = trip.armed;
+  tr["hw_trips"]   = trip.hwTrips;
+  tr["sw_trips"]   = trip.swTrips;
+  tr["lat_us"]     = trip.latLastUs;
+  tr["lat_max_us"] = trip.latMaxUs;
+  tr["ack_max_us"] = trip.ackMaxUs;
+
+  RtcClockStats clk;
+  sensorsGetClockStats(clk);
+  JsonObject ck = diag["clock"].to<JsonObject>();
+  ck["valid"]     = clk.valid;
+  ck["sqw_ok"]    = clk.sqwOk;
+  ck["edges"]     = clk.edges;
+  ck["rtc_reads"] = clk.rtcReads;
+  ck["sqw_lost"]  = clk.sqwLost;
+  ck["step_s"]    = clk.lastStepS;
+
+  AdsSeqStats adsSt;
+  sensorsGetAdsStats(adsSt);
+  JsonObject ad = diag["ads"].to<JsonObject>();
+  ad["bus_us_s"]  = adsSt.busUsPerS;
+  ad["budget_us"] = adsSt.budgetUs;
+  ad["deferred"]  = adsSt.deferred;
+  ad["rail_fault"] = powerRailFaultMask();
+  JsonObject adn = ad["n"].to<JsonObject>();
+  for (uint8_t ch = 0; ch < ADS_NUM_CH; ++ch) adn[sensorsAdsChName(ch)] = adsSt.samples[ch];
+
+  FanStats fan;
+  powerGetFanStats(fan);
+  JsonObject fa = diag["fan"].to<JsonObject>();
+  fa["duty"]    = fan.duty;
+  fa["writes"]  = fan.writes;
+  fa["pi"]      = fan.pi;
+  setFloatOrNull(fa, "t_eff_c", fan.tEffC);
+  fa["integ"]   = fan.integ;
+  fa["lut_min"] = fan.lutMin;
+  fa["lut_max"] = fan.lutMax;
+  fa["hot"]     = fan.hot;
+
+  GpioEdgeStats ge;
+  gpioEdgeGetStats(ge);
+  JsonObject gp = diag["gpio"].to<JsonObject>();
+  JsonObject gpe = gp["edges"].to<JsonObject>();
+  for (uint8_t i = 0; i < (uint8_t)EdgeSrc::Count; ++i) gpe[gpioEdgeName((EdgeSrc)i)] = ge.edges[i];
+  gp["dupes"]      = ge.dupes;
+  gp["overflows"]  = ge.overflows;
+  gp["q_peak"]     = ge.queuePeak;
+  gp["lag_max_us"] = ge.lagMaxUs;
+
+  DsTempStats ds;
+  sensorsGetTempStats(ds);
+  JsonObject dt = diag["ds18"].to<JsonObject>();
+  dt["found"]       = ds.found;
+  dt["known"]       = ds.known;
+  dt["conv_ms"]     = ds.convMs;
+  dt["crc_err"]     = ds.crcErrors;
+  dt["miss"]        = ds.misses;
+  dt["read_us_max"] = ds.readUsMax;
+  JsonObject rom = dt["rom"].to<JsonObject>();
+  for (uint8_t i = 0; i < sensorsTempCount(); ++i) {
+    char hex[17];
+    if (sensorsTempRom(i, hex, sizeof(hex))) rom[sensorsTempName(i)] = hex;
+  }
+
+  JsonObject sc = diag["scope"].to<JsonObject>();
+  sc["state"] = scopeStateToStr(scopeState());
+  writeScopeRun(sc);
+
+  UiStats uis;
+  uiGetStats(uis);
+  JsonObject ui = diag["ui"].to<JsonObject>();
+  ui["bps"]     = uis.bytesPerSec;
+  ui["bytes"]   = uis.bytesTotal;
+  ui["redraws"] = uis.redraws;
+  ui["chunks"]  = uis.chunksSent;
+  ui["skipped"] = uis.skipped;
+
+  SchedStats ss;
+  schedGetStats(ss);
+  JsonObject sd = diag["sched"].to<JsonObject>();
+  sd["loops_s"]   = ss.loopsPerS;
+  sd["sleep_pct"] = ss.sleepPct;
+  sd["isr_wakes"] = ss.isrWakes;
+  JsonObject sj = sd["jobs"].to<JsonObject>();
+  for (uint8_t i = 0; i < ss.jobs; ++i) {
+    SchedJobStats js;
+    if (!schedGetJobStats(i, js)) break;
+    JsonObject j = sj[js.name].to<JsonObject>();
+    j["period_ms"] = js.periodMs;
+    j["runs"]      = js.runs;
+    j["late"]      = js.late;
+    j["late_max_ms"] = js.lateMaxMs;
+    j["skipped"]   = js.skipped;
+    j["overruns"]  = js.overruns;
+    j["max_us"]    = js.maxUs;
+    j["budget_us"] = js.budgetUs;
+  }
+
+  JsonObject tk = diag["tasks"].to<JsonObject>();
+  for (uint8_t i = 0; i < (uint8_t)TaskId::Count; ++i) {
+    TaskStats ts;
+    if (!tasksGetStats((TaskId)i, ts)) break;
+    JsonObject t = tk[ts.name].to<JsonObject>();
+    t["core"]       = ts.core;
+    t["prio"]       = ts.prio;
+    t["load_pct"]   = ts.loadPct;
+    t["stack_free"] = ts.stackFree;
+    t["max_us"]     = ts.maxUs;
+    if ((TaskId)i == TaskId::Safety) {
+      t["late_max_us"] = ts.lateMaxUs;
+      t["overruns"]    = ts.overruns;
+    }
+  }
+  tk["safety_evt_drops"] = powerSafetyEvtDrops();
+  tk["buzz_drops"]       = buzzCmdDrops();
+
+  ShedStats sh;
+  shedGetStats(sh);
+  JsonObject sl = diag["shed"].to<JsonObject>();
+  sl["level"]       = shedLevelName(sh.level);
+  sl["budget_us"]   = sh.budgetUs;
+  sl["overruns"]    = sh.overruns;
+  sl["excused"]     = sh.excused;
+  sl["iter_max_us"] = sh.iterMaxUs;
+  for (uint8_t i = 1; i < (uint8_t)ShedLevel::Count; ++i) {
+    JsonObject o = sl[shedLevelName((ShedLevel)i)].to<JsonObject>();
+    o["enter"] = sh.enters[i];
+    o["exit"]  = sh.exits[i];
+  }
+
+  TraceStats trs;
+  traceGetStats(trs);
+  JsonObject tc = diag["trace"].to<JsonObject>();
+  tc["n"]       = trs.count;
+  tc["written"] = trs.written;
+  tc["drops"]   = trs.drops;
+}
+
+// -------------------- Telemetry topics ------------------
+// Satu jadwal per topik; hz = 0 berarti tidak berlangganan.
+enum TelTopic : uint8_t {
+  TOPIC_POWER = 0,
+  TOPIC_THERMAL,
+  TOPIC_ANALYZER,
+  TOPIC_NVS,
+  TOPIC_ERRORS,
+  TOPIC_FEATURES,
+  TOPIC_DIAG,
+  TOPIC_COUNT
+};
+
+static const char *const TOPIC_NAMES[TOPIC_COUNT] = {
+  "power", "thermal", "analyzer", "nvs", "errors", "features", "diag"
+};
+
+struct TopicSub {
+  uint16_t hz;
+  uint32_t lastMs;
+};
+static TopicSub sTopics[TOPIC_COUNT];
+static uint8_t  sSubMask = 0;   // bit per topik yang aktif
+
+static int topicFind(const char *name) {
+  for (int i = 0; i < TOPIC_COUNT; ++i) {
+    if (equalsIgnoreCase(name, TOPIC_NAMES[i])) return i;
+  }
+  return -1;
+}
+
+static void writeTopic(JsonObject data, uint8_t topic) {
+  switch (topic) {
+    case TOPIC_POWER: {
+      writeTimeISO(data);
+      data["ota_ready"] = otaReady;
+      data["smps_v"]    = getVoltageInstant();
+      writeRails(data);
+      JsonObject inputs = data["inputs"].to<JsonObject>();
+      inputs["bt"]      = powerBtMode();
+      inputs["speaker"] = powerGetSpeakerSelectBig() ? "big" : "small";
+      JsonObject states = data["states"].to<JsonObject>();
+      states["on"]      = powerIsOn();
+      states["standby"] = powerIsStandby();
+      break;
+    }
+    case TOPIC_THERMAL:
+      setFloatOrNull(data, "heat_c", getHeatsinkC());
+      writeTemps(data);
+      setFloatOrNull(data, "rtc_c", sensorsGetRtcTempC());
+      break;
+    case TOPIC_ANALYZER:
+      writeAnalyzer(data);
+      break;
+    case TOPIC_NVS:
+      writeNvsSnapshot(data);
+      break;
+    case TOPIC_ERRORS:
+      writeErrors(data["errors"].to<JsonArray>());
+      break;
+    case TOPIC_FEATURES:
+      data["fw_ver"] = FW_VERSION;
+      writeFeatures(data);
+      break;
+    case TOPIC_DIAG:
+      writeDiag(data["diag"].to<JsonObject>());
+      break;
+    default:
+      break;
+  }
+}
+
+// Kirim satu frame parsial berisi topik pada mask; return false bila kosong
+static bool sendTelemetryTopics(uint8_t mask) {
+  if (mask == 0) return false;
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["ver"]     = "1";
+  root["type"]    = "telemetry";
+  root["partial"] = true;
+  JsonObject data = root["data"].to<JsonObject>();
+  for (uint8_t t = 0; t < TOPIC_COUNT; ++t) {
+    if (mask & (1u << t)) writeTopic(data, t);
+  }
+  sendDoc(root);
+  return true;
+}
+
+// Topik yang jatuh tempo pada tick ini (force → semua yang dilanggan).
+// Load shedding level telemetri: periode tiap topik minimal satu keyframe.
+static uint8_t topicsDue(uint32_t now, bool force) {
+  bool keyframe = shedLevel() >= ShedLevel::Telemetry;
+  uint8_t due = 0;
+  for (uint8_t t = 0; t < TOPIC_COUNT; ++t) {
+    const TopicSub &sub = sTopics[t];
+    if (sub.hz == 0) continue;
+    uint32_t period = 1000UL / sub.hz;
+    if (keyframe && period < SHED_TEL_KEYFRAME_MS) period = SHED_TEL_KEYFRAME_MS;
+    if (force || now - sub.lastMs >= period) {
+      due |= (uint8_t)(1u << t);
+    }
+  }
+  return due;
+}
+
+static void topicsMarkSent(uint8_t mask, uint32_t now) {
+  for (uint8_t t = 0; t < TOPIC_COUNT; ++t) {
+    if (mask & (1u << t)) sTopics[t].lastMs = now;
+  }
+}
+
 static void playAckTone() {
   if (!powerSpkProtectFault() && !stateSafeModeSoft()) {
     buzzPattern(BuzzPatternId::ACK);
@@ -205,6 +730,12 @@ static void playAckTone() {
 
 template <typename TValue>
 static void sendAckOk(const char *key, const TValue &value, bool tone = true) {
+  if (sBatch) {
+    JsonObject r = sBatch->results[key].to<JsonObject>();
+    r["ok"]    = true;
+    r["value"] = value;
+    return;
+  }
   JsonDocument doc;
   JsonObject root = doc.to<JsonObject>();
   root["type"]    = "ack";
@@ -218,6 +749,13 @@ static void sendAckOk(const char *key, const TValue &value, bool tone = true) {
 }
 
 static void sendAckErr(const char *key, const char *reason) {
+  if (sBatch && key) {
+    JsonObject r = sBatch->results[key].to<JsonObject>();
+    r["ok"]    = false;
+    r["error"] = reason ? reason : "invalid";
+    sBatch->failed = true;
+    return;
+  }
   JsonDocument doc;
   JsonObject root = doc.to<JsonObject>();
   root["type"]  = "ack";
@@ -411,23 +949,16 @@ static void handleRtcSync(uint32_t targetEpoch) {
 }
 
 // -------------------- Command handlers ------------------
+// Tipe & rentang nilai sudah dicek dispatcher (cmdValidateArg) sesuai
+// cmd_schema.h; handler hanya menangani aturan lintas-field & aksi.
 static void handleCmdPower(JsonVariant v) {
-  if (!v.is<bool>()) {
-    sendAckErr("power", "invalid");
-    return;
-  }
   bool on = v.as<bool>();
   powerSetMainRelay(on);
-  if (on) buzzerClick();
   sendAckOk("power", on);
   forceTel = true;
 }
 
 static void handleCmdBt(JsonVariant v) {
-  if (!v.is<bool>()) {
-    sendAckErr("bt", "invalid");
-    return;
-  }
   bool en = v.as<bool>();
   powerSetBtEnabled(en);
   sendAckOk("bt", en);
@@ -435,30 +966,13 @@ static void handleCmdBt(JsonVariant v) {
 }
 
 static void handleCmdSpkSel(JsonVariant v) {
-  if (!v.is<const char*>()) {
-    sendAckErr("spk_sel", "invalid");
-    return;
-  }
-  const char *s = v.as<const char*>();
-  bool big;
-  if (equalsIgnoreCase(s, "big")) {
-    big = true;
-  } else if (equalsIgnoreCase(s, "small")) {
-    big = false;
-  } else {
-    sendAckErr("spk_sel", "invalid");
-    return;
-  }
+  bool big = equalsIgnoreCase(v.as<const char*>(), "big");
   powerSetSpeakerSelect(big);
   sendAckOk("spk_sel", big ? "big" : "small");
   forceTel = true;
 }
 
 static void handleCmdSpkPwr(JsonVariant v) {
-  if (!v.is<bool>()) {
-    sendAckErr("spk_pwr", "invalid");
-    return;
-  }
   bool on = v.as<bool>();
   powerSetSpeakerPower(on);
   sendAckOk("spk_pwr", on);
@@ -466,10 +980,6 @@ static void handleCmdSpkPwr(JsonVariant v) {
 }
 
 static void handleCmdSmpsBypass(JsonVariant v) {
-  if (!v.is<bool>()) {
-    sendAckErr("smps_bypass", "invalid");
-    return;
-  }
   bool en = v.as<bool>();
   stateSetSmpsBypass(en);
   sendAckOk("smps_bypass", en);
@@ -477,12 +987,8 @@ static void handleCmdSmpsBypass(JsonVariant v) {
 }
 
 static void handleCmdSmpsCut(JsonVariant v) {
-  if (!variantIsNumber(v)) {
-    sendAckErr("smps_cut", "invalid");
-    return;
-  }
   float cut = v.as<float>();
-  if (cut < 30.0f || cut > 70.0f || cut >= stateSmpsRecoveryV()) {
+  if (cut >= effectiveSmpsRec()) {
     sendAckErr("smps_cut", "range");
     return;
   }
@@ -492,12 +998,8 @@ static void handleCmdSmpsCut(JsonVariant v) {
 }
 
 static void handleCmdSmpsRec(JsonVariant v) {
-  if (!variantIsNumber(v)) {
-    sendAckErr("smps_rec", "invalid");
-    return;
-  }
   float rec = v.as<float>();
-  if (rec < 30.0f || rec > 80.0f || rec <= stateSmpsCutoffV()) {
+  if (rec <= effectiveSmpsCut()) {
     sendAckErr("smps_rec", "range");
     return;
   }
@@ -507,26 +1009,13 @@ static void handleCmdSmpsRec(JsonVariant v) {
 }
 
 static void handleCmdBtAutoOff(JsonVariant v) {
-  if (!variantIsNumber(v)) {
-    sendAckErr("bt_autooff", "invalid");
-    return;
-  }
-  double valD = v.as<double>();
-  if (valD < 0.0 || valD > 3600000.0) {
-    sendAckErr("bt_autooff", "range");
-    return;
-  }
-  uint32_t val = (uint32_t)(valD + 0.5);
+  uint32_t val = (uint32_t)(v.as<double>() + 0.5);
   stateSetBtAutoOffMs(val);
   sendAckOk("bt_autooff", val);
   forceTel = true;
 }
 
 static void handleCmdFanMode(JsonVariant v) {
-  if (!v.is<const char*>()) {
-    sendAckErr("fan_mode", "invalid");
-    return;
-  }
   FanMode mode;
   if (!fanModeFromStr(v.as<const char*>(), mode)) {
     sendAckErr("fan_mode", "invalid");
@@ -537,26 +1026,48 @@ static void handleCmdFanMode(JsonVariant v) {
   forceTel = true;
 }
 
-static void handleCmdFanDuty(JsonVariant v) {
-  if (!variantIsNumber(v)) {
-    sendAckErr("fan_duty", "invalid");
-    return;
+// [[t_c,duty],..] naik ketat menurut suhu, 2..FAN_CURVE_MAX_POINTS titik
+static bool parseFanCurve(JsonVariant v, FanCurve &out) {
+  memset(&out, 0, sizeof(out));
+  JsonArray pts = v.as<JsonArray>();
+  if (pts.isNull() || pts.size() > FAN_CURVE_MAX_POINTS) return false;
+  for (JsonArray pt : pts) {
+    if (pt.size() != 2 || !pt[0].is<int>() || !pt[1].is<int>()) return false;
+    int t = pt[0].as<int>();
+    int d = pt[1].as<int>();
+    if (t < 0 || t >= FAN_LUT_SIZE || d < 0 || d > 1023) return false;
+    out.tC[out.n]   = (uint8_t)t;
+    out.duty[out.n] = (uint16_t)d;
+    ++out.n;
   }
-  int duty = (int)std::lround(v.as<double>());
-  if (duty < 0 || duty > 1023) {
-    sendAckErr("fan_duty", "range");
+  return fanCurveValid(out);
+}
+
+static void handleCmdFanCurve(JsonVariant v) {
+  FanCurve c;
+  if (!parseFanCurve(v, c) || !stateSetFanCurve(c)) {
+    sendAckErr("fan_curve", "invalid");
     return;
   }
+  sendAckOk("fan_curve", v);
+  forceTel = true;
+}
+
+static void handleCmdFanPi(JsonVariant v) {
+  bool en = v.as<bool>();
+  stateSetFanPi(en);
+  sendAckOk("fan_pi", en);
+  forceTel = true;
+}
+
+static void handleCmdFanDuty(JsonVariant v) {
+  int duty = (int)std::lround(v.as<double>());
   stateSetFanCustomDuty((uint16_t)duty);
   sendAckOk("fan_duty", duty);
   forceTel = true;
 }
 
 static void handleCmdRtcSet(JsonVariant v) {
-  if (!v.is<const char*>()) {
-    sendAckErr("rtc_set", "invalid");
-    return;
-  }
   uint32_t epoch = 0;
   if (!parseIso8601ToEpoch(v.as<const char*>(), epoch)) {
     sendAckErr("rtc_set", "invalid");
@@ -566,10 +1077,6 @@ static void handleCmdRtcSet(JsonVariant v) {
 }
 
 static void handleCmdRtcSetEpoch(JsonVariant v) {
-  if (!variantIsNumber(v)) {
-    sendAckErr("rtc_set_epoch", "invalid");
-    return;
-  }
   uint32_t epoch = v.as<uint32_t>();
   handleRtcSync(epoch);
 }
@@ -587,11 +1094,7 @@ static void handleCmdBuzz(JsonVariant v) {
   sendAckOk("buzz", true, false);
 }
 
-static void handleCmdNvsReset(JsonVariant v) {
-  if (!v.is<bool>() || !v.as<bool>()) {
-    sendAckErr("nvs_reset", "invalid");
-    return;
-  }
+static void handleCmdNvsReset(JsonVariant) {
   stateFactoryReset();
   powerSetSpeakerSelect(stateSpeakerIsBig());
   powerSetSpeakerPower(stateSpeakerPowerOn());
@@ -600,11 +1103,7 @@ static void handleCmdNvsReset(JsonVariant v) {
   forceTel = true;
 }
 
-static void handleCmdFactoryReset(JsonVariant v) {
-  if (!v.is<bool>() || !v.as<bool>()) {
-    sendAckErr("factory_reset", "invalid");
-    return;
-  }
+static void handleCmdFactoryReset(JsonVariant) {
   if (powerIsOn()) {
     sendAckErr("factory_reset", "system_active");
     return;
@@ -631,6 +1130,8 @@ static void handleCmdOtaBegin(JsonVariant v) {
       return;
     }
   }
+  stateFlush();  // commit setting tertunda sebelum flash sibuk untuk OTA
+  statsFlush();
   if (!otaBegin(size, crc)) {
     const char *err = otaLastError();
     sendOtaEvent("begin_err", "err", err);
@@ -667,7 +1168,11 @@ static void handleCmdOtaWrite(JsonVariant v) {
     sendOtaError("b64_decode");
     return;
   }
-  int wrote = otaWrite(decoded.data(), outLen);
+  int wrote;
+  {
+    PERF_SCOPE(OtaWrite);
+    wrote = otaWrite(decoded.data(), outLen);
+  }
   if (wrote < 0) {
     const char *err = otaLastError();
     sendOtaWriteErr(seq, err);
@@ -711,65 +1216,912 @@ static void handleCmdOtaAbort(JsonVariant v) {
   forceTel = true;
 }
 
+// {"sub":{"analyzer":30,"thermal":1}} → set rate per topik (0 = berhenti);
+// {"sub":false} → hapus semua langganan (kembali ke frame monolitik).
+// Topik tak dikenal diabaikan; rate dibatasi TELEMETRY_TOPIC_MAX_HZ.
+static void handleCmdSubscribe(JsonVariant v) {
+  if (v.is<bool>() && !v.as<bool>()) {
+    memset(sTopics, 0, sizeof(sTopics));
+    sSubMask = 0;
+    sendAckOk("sub", false, false);
+    forceTel = true;
+    return;
+  }
+  if (!v.is<JsonObject>()) {
+    sendAckErr("sub", "invalid");
+    return;
+  }
+  for (JsonPair kv : v.as<JsonObject>()) {
+    int t = topicFind(kv.key().c_str());
+    if (t < 0 || !variantIsNumber(kv.value())) continue;
+    double hz = kv.value().as<double>();
+    if (hz < 0) hz = 0;
+    if (hz > TELEMETRY_TOPIC_MAX_HZ) hz = TELEMETRY_TOPIC_MAX_HZ;
+    sTopics[t].hz = (uint16_t)std::lround(hz);
+    sTopics[t].lastMs = 0;
+    if (sTopics[t].hz > 0) sSubMask |= (uint8_t)(1u << t);
+    else                   sSubMask &= (uint8_t)~(1u << t);
+  }
+  JsonDocument tmp;
+  JsonObject val = tmp.to<JsonObject>();
+  for (uint8_t t = 0; t < TOPIC_COUNT; ++t) {
+    if (sTopics[t].hz > 0) val[TOPIC_NAMES[t]] = sTopics[t].hz;
+  }
+  sendAckOk("sub", val, false);
+  forceTel = true;
+}
+
+// Balasan diag juga membawa puncak jarak proteksi SMPS sejak diag terakhir
+// (dibaca lalu di-reset, sehingga host bisa mengukur per sesi uji).
+static void handleCmdDiag(JsonVariant) {
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"] = "diag";
+  writeDiag(root);
+  root["loop"]["prot_gap_max_us"] = powerProtectMaxGapUs(true);
+  sendDoc(root);
+}
+
+static void sendNvDigest(bool stale) {
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"]  = "nv_digest";
+  writeEtag(root, "etag");
+  root["stale"] = stale;
+  sendDoc(root);
+}
+
+// {"nv_digest":"<etag cache host>"} → stale bila beda dengan etag kini;
+// {"nv_digest":true} → host belum punya cache, selalu stale.
+static void handleCmdNvDigest(JsonVariant v) {
+  if (!v.is<const char*>() && !(v.is<bool>() && v.as<bool>())) {
+    sendAckErr("nv_digest", "invalid");
+    return;
+  }
+  uint32_t hostEtag = 0;
+  bool stale = !(v.is<const char*>() && parseHex32(v.as<const char*>(), hostEtag) &&
+                 hostEtag == stateSettingsEtag());
+  if (!stale) sNvSynced = true;
+  sendNvDigest(stale);
+}
+
+static void sendNvGet() {
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"] = "nv_get";
+  writeEtag(root, "etag");
+  writeNvsFields(root["payload"].to<JsonObject>());
+  sendDoc(root);
+  sNvSynced = true;
+}
+
+static void handleCmdNvGet(JsonVariant) {
+  sendNvGet();
+}
+
+static void writeHist(JsonObject out, const char *key, float minV, float step,
+                      const uint32_t *bins, uint8_t n) {
+  JsonObject h = out[key].to<JsonObject>();
+  h["min"]  = minV;
+  h["step"] = step;
+  JsonArray s = h["s"].to<JsonArray>();
+  for (uint8_t i = 0; i < n; ++i) s.add(bins[i]);
+}
+
+// {"stats":"show"} → frame {"type":"stats",...}; "reset" hanya saat standby.
+// Tidak pernah masuk telemetri periodik.
+static void handleCmdLifeStats(JsonVariant v) {
+  // Enum divalidasi case-insensitive (cmdSchemaEnumHas) → bandingkan sama
+  if (strcasecmp(v.as<const char*>(), "reset") == 0) {
+    if (powerIsOn()) {
+      sendAckErr("stats", "system_active");
+      return;
+    }
+    statsReset();
+  }
+  LifetimeStats st;
+  statsGet(st);
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"]         = "stats";
+  root["uptime_s"]     = st.uptimeS;
+  root["on_s"]         = st.onS;
+  root["boots"]        = st.boots;
+  root["relay_cycles"] = st.relayCycles;
+  root["smps_trips"]   = st.smpsTrips;
+  root["spk_faults"]   = st.spkFaults;
+  root["saves"]        = st.saves;
+  JsonObject hist = root["hist"].to<JsonObject>();
+  writeHist(hist, "heat_c", STATS_HEAT_MIN_C, STATS_HEAT_STEP_C, st.heatS, STATS_HEAT_BINS);
+  writeHist(hist, "smps_v", STATS_VOLT_MIN_V, STATS_VOLT_STEP_V, st.voltS, STATS_VOLT_BINS);
+  writeHist(hist, "fan_duty", 0.0f, 1024.0f / STATS_FAN_BINS, st.fanS, STATS_FAN_BINS);
+  sendDoc(root);
+}
+
+// {"perf":"show|hist|reset"} → frame {"type":"perf",...}; siklus CPU per
+// seksi (÷ cpu_mhz = µs). "hist" menambah bin non-kosong [[lo_cyc,n],..].
+static void handleCmdPerf(JsonVariant v) {
+  const char *act = v.as<const char*>();
+  if (strcasecmp(act, "reset") == 0) perfReset();
+  bool withHist = strcasecmp(act, "hist") == 0;
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"]    = "perf";
+  root["enabled"] = PERF_ENABLE != 0;
+  root["cpu_mhz"] = perfCyclesPerUs();
+  JsonObject secs = root["secs"].to<JsonObject>();
+  for (uint8_t i = 0; i < (uint8_t)PerfSec::Count; ++i) {
+    PerfStats ps;
+    if (!perfGet((PerfSec)i, ps) || ps.count == 0) continue;
+    JsonObject o = secs[perfName((PerfSec)i)].to<JsonObject>();
+    o["n"]   = ps.count;
+    o["min"] = ps.minCyc;
+    o["avg"] = ps.avgCyc;
+    o["p50"] = ps.p50Cyc;
+    o["p99"] = ps.p99Cyc;
+    o["max"] = ps.maxCyc;
+    if (withHist) {
+      JsonArray h = o["h"].to<JsonArray>();
+      for (uint8_t b = 0; b < PERF_HIST_BINS; ++b) {
+        if (ps.hist[b] == 0) continue;
+        JsonArray e = h.add<JsonArray>();
+        e.add(perfBinLowCyc(b));
+        e.add(ps.hist[b]);
+      }
+    }
+  }
+  sendDoc(root);
+}
+
+// -------------------- Scope (capture SMPS) -------------
+// Capture dikirim sebagai frame "scope" (header) lalu "scope_chunk" berisi
+// int16 little-endian mentah (base64), satu chunk per tick saat link lega.
+// Volt = kode × v_per_lsb; waktu sampel i ≈ (i − pre) × period_us.
+static bool     sScopeDumping  = false;
+static bool     sScopeAutoDump = true;
+static uint16_t sScopeDumpOff  = 0;
+static uint16_t sScopeDumpSeq  = 0;
+
+static constexpr size_t SCOPE_B64_LEN = ((SCOPE_CHUNK_SAMPLES * 2 + 2) / 3) * 4 + 1;
+
+static void sendScopeStatus() {
+  ScopeInfo info;
+  scopeGetInfo(info);
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"]  = "scope";
+  root["state"] = scopeStateToStr(info.state);
+  if (info.trigCode == INT16_MIN) {
+    root["trig_v"] = nullptr;
+  } else {
+    root["trig_v"] = sensorsAdsCodeToVolt(info.trigCode);
+  }
+  if (info.state == ScopeState::Done) {
+    root["trig"]       = info.manual ? "cmd" : "level";
+    root["pre"]        = info.pre;
+    root["n"]          = info.count;
+    root["period_us"]  = info.periodUs;
+    root["max_gap_us"] = info.maxGapUs;
+    root["age_ms"]     = info.trigAgoMs;
+    root["v_per_lsb"]  = sensorsAdsCodeToVolt(1);
+    root["chunk"]      = SCOPE_CHUNK_SAMPLES;
+  } else {
+    root["n"] = info.count;
+  }
+  root["dumping"] = sScopeDumping;
+  writeScopeRun(root);
+  sendDoc(root);
+}
+
+static void scopeStartDump() {
+  sScopeDumping = true;
+  sScopeDumpOff = 0;
+  sScopeDumpSeq = 0;
+  sendScopeStatus();
+}
+
+static void scopeDumpTick(uint32_t now) {
+  if (scopeConsumeDone() && sScopeAutoDump) scopeStartDump();
+  if (!sScopeDumping) return;
+  if (scopeState() != ScopeState::Done) {
+    sScopeDumping = false;   // di-arm ulang / abort di tengah dump
+    return;
+  }
+  if (sTxqCount > 0 || !linkFlowCanSend(sFlow, SCOPE_B64_LEN + 96, now)) return;
+
+  int16_t samples[SCOPE_CHUNK_SAMPLES];
+  uint16_t n = scopeRead(sScopeDumpOff, samples, SCOPE_CHUNK_SAMPLES);
+  unsigned char b64[SCOPE_B64_LEN];
+  size_t outLen = 0;
+  if (n == 0 || mbedtls_base64_encode(b64, sizeof(b64), &outLen,
+                                      reinterpret_cast<const unsigned char*>(samples),
+                                      n * sizeof(int16_t)) != 0) {
+    sScopeDumping = false;
+    return;
+  }
+  b64[outLen] = '\0';
+
+  ScopeInfo info;
+  scopeGetInfo(info);
+  bool last = sScopeDumpOff + n >= info.count;
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"]     = "scope_chunk";
+  root["seq"]      = sScopeDumpSeq;
+  root["off"]      = sScopeDumpOff;
+  root["n"]        = n;
+  root["data_b64"] = reinterpret_cast<const char*>(b64);
+  root["last"]     = last;
+  sendDoc(root);
+
+  sScopeDumpOff = (uint16_t)(sScopeDumpOff + n);
+  ++sScopeDumpSeq;
+  if (last) sScopeDumping = false;
+}
+
+// trig_v ≤ 0 → hanya trigger manual; tanpa trig_v → smps_cut + margin
+static void scopeArmFrom(JsonObject o) {
+  float trigV = stateSmpsCutoffV() + SCOPE_TRIG_MARGIN_V;
+  if (!o.isNull() && variantIsNumber(o["trig_v"])) trigV = o["trig_v"].as<float>();
+  uint32_t pre   = o.isNull() ? SCOPE_PRE_DEFAULT : (o["pre"] | (uint32_t)SCOPE_PRE_DEFAULT);
+  uint32_t total = o.isNull() ? SCOPE_BUF_SAMPLES : (o["n"] | (uint32_t)SCOPE_BUF_SAMPLES);
+  bool autoDump  = o.isNull() ? true : (o["auto"] | true);
+  int16_t code = trigV > 0.0f ? sensorsVoltToAdsCode(trigV) : INT16_MIN;
+  if (total > SCOPE_BUF_SAMPLES || !scopeArm(code, (uint16_t)pre, (uint16_t)total)) {
+    sendAckErr("scope", "range");
+    return;
+  }
+  sScopeDumping  = false;
+  sScopeAutoDump = autoDump;
+  sendScopeStatus();
+}
+
+static void handleCmdScope(JsonVariant v) {
+  if (v.is<JsonObject>()) {
+    JsonObject o = v.as<JsonObject>();
+    if (!(o["arm"] | false)) {
+      sendAckErr("scope", "invalid");
+      return;
+    }
+    scopeArmFrom(o);
+    return;
+  }
+  const char *act = v.as<const char*>();
+  if (!act) {
+    sendAckErr("scope", "invalid");
+  } else if (strcmp(act, "status") == 0) {
+    sendScopeStatus();
+  } else if (strcmp(act, "arm") == 0) {
+    scopeArmFrom(JsonObject());
+  } else if (strcmp(act, "trigger") == 0) {
+    if (scopeTrigger()) sendAckOk("scope", "trigger", false);
+    else                sendAckErr("scope", "not_armed");
+  } else if (strcmp(act, "abort") == 0) {
+    scopeAbort();
+    sScopeDumping = false;
+    sendAckOk("scope", "abort", false);
+  } else if (strcmp(act, "dump") == 0) {
+    if (scopeState() != ScopeState::Done) sendAckErr("scope", "no_capture");
+    else                                  scopeStartDump();
+  } else {
+    sendAckErr("scope", "invalid");
+  }
+}
+
+// -------------------- Trace event ----------------------
+// "dump" membekukan ring lalu mengirim frame "trace" (header) diikuti
+// "trace_chunk" berisi TraceRec mentah (12 byte LE, base64), satu chunk per
+// tick saat link lega. Ring dicairkan lagi setelah chunk terakhir.
+static bool     sTraceDumping = false;
+static uint16_t sTraceDumpOff = 0;
+static uint16_t sTraceDumpSeq = 0;
+
+static constexpr size_t TRACE_B64_LEN = ((TRACE_CHUNK_RECS * sizeof(TraceRec) + 2) / 3) * 4 + 1;
+
+static void sendTraceStatus() {
+  TraceStats ts;
+  traceGetStats(ts);
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"]      = "trace";
+  root["enabled"]   = TRACE_ENABLE != 0;
+  root["n"]         = ts.count;
+  root["written"]   = ts.written;
+  root["drops"]     = ts.drops;
+  root["frozen"]    = ts.frozen;
+  root["dumping"]   = sTraceDumping;
+  root["rec_bytes"] = (uint32_t)sizeof(TraceRec);
+  root["chunk"]     = TRACE_CHUNK_RECS;
+  root["now_us"]    = micros();
+  JsonArray tasks = root["tasks"].to<JsonArray>();
+  for (uint8_t i = 0; i < (uint8_t)TaskId::Count; ++i) tasks.add(taskName((TaskId)i));
+  sendDoc(root);
+}
+
+static void traceDumpTick(uint32_t now) {
+  if (!sTraceDumping) return;
+  if (sTxqCount > 0 || !linkFlowCanSend(sFlow, TRACE_B64_LEN + 96, now)) return;
+
+  TraceRec recs[TRACE_CHUNK_RECS];
+  uint16_t n = traceRead(sTraceDumpOff, recs, TRACE_CHUNK_RECS);
+  TraceStats ts;
+  traceGetStats(ts);
+  unsigned char b64[TRACE_B64_LEN];
+  size_t outLen = 0;
+  if (n > 0 && mbedtls_base64_encode(b64, sizeof(b64), &outLen,
+                                     reinterpret_cast<const unsigned char*>(recs),
+                                     n * sizeof(TraceRec)) != 0) {
+    n = 0;
+  }
+  b64[outLen] = '\0';
+
+  bool last = n == 0 || sTraceDumpOff + n >= ts.count;
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"]     = "trace_chunk";
+  root["seq"]      = sTraceDumpSeq;
+  root["off"]      = sTraceDumpOff;
+  root["n"]        = n;
+  root["data_b64"] = reinterpret_cast<const char*>(b64);
+  root["last"]     = last;
+  sendDoc(root);
+
+  sTraceDumpOff = (uint16_t)(sTraceDumpOff + n);
+  ++sTraceDumpSeq;
+  if (last) {
+    sTraceDumping = false;
+    traceFreeze(false);
+  }
+}
+
+static void handleCmdTrace(JsonVariant v) {
+  const char *act = v.as<const char*>();
+  if (strcasecmp(act, "dump") == 0) {
+    if (!sTraceDumping) {
+      traceFreeze(true);
+      sTraceDumping = true;
+      sTraceDumpOff = 0;
+      sTraceDumpSeq = 0;
+    }
+  } else if (strcasecmp(act, "clear") == 0) {
+    sTraceDumping = false;
+    traceFreeze(false);
+    traceClear();
+  }
+  sendTraceStatus();
+}
+
+static void handleCmdNvSet(JsonVariant);
+static void handleCmdDispatchStats(JsonVariant);
+
 // -------------------- Dispatch --------------------------
+// Tabel handler dibangkitkan dari skema yang sama dengan CMD_SPECS sehingga
+// index keduanya selalu sejajar (urut key → binary search).
+typedef void (*CmdHandler)(JsonVariant v);
+
+#define JACKTOR_CMD_HANDLER_ROW(ident, key, arg, mn, mx, cli, hint, help) handleCmd##ident,
+static const CmdHandler CMD_HANDLERS[] = {
+  JACKTOR_CMD_SCHEMA(JACKTOR_CMD_HANDLER_ROW)
+};
+#undef JACKTOR_CMD_HANDLER_ROW
+
+static_assert(sizeof(CMD_HANDLERS) / sizeof(CMD_HANDLERS[0]) == (size_t)CMD_SPEC_COUNT,
+              "CMD_HANDLERS harus sejajar dengan CMD_SPECS");
+
+// Statistik biaya dispatch (siklus CPU) per command + lookup key
+struct CmdStat {
+  uint32_t count;
+  uint32_t maxCyc;
+  uint64_t sumCyc;
+};
+static CmdStat  sCmdStats[CMD_SPEC_COUNT];
+static uint32_t sLookupCount = 0;
+static uint64_t sLookupCyc   = 0;
+
+static bool cmdValidateArg(const CmdSpec &spec, JsonVariant v) {
+  switch (spec.arg) {
+    case CmdArg::Bool:
+      if (!v.is<bool>()) break;
+      return true;
+    case CmdArg::Flag:
+      if (!v.is<bool>() || !v.as<bool>()) break;
+      return true;
+    case CmdArg::Float:
+    case CmdArg::Uint: {
+      if (!variantIsNumber(v)) break;
+      double d = v.as<double>();
+      if (d < (double)spec.min || d > (double)spec.max) {
+        sendAckErr(spec.key, "range");
+        return false;
+      }
+      return true;
+    }
+    case CmdArg::Enum:
+      if (!v.is<const char*>() || !cmdSchemaEnumHas(spec.hint, v.as<const char*>())) break;
+      return true;
+    case CmdArg::Str:
+      if (!v.is<const char*>()) break;
+      return true;
+    case CmdArg::Any:
+    default:
+      return true;
+  }
+  sendAckErr(spec.key, "invalid");
+  return false;
+}
+
+static void handleCmdDispatchStats(JsonVariant) {
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"]    = "cmd_stats";
+  root["cpu_mhz"] = ESP.getCpuFreqMHz();
+  root["lookup_avg_cyc"] = sLookupCount ? (uint32_t)(sLookupCyc / sLookupCount) : 0;
+  JsonObject cmds = root["cmds"].to<JsonObject>();
+  for (int i = 0; i < CMD_SPEC_COUNT; ++i) {
+    const CmdStat &st = sCmdStats[i];
+    if (st.count == 0) continue;
+    JsonObject o = cmds[CMD_SPECS[i].key].to<JsonObject>();
+    o["n"]       = st.count;
+    o["avg_cyc"] = (uint32_t)(st.sumCyc / st.count);
+    o["max_cyc"] = st.maxCyc;
+  }
+  sendDoc(root);
+}
+
+static void runCmd(int idx, JsonVariant value) {
+  uint32_t t0Us = micros();
+  uint32_t t0 = ESP.getCycleCount();
+  if (cmdValidateArg(CMD_SPECS[idx], value)) {
+    CMD_HANDLERS[idx](value);
+  }
+  uint32_t cyc = ESP.getCycleCount() - t0;
+  traceSpan(TraceEv::Cmd, t0Us, (uint16_t)idx);
+  CmdStat &st = sCmdStats[idx];
+  ++st.count;
+  st.sumCyc += cyc;
+  if (cyc > st.maxCyc) st.maxCyc = cyc;
+}
+
+static int lookupCmd(const char *key) {
+  uint32_t t0 = ESP.getCycleCount();
+  int idx = cmdSchemaFind(key);
+  sLookupCyc += (uint32_t)(ESP.getCycleCount() - t0);
+  ++sLookupCount;
+  return idx;
+}
+
+// -------------------- Batch -----------------------------
+// Command yang punya jalur balasan sendiri (OTA, log RTC, cmd_stats) atau
+// efek tak bisa ditunda (reset) tidak boleh masuk batch.
+static bool cmdBatchable(int idx) {
+  switch ((CmdId)idx) {
+    case CmdId::DispatchStats:
+    case CmdId::Diag:
+    case CmdId::FactoryReset:
+    case CmdId::LifeStats:
+    case CmdId::NvDigest:
+    case CmdId::NvGet:
+    case CmdId::NvSet:
+    case CmdId::NvsReset:
+    case CmdId::OtaAbort:
+    case CmdId::OtaBegin:
+    case CmdId::OtaEnd:
+    case CmdId::OtaWrite:
+    case CmdId::Perf:
+    case CmdId::RtcSet:
+    case CmdId::RtcSetEpoch:
+    case CmdId::Scope:
+    case CmdId::Trace:
+      return false;
+    default:
+      return true;
+  }
+}
+
+struct BatchItem {
+  int         idx;
+  JsonVariant value;
+};
+
+// Tambah item; key duplikat (array batch) → nilai terakhir yang dipakai
+static void batchAdd(BatchItem *items, uint8_t &count, int8_t *slot, int idx, JsonVariant v) {
+  if (slot[idx] >= 0) {
+    items[slot[idx]].value = v;
+    return;
+  }
+  slot[idx] = (int8_t)count;
+  items[count].idx = idx;
+  items[count].value = v;
+  ++count;
+}
+
+// Validasi semua key dulu (dry-run, tanpa efek); bila satu gagal tidak ada
+// yang diterapkan. Bila lolos: terapkan berurutan dengan commit NVS ditunda,
+// lalu satu ACK agregat + satu nada + satu frame telemetri. Key NVS yang
+// berubah hanya ditandai dirty; commit dilakukan write-behind oleh stateTick().
+static bool runBatch(const BatchItem *items, uint8_t count) {
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"]  = "ack";
+  root["batch"] = true;
+
+  CmdBatch batch;
+  batch.results    = root["results"].to<JsonObject>();
+  batch.failed     = false;
+  batch.pendingCut = NAN;
+  batch.pendingRec = NAN;
+  sBatch = &batch;
+
+  for (uint8_t i = 0; i < count; ++i) {
+    const CmdSpec &spec = CMD_SPECS[items[i].idx];
+    JsonVariant v = items[i].value;
+    if (!cmdBatchable(items[i].idx)) {
+      sendAckErr(spec.key, "not_batchable");
+      continue;
+    }
+    if (!cmdValidateArg(spec, v)) continue;
+    switch ((CmdId)items[i].idx) {
+      case CmdId::SmpsCut: batch.pendingCut = v.as<float>(); break;
+      case CmdId::SmpsRec: batch.pendingRec = v.as<float>(); break;
+      case CmdId::Buzz:
+        if (!v.is<JsonObject>()) sendAckErr(spec.key, "invalid");
+        break;
+      case CmdId::FanCurve: {
+        FanCurve c;
+        if (!parseFanCurve(v, c)) sendAckErr(spec.key, "invalid");
+        break;
+      }
+      case CmdId::Subscribe:
+        if (!v.is<JsonObject>() && !v.is<bool>()) sendAckErr(spec.key, "invalid");
+        break;
+      default: break;
+    }
+  }
+  if (!std::isnan(batch.pendingCut) || !std::isnan(batch.pendingRec)) {
+    if (effectiveSmpsCut() >= effectiveSmpsRec()) {
+      if (!std::isnan(batch.pendingCut)) sendAckErr("smps_cut", "range");
+      if (!std::isnan(batch.pendingRec)) sendAckErr("smps_rec", "range");
+    }
+  }
+
+  uint8_t nvsDirty = 0;
+  if (batch.failed) {
+    for (uint8_t i = 0; i < count; ++i) {
+      const char *key = CMD_SPECS[items[i].idx].key;
+      if (batch.results[key].isNull()) {
+        JsonObject r = batch.results[key].to<JsonObject>();
+        r["ok"]    = false;
+        r["error"] = "not_applied";
+      }
+    }
+  } else {
+    stateBatchBegin();
+    for (uint8_t i = 0; i < count; ++i) {
+      runCmd(items[i].idx, items[i].value);
+    }
+    nvsDirty = stateBatchEnd();
+  }
+  sBatch = nullptr;
+
+  root["ok"]         = !batch.failed;
+  root["applied"]    = batch.failed ? 0 : count;
+  root["nvs_dirty"]  = nvsDirty;
+  if (batch.failed) root["error"] = "batch_rejected";
+  sendDoc(root);
+  if (!batch.failed) {
+    playAckTone();
+  }
+  return !batch.failed;
+}
+
+// Key yang boleh diubah lewat nv_set (setting persisten di blob NVS)
+static bool cmdIsNvSetting(int idx) {
+  switch ((CmdId)idx) {
+    case CmdId::Bt:
+    case CmdId::BtAutoOff:
+    case CmdId::FanCurve:
+    case CmdId::FanDuty:
+    case CmdId::FanMode:
+    case CmdId::FanPi:
+    case CmdId::SmpsBypass:
+    case CmdId::SmpsCut:
+    case CmdId::SmpsRec:
+    case CmdId::SpkPwr:
+    case CmdId::SpkSel:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// {"nv_set":{"etag":"<etag>","key":"fan_duty","value":600}} atau
+// {"nv_set":{"etag":"<etag>","values":{"fan_mode":"custom","fan_duty":600}}}
+// If-Match: etag harus sama dengan etag kini ("*" = paksa). Semua key
+// diterapkan lewat jalur batch (validasi semua dulu, satu ACK), lalu
+// snapshot nv_get dengan etag baru dikirim agar cache host langsung segar.
+static void handleCmdNvSet(JsonVariant v) {
+  if (!v.is<JsonObject>()) {
+    sendAckErr("nv_set", "invalid");
+    return;
+  }
+  JsonObject req = v.as<JsonObject>();
+  const char *etag = req["etag"] | "";
+  uint32_t want = 0;
+  if (strcmp(etag, "*") != 0 && (!parseHex32(etag, want) || want != stateSettingsEtag())) {
+    sendAckErr("nv_set", "etag_mismatch");
+    sendNvDigest(true);
+    return;
+  }
+
+  BatchItem items[CMD_SPEC_COUNT];
+  int8_t    slot[CMD_SPEC_COUNT];
+  memset(slot, -1, sizeof(slot));
+  uint8_t count = 0;
+
+  const char *single = req["key"] | (const char*)nullptr;
+  if (single) {
+    int idx = lookupCmd(single);
+    if (idx < 0 || !cmdIsNvSetting(idx)) {
+      sendAckErr(single, "not_nv");
+      return;
+    }
+    batchAdd(items, count, slot, idx, req["value"]);
+  }
+  for (JsonPair kv : req["values"].as<JsonObject>()) {
+    int idx = lookupCmd(kv.key().c_str());
+    if (idx < 0 || !cmdIsNvSetting(idx)) {
+      sendAckErr(kv.key().c_str(), "not_nv");
+      return;
+    }
+    batchAdd(items, count, slot, idx, kv.value());
+  }
+  if (count == 0) {
+    sendAckErr("nv_set", "invalid");
+    return;
+  }
+  if (runBatch(items, count)) {
+    sendNvGet();
+  }
+}
+
 static void handleJsonLine(const String &line) {
   JsonDocument doc;
   DeserializationError err = deserializeJson(doc, line);
   if (err) return;
 
   const char *type = doc["type"] | "";
+  if (strcmp(type, "credit") == 0) {
+    linkFlowOnCredit(sFlow, doc["rx"] | 0UL, doc["win"] | 0UL);
+    return;
+  }
   if (strcmp(type, "cmd") != 0 && strcmp(type, "command") != 0) return;
 
   JsonObject root = doc.as<JsonObject>();
   JsonObject cmd = root["cmd"];
-  if (cmd.isNull()) return;
-
-  HANDLE_IF_PRESENT("power",         handleCmdPower);
-  HANDLE_IF_PRESENT("bt",            handleCmdBt);
-  HANDLE_IF_PRESENT("spk_sel",       handleCmdSpkSel);
-  HANDLE_IF_PRESENT("spk_pwr",       handleCmdSpkPwr);
-  HANDLE_IF_PRESENT("smps_bypass",   handleCmdSmpsBypass);
-  HANDLE_IF_PRESENT("smps_cut",      handleCmdSmpsCut);
-  HANDLE_IF_PRESENT("smps_rec",      handleCmdSmpsRec);
-  HANDLE_IF_PRESENT("bt_autooff",    handleCmdBtAutoOff);
-  HANDLE_IF_PRESENT("fan_mode",      handleCmdFanMode);
-  HANDLE_IF_PRESENT("fan_duty",      handleCmdFanDuty);
-  HANDLE_IF_PRESENT("rtc_set",       handleCmdRtcSet);
-  HANDLE_IF_PRESENT("rtc_set_epoch", handleCmdRtcSetEpoch);
-  HANDLE_IF_PRESENT("ota_begin",     handleCmdOtaBegin);
-  HANDLE_IF_PRESENT("ota_write",     handleCmdOtaWrite);
-  HANDLE_IF_PRESENT("ota_end",       handleCmdOtaEnd);
-  HANDLE_IF_PRESENT("ota_abort",     handleCmdOtaAbort);
-  HANDLE_IF_PRESENT("buzz",          handleCmdBuzz);
-  HANDLE_IF_PRESENT("nvs_reset",     handleCmdNvsReset);
-  HANDLE_IF_PRESENT("factory_reset", handleCmdFactoryReset);
-}
-
-#undef HANDLE_IF_PRESENT
+  JsonArray list = root["batch"];
+  if (cmd.isNull() && list.isNull()) return;
+
+  sHasReqId = root["id"].is<uint32_t>();
+  sReqId    = sHasReqId ? root["id"].as<uint32_t>() : 0;
+
+  // Kumpulkan key yang dikenal (key tak dikenal diabaikan). Satu key di
+  // "cmd" → jalur tunggal seperti biasa; >1 key atau array "batch" → batch.
+  BatchItem items[CMD_SPEC_COUNT];
+  int8_t    slot[CMD_SPEC_COUNT];
+  memset(slot, -1, sizeof(slot));
+  uint8_t count = 0;
+
+  for (JsonPair kv : cmd) {
+    int idx = lookupCmd(kv.key().c_str());
+    if (idx >= 0) batchAdd(items, count, slot, idx, kv.value());
+  }
+  for (JsonObject part : list) {
+    for (JsonPair kv : part) {
+      int idx = lookupCmd(kv.key().c_str());
+      if (idx >= 0) batchAdd(items, count, slot, idx, kv.value());
+    }
+  }
 
-// -------------------- PUBLIC API ------------------------
-void commsInit() {
-  pinMode(LED_UART_PIN, OUTPUT);
-  digitalWrite(LED_UART_PIN, LOW);
+  if (count == 0) {
+    // Tanpa id tetap diam (kompatibel); dengan id host menunggu balasan
+    if (sHasReqId) sendAckErr(nullptr, "unknown_cmd");
+  } else if (count == 1 && list.isNull()) {
+    runCmd(items[0].idx, items[0].value);
+  } else {
+    runBatch(items, count);
+  }
+  sHasReqId = false;
+}
 
-  linkSerial.begin(SERIAL_BAUD_LINK, SERIAL_8N1, UART2_RX_PIN, UART2_TX_PIN);
-  rxLine.reserve(4096);
-  lastTelMs = 0;
-  otaReady = true;
-  forceTel = true;
+// -------------------- RX admission ----------------------
+// Pemindai JSON minimal (tanpa alokasi): cukup untuk menelusuri key level
+// atas tanpa parse penuh baris yang mungkin berisi chunk OTA besar.
+static const char *jsonWs(const char *p) {
+  while (*p == ' ' || *p == '\t') ++p;
+  return p;
 }
 
-void commsTick(uint32_t now, bool sqwTick) {
-  ledActivityTick(now);
+static const char *jsonSkipString(const char *p) {   // p di '"'
+  ++p;
+  while (*p && *p != '"') {
+    if (*p == '\\' && p[1]) ++p;
+    ++p;
+  }
+  return *p ? p + 1 : p;
+}
+
+static const char *jsonSkipValue(const char *p) {
+  p = jsonWs(p);
+  if (*p == '"') return jsonSkipString(p);
+  if (*p == '{' || *p == '[') {
+    int depth = 0;
+    while (*p) {
+      if (*p == '"') {
+        p = jsonSkipString(p);
+        continue;
+      }
+      if (*p == '{' || *p == '[') {
+        ++depth;
+      } else if ((*p == '}' || *p == ']') && --depth == 0) {
+        return p + 1;
+      }
+      ++p;
+    }
+    return p;
+  }
+  while (*p && *p != ',' && *p != '}' && *p != ']') ++p;
+  return p;
+}
+
+// Panggil fn(key, keyLen, value) untuk tiap pasangan objek di p; fn
+// mengembalikan pointer setelah value. Return pointer setelah '}'.
+template <typename Fn>
+static const char *jsonForEachKey(const char *p, Fn fn) {
+  p = jsonWs(p);
+  if (*p != '{') return jsonSkipValue(p);
+  ++p;
+  for (;;) {
+    p = jsonWs(p);
+    if (*p != '"') break;
+    const char *key = p + 1;
+    const char *end = jsonSkipString(p);
+    size_t keyLen = end > key ? (size_t)(end - 1 - key) : 0;
+    p = jsonWs(end);
+    if (*p != ':') break;
+    p = jsonWs(fn(key, keyLen, jsonWs(p + 1)));
+    if (*p != ',') break;
+    ++p;
+  }
+  return *p == '}' ? p + 1 : p;
+}
+
+static bool keyIs(const char *key, size_t len, const char *name) {
+  return strlen(name) == len && strncmp(key, name, len) == 0;
+}
+
+static const char *const RX_LOW_KEYS[] = {
+  "buzz", "sub", "diag", "cmd_stats", "stats", "perf", "trace",
+};
+
+// Prioritas dari key command ("cmd":{..} dan objek di "batch":[..]), bukan
+// substring baris: batch berisi "buzz" + command lain tetap NORMAL. Urgent
+// bila ada "power":false / ota_abort; LOW hanya bila semua key rendah.
+static RxPrio classifyLine(const char *line) {
+  bool urgent = false;
+  bool normal = false;
+  bool any = false;
+  auto onCmdKey = [&](const char *k, size_t n, const char *v) {
+    any = true;
+    if ((keyIs(k, n, "power") && strncmp(v, "false", 5) == 0) || keyIs(k, n, "ota_abort")) {
+      urgent = true;
+    } else {
+      bool low = false;
+      for (const char *name : RX_LOW_KEYS) low = low || keyIs(k, n, name);
+      if (!low) normal = true;
+    }
+    return jsonSkipValue(v);
+  };
+  jsonForEachKey(line, [&](const char *k, size_t n, const char *v) -> const char * {
+    if (keyIs(k, n, "cmd") && *v == '{') return jsonForEachKey(v, onCmdKey);
+    if (keyIs(k, n, "batch") && *v == '[') {
+      const char *p = v + 1;
+      for (;;) {
+        p = jsonWs(p);
+        p = *p == '{' ? jsonForEachKey(p, onCmdKey) : jsonSkipValue(p);
+        p = jsonWs(p);
+        if (*p != ',') break;
+        ++p;
+      }
+      return *p == ']' ? p + 1 : p;
+    }
+    return jsonSkipValue(v);
+  });
+  if (urgent) return RX_PRIO_URGENT;
+  return (any && !normal) ? RX_PRIO_LOW : RX_PRIO_NORMAL;
+}
 
+// Tolak baris; balas hanya bila request ber-id
+static void rejectLine(const String &line, const char *err) {
+  if (line.indexOf("\"id\"") < 0) return;
+  JsonDocument doc;
+  if (deserializeJson(doc, line)) return;
+  if (!doc["id"].is<uint32_t>()) return;
+  sHasReqId = true;
+  sReqId    = doc["id"].as<uint32_t>();
+  sendAckErr(nullptr, err);
+  sHasReqId = false;
+}
+
+static void rejectRateLimited(const String &line) {
+  ++sRxRateLimited;
+  rejectLine(line, "rate_limited");
+}
+
+// Antrean penuh: gusur entri prioritas terendah (terbaru di antaranya) bila
+// lebih rendah dari baris baru; selain itu baris baru yang ditolak "busy".
+static bool makeRoom(RxPrio prio, const String &line) {
+  int victim = -1;
+  for (uint8_t i = 0; i < sRxqCount; ++i) {
+    if (sRxQ[i].prio < prio && (victim < 0 || sRxQ[i].prio <= sRxQ[victim].prio)) victim = i;
+  }
+  ++sRxBusy;
+  if (victim < 0) {
+    rejectLine(line, "busy");
+    return false;
+  }
+  String old = sRxQ[victim].line;
+  for (uint8_t i = victim; i + 1 < sRxqCount; ++i) {
+    sRxQ[i].line = sRxQ[i + 1].line;
+    sRxQ[i].prio = sRxQ[i + 1].prio;
+  }
+  --sRxqCount;
+  sRxQ[sRxqCount].line = String();
+  rejectLine(old, "busy");
+  return true;
+}
+
+static void admitLine(const String &line, uint32_t now) {
+  // Frame credit murah & sensitif waktu → langsung diproses
+  if (line.startsWith("{\"type\":\"credit\"")) {
+    handleJsonLine(line);
+    return;
+  }
+  RxPrio prio = classifyLine(line.c_str());
+  if (prio == RX_PRIO_LOW) {
+    if (sLowSeen && now - sLastLowMs < LINK_LOW_PRIO_MIN_MS) {
+      rejectRateLimited(line);
+      return;
+    }
+    sLowSeen = true;
+    sLastLowMs = now;
+  }
+  if (sRxqCount >= LINK_RX_QUEUE_MAX && !makeRoom(prio, line)) return;
+  RxEntry &e = sRxQ[sRxqCount++];
+  e.line = line;
+  e.prio = prio;
+  if (sRxqCount > sRxqPeak) sRxqPeak = sRxqCount;
+}
+
+// Baca UART → baris lengkap → antrean. Berhenti saat anggaran byte habis;
+// sisa byte tetap di buffer UART (kredit tidak dilepas, panel otomatis
+// menahan kiriman berikutnya). Antrean penuh tidak menghentikan baca agar
+// baris urgent di belakang tetap masuk (lihat makeRoom).
+static void readRx() {
+  uint16_t budget = LINK_RX_BYTE_BUDGET;
   while (linkSerial.available()) {
+    if (budget == 0) {
+      ++sRxByteBudgetHits;
+      break;
+    }
     int c = linkSerial.read();
     if (c < 0) break;
+    --budget;
     ledRxPulse();
+    linkFlowOnRead(sFlow, 1);
 
     if (c == '\n' || c == '\r') {
       if (rxLine.length() > 0) {
-        handleJsonLine(rxLine);
+        admitLine(rxLine, ms());
         rxLine = "";
       }
     } else {
@@ -780,11 +2132,80 @@ void commsTick(uint32_t now, bool sqwTick) {
       }
     }
   }
+}
+
+// Eksekusi antrean: prioritas tertinggi dulu (FIFO dalam prioritas sama).
+// Minimal satu baris non-urgent per tick agar selalu ada kemajuan.
+static void processRxQueue() {
+  uint32_t t0 = micros();
+  bool progressed = false;
+  while (sRxqCount > 0) {
+    uint8_t pick = 0;
+    for (uint8_t i = 1; i < sRxqCount; ++i) {
+      if (sRxQ[i].prio > sRxQ[pick].prio) pick = i;
+    }
+    bool urgent = sRxQ[pick].prio == RX_PRIO_URGENT;
+    if (!urgent && progressed && micros() - t0 >= LINK_RX_TIME_BUDGET_US) {
+      ++sRxTimeBudgetHits;
+      break;
+    }
+    String line = sRxQ[pick].line;
+    for (uint8_t i = pick; i + 1 < sRxqCount; ++i) {
+      sRxQ[i].line = sRxQ[i + 1].line;
+      sRxQ[i].prio = sRxQ[i + 1].prio;
+    }
+    --sRxqCount;
+    sRxQ[sRxqCount].line = String();
+
+    if (urgent) ++sRxUrgent;
+    else        progressed = true;
+    handleJsonLine(line);
+  }
+}
+
+// -------------------- PUBLIC API ------------------------
+void commsInit() {
+  pinMode(LED_UART_PIN, OUTPUT);
+  digitalWrite(LED_UART_PIN, LOW);
+
+  linkSerial.setRxBufferSize(LINK_RX_BUFFER_BYTES);
+  linkSerial.begin(SERIAL_BAUD_LINK, SERIAL_8N1, UART2_RX_PIN, UART2_TX_PIN);
+  rxLine.reserve(4096);
+  lastTelMs = 0;
+  otaReady = true;
+  forceTel = true;
+}
+
+void commsTick(uint32_t now, bool sqwTick) {
+  ledActivityTick(now);
+
+  readRx();
+  processRxQueue();
+
+  flushTxQueue(now);
+  advertiseCredit(now);
+  scopeDumpTick(now);
+  traceDumpTick(now);
+
+  if (sSubMask != 0) {
+    uint8_t due = topicsDue(now, forceTel);
+    if (due != 0 && telemetryHeld(LINK_TEL_FRAME_EST / 2, now)) return;
+    if (sendTelemetryTopics(due)) {
+      traceEmit(TraceEv::Telemetry, due);
+      topicsMarkSent(due, now);
+      lastTelMs = now;
+    }
+    forceTel = false;
+    return;
+  }
 
   uint16_t hzActive   = TELEMETRY_HZ_ACTIVE;
   uint16_t hzStandby  = TELEMETRY_HZ_STANDBY;
   uint32_t intervalActive  = (hzActive  > 0) ? (1000UL / hzActive)  : 0;
   uint32_t intervalStandby = (hzStandby > 0) ? (1000UL / hzStandby) : 0;
+  if (shedLevel() >= ShedLevel::Telemetry && intervalActive < SHED_TEL_KEYFRAME_MS) {
+    intervalActive = SHED_TEL_KEYFRAME_MS;
+  }
 
   bool shouldSend = forceTel;
   if (!shouldSend) {
@@ -804,8 +2225,11 @@ void commsTick(uint32_t now, bool sqwTick) {
     }
   }
 
+  if (shouldSend && telemetryHeld(LINK_TEL_FRAME_EST, now)) return;
+
   if (shouldSend) {
     sendTelemetry();
+    traceEmit(TraceEv::Telemetry, 0xFFFF);
     lastTelMs = now;
     forceTel = false;
   }
@@ -0,0 +1,122 @@
+#include "fan_ctrl.h"
+#include "config.h"
+
+#include <math.h>
+#include <string.h>
+
+bool fanCurveValid(const FanCurve &c) {
+  if (c.n < 2 || c.n > FAN_CURVE_MAX_POINTS) return false;
+  for (uint8_t i = 0; i < c.n; ++i) {
+    if (c.tC[i] >= FAN_LUT_SIZE || c.duty[i] > 1023) return false;
+    if (i > 0 && c.tC[i] <= c.tC[i - 1]) return false;
+  }
+  return true;
+}
+
+void fanCurveDefault(FanCurve &c) {
+  memset(&c, 0, sizeof(c));
+  c.n       = 3;
+  c.tC[0]   = (uint8_t)FAN_AUTO_T1_C;
+  c.tC[1]   = (uint8_t)FAN_AUTO_T2_C;
+  c.tC[2]   = (uint8_t)FAN_AUTO_T3_C;
+  c.duty[0] = FAN_AUTO_D1;
+  c.duty[1] = FAN_AUTO_D2;
+  c.duty[2] = FAN_AUTO_D3;
+}
+
+// Di bawah titik pertama = duty pertama, di atas titik terakhir = duty terakhir
+void fanCtrlSetCurve(FanCtrl &c, const FanCurve &curve) {
+  FanCurve cv = curve;
+  if (!fanCurveValid(cv)) fanCurveDefault(cv);
+  uint8_t seg = 0;
+  for (int t = 0; t < FAN_LUT_SIZE; ++t) {
+    if (t <= cv.tC[0]) {
+      c.lut[t] = cv.duty[0];
+      continue;
+    }
+    while (seg + 1 < cv.n && t > cv.tC[seg + 1]) ++seg;
+    if (seg + 1 >= cv.n) {
+      c.lut[t] = cv.duty[cv.n - 1];
+      continue;
+    }
+    int32_t t0 = cv.tC[seg], t1 = cv.tC[seg + 1];
+    int32_t d0 = cv.duty[seg], d1 = cv.duty[seg + 1];
+    c.lut[t] = (uint16_t)(d0 + ((d1 - d0) * (t - t0) + (t1 - t0) / 2) / (t1 - t0));
+  }
+}
+
+void fanCtrlInit(FanCtrl &c, const FanCtrlParams &p, const FanCurve &curve) {
+  memset(&c, 0, sizeof(c));
+  c.p = p;
+  fanCtrlSetCurve(c, curve);
+}
+
+// Interpolasi antar dua entri LUT (lookup + satu lerp, tanpa loop)
+uint16_t fanCtrlLut(const FanCtrl &c, float tC) {
+  if (isnan(tC)) return c.p.failDuty;
+  if (tC <= 0.0f) return c.lut[0];
+  if (tC >= FAN_LUT_SIZE - 1) return c.lut[FAN_LUT_SIZE - 1];
+  int   i = (int)tC;
+  float f = tC - (float)i;
+  return (uint16_t)lroundf(c.lut[i] + f * ((float)c.lut[i + 1] - (float)c.lut[i]));
+}
+
+static float clampf(float v, float lo, float hi) {
+  return v < lo ? lo : v > hi ? hi : v;
+}
+
+uint16_t fanCtrlStep(FanCtrl &c, float tC, float dtS) {
+  float target;
+  if (isnan(tC)) {
+    c.integ  = 0.0f;
+    c.primed = false;
+    target   = c.p.failDuty;
+  } else {
+    // Hysteresis: naik langsung, turun baru setelah selisih hystC
+    if (!c.primed || tC > c.tEff) {
+      c.tEff = tC;
+    } else if (tC < c.tEff - c.p.hystC) {
+      c.tEff = tC + c.p.hystC;
+    }
+    c.primed = true;
+    target = fanCtrlLut(c, c.tEff);
+
+    if (c.p.pi) {
+      float e  = c.tEff - c.p.setpointC;   // error ikut hysteresis → tidak hunting
+      float pTerm = c.p.kp * e;
+      float out = target + pTerm + c.integ;
+      // Anti-windup: integral tidak didorong lebih jauh saat keluaran jenuh
+      bool satHi = out >= 1023.0f && e > 0.0f;
+      bool satLo = out <= (float)c.lut[0] && e < 0.0f;
+      if (!satHi && !satLo) {
+        c.integ = clampf(c.integ + c.p.ki * e * dtS, -c.p.integMax, c.p.integMax);
+      }
+      // Duty titik pertama kurva tetap jadi lantai (kipas tidak berhenti)
+      target = target + pTerm + c.integ;
+      if (target < c.lut[0]) target = c.lut[0];
+    }
+  }
+  target = clampf(target, 0.0f, 1023.0f);
+  // Deadband keluaran: koreksi kecil (kuantisasi sensor, sisa integral)
+  // tidak menggerakkan kipas bolak-balik; target ujung kurva tetap dicapai
+  if (fabsf(target - c.duty) < c.p.deadband && target > 0.0f && target < 1023.0f) {
+    return (uint16_t)lroundf(c.duty);
+  }
+
+  float up   = c.p.slewUpPerS * dtS;
+  float down = c.p.slewDownPerS * dtS;
+  if (target > c.duty + up) {
+    c.duty += up;
+  } else if (target < c.duty - down) {
+    c.duty -= down;
+  } else {
+    c.duty = target;
+  }
+  return (uint16_t)lroundf(c.duty);
+}
+
+void fanCtrlTrack(FanCtrl &c, uint16_t duty) {
+  c.duty   = duty > 1023 ? 1023.0f : (float)duty;
+  c.integ  = 0.0f;
+  c.primed = false;
+}
@@ -0,0 +1,135 @@
+#include "gpio_edge.h"
+#include "config.h"
+#include "sched.h"
+
+#include <atomic>
+
+struct EdgeEvt {
+  uint32_t us;
+  uint32_t ms;
+  uint8_t  src;
+  uint8_t  level;
+};
+
+static_assert((GPIO_EDGE_QUEUE & (GPIO_EDGE_QUEUE - 1)) == 0, "GPIO_EDGE_QUEUE harus pangkat 2");
+
+// Produsen tunggal (dispatcher ISR GPIO, tidak saling menyela) dan konsumen
+// tunggal (loop) → cukup indeks atomik, tanpa critical section
+static EdgeEvt               sQ[GPIO_EDGE_QUEUE];
+static std::atomic<uint32_t> sHead{0};     // ditulis ISR
+static std::atomic<uint32_t> sTail{0};     // ditulis loop
+static volatile bool         sOverflow = false;
+static volatile uint8_t      sIsrLevel[(uint8_t)EdgeSrc::Count];
+static volatile uint32_t     sDupes = 0;
+
+static const uint8_t EDGE_PIN[(uint8_t)EdgeSrc::Count] = {
+  BT_STATUS_PIN, SPK_PROTECT_LED_PIN, PC_DETECT_PIN
+};
+static const char *const EDGE_NAME[(uint8_t)EdgeSrc::Count] = { "bt", "spk", "pc" };
+
+// Sisi loop
+static bool     sLevel[(uint8_t)EdgeSrc::Count];
+static uint32_t sSinceMs[(uint8_t)EdgeSrc::Count];
+static uint32_t sEdges[(uint8_t)EdgeSrc::Count];
+static uint32_t sOverflows = 0;
+static uint8_t  sQPeak     = 0;
+static uint32_t sLagMaxUs  = 0;
+
+static inline void IRAM_ATTR edgeCapture(uint8_t src) {
+  uint8_t level = (uint8_t)digitalRead(EDGE_PIN[src]);
+  if (level == sIsrLevel[src]) {
+    ++sDupes;
+    return;
+  }
+  uint32_t head = sHead.load(std::memory_order_relaxed);
+  if (head - sTail.load(std::memory_order_acquire) >= GPIO_EDGE_QUEUE) {
+    sOverflow = true;   // level tidak dicatat → loop resync dari pin
+    return;
+  }
+  sIsrLevel[src] = level;
+  EdgeEvt &e = sQ[head & (GPIO_EDGE_QUEUE - 1)];
+  e.us    = micros();
+  e.ms    = millis();
+  e.src   = src;
+  e.level = level;
+  sHead.store(head + 1, std::memory_order_release);
+  schedWakeFromIsr();   // loop yang sedang tidur langsung memproses tepi
+}
+
+static void IRAM_ATTR onBtEdge()  { edgeCapture((uint8_t)EdgeSrc::BtStatus); }
+static void IRAM_ATTR onSpkEdge() { edgeCapture((uint8_t)EdgeSrc::SpkLed); }
+static void IRAM_ATTR onPcEdge()  { edgeCapture((uint8_t)EdgeSrc::PcDetect); }
+
+static void resyncFromPins(uint32_t now) {
+  for (uint8_t s = 0; s < (uint8_t)EdgeSrc::Count; ++s) {
+    uint8_t level = (uint8_t)digitalRead(EDGE_PIN[s]);
+    sIsrLevel[s] = level;
+    if ((level != 0) != sLevel[s]) {
+      sLevel[s]   = level != 0;
+      sSinceMs[s] = now;
+      ++sEdges[s];
+    }
+  }
+}
+
+void gpioEdgeInit() {
+  uint32_t now = millis();
+  for (uint8_t s = 0; s < (uint8_t)EdgeSrc::Count; ++s) {
+    uint8_t level = (uint8_t)digitalRead(EDGE_PIN[s]);
+    sIsrLevel[s] = level;
+    sLevel[s]    = level != 0;
+    sSinceMs[s]  = now;
+    sEdges[s]    = 0;
+  }
+  sHead.store(0);
+  sTail.store(0);
+  attachInterrupt(digitalPinToInterrupt(BT_STATUS_PIN), onBtEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(SPK_PROTECT_LED_PIN), onSpkEdge, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(PC_DETECT_PIN), onPcEdge, CHANGE);
+}
+
+uint8_t gpioEdgeService(uint32_t now) {
+  uint32_t tail = sTail.load(std::memory_order_relaxed);
+  uint32_t head = sHead.load(std::memory_order_acquire);
+  uint32_t depth = head - tail;
+  if (depth > sQPeak) sQPeak = (uint8_t)depth;
+
+  uint8_t n = 0;
+  uint32_t nowUs = micros();
+  for (; tail != head; ++tail, ++n) {
+    const EdgeEvt &e = sQ[tail & (GPIO_EDGE_QUEUE - 1)];
+    sLevel[e.src]   = e.level != 0;
+    sSinceMs[e.src] = e.ms;
+    ++sEdges[e.src];
+    if (nowUs - e.us > sLagMaxUs) sLagMaxUs = nowUs - e.us;
+  }
+  sTail.store(tail, std::memory_order_release);
+
+  if (sOverflow) {
+    sOverflow = false;
+    ++sOverflows;
+    resyncFromPins(now);
+  }
+  return n;
+}
+
+bool gpioEdgeLevel(EdgeSrc s) {
+  return sLevel[(uint8_t)s];
+}
+
+uint32_t gpioEdgeSinceMs(EdgeSrc s) {
+  return sSinceMs[(uint8_t)s];
+}
+
+void gpioEdgeGetStats(GpioEdgeStats &out) {
+  for (uint8_t s = 0; s < (uint8_t)EdgeSrc::Count; ++s) out.edges[s] = sEdges[s];
+  out.dupes     = sDupes;
+  out.overflows = sOverflows;
+  out.queuePeak = sQPeak;
+  out.lagMaxUs  = sLagMaxUs;
+}
+
+const char* gpioEdgeName(EdgeSrc s) {
+  uint8_t i = (uint8_t)s;
+  return i < (uint8_t)EdgeSrc::Count ? EDGE_NAME[i] : "?";
+}
@@ -0,0 +1,342 @@
+#include "i2c_bus.h"
+#include "config.h"
+
+#include <Wire.h>
+
+struct I2cJob {
+  I2cJobFn fn;
+  uint32_t arg;
+  uint32_t enqUs;
+  uint32_t seq;        // FIFO di dalam prioritas yang sama
+  uint16_t estBytes;
+  I2cDev   dev;
+  uint8_t  prio;
+  bool     used;
+};
+
+static I2cJob   sQ[I2C_BUS_QUEUE_MAX];
+static_assert(I2C_BUS_HIGH_RESERVE < I2C_BUS_QUEUE_MAX, "I2C_BUS_HIGH_RESERVE harus < I2C_BUS_QUEUE_MAX");
+static uint8_t  sQCount   = 0;
+static uint8_t  sQPeak    = 0;
+static uint32_t sSeq      = 0;
+static uint32_t sDrops    = 0;
+static uint32_t sDeferred = 0;
+static uint32_t sBudgetHits = 0;
+static uint32_t sClockHz  = 0;   // clock yang sedang terpasang di Wire
+
+// Bus dipakai beberapa task (safety: ADS; ui: OLED; comms: RTC). Mutex
+// rekursif: job boleh submit/probe dari dalam job. i2cBusTick melepas lock
+// di antara job, jadi (dengan priority inheritance) task safety menunggu
+// paling lama satu transaksi yang sedang jalan.
+static SemaphoreHandle_t sLock = nullptr;
+static uint32_t sLockTimeouts = 0;
+
+static bool busLock() {
+  if (!sLock) return true;   // sebelum i2cBusInit / tanpa RTOS
+  if (xSemaphoreTakeRecursive(sLock, pdMS_TO_TICKS(I2C_LOCK_TIMEOUT_MS)) == pdTRUE) return true;
+  ++sLockTimeouts;
+  return false;
+}
+
+static void busUnlock() {
+  if (sLock) xSemaphoreGiveRecursive(sLock);
+}
+
+// Statistik per device + utilisasi
+struct DevAcc {
+  uint32_t jobs;
+  uint32_t fails;
+  uint32_t bytes;
+  uint32_t busyUs;
+  uint32_t latMaxUs;
+  uint64_t latSumUs;
+};
+static DevAcc   sDev[(uint8_t)I2cDev::Count];
+static uint32_t sBusyWinUs  = 0;
+static uint32_t sWinStartMs = 0;
+static uint8_t  sUtilPct    = 0;
+
+static const char *const DEV_NAMES[(uint8_t)I2cDev::Count] = { "rtc", "ads", "oled" };
+static const uint8_t DEV_ADDR[(uint8_t)I2cDev::Count] = { RTC_I2C_ADDR, ADS_I2C_ADDR, OLED_I2C_ADDR };
+
+// Kesehatan per device
+struct DevHealth {
+  uint8_t  failSeq;      // gagal berturut-turut
+  bool     offline;
+  uint32_t backoffMs;
+  uint32_t retryAtMs;
+  uint32_t skipped;
+  uint32_t offlineCount;
+};
+static DevHealth sHealth[(uint8_t)I2cDev::Count];
+static uint32_t  sRecoveries   = 0;
+static uint32_t  sLastRecoverMs = 0;
+
+const char* i2cDevName(I2cDev dev) {
+  uint8_t i = (uint8_t)dev;
+  return i < (uint8_t)I2cDev::Count ? DEV_NAMES[i] : "?";
+}
+
+// OLED boleh lebih cepat dari DS3231 (spesifikasi maks 400 kHz)
+static uint32_t devClockHz(I2cDev dev) {
+  return dev == I2cDev::Oled ? I2C_OLED_CLOCK_HZ : I2C_BUS_CLOCK_HZ;
+}
+
+static void wireBegin(uint32_t hz) {
+  Wire.begin(I2C_SDA, I2C_SCL, hz);
+  Wire.setTimeOut(I2C_TIMEOUT_MS);
+  sClockHz = hz;
+}
+
+// Slave yang tertahan di tengah byte menahan SDA LOW: beri hingga 9 clock
+// SCL sampai SDA lepas, lalu STOP manual, kemudian pasang ulang Wire.
+static void busRecover() {
+  uint32_t now = millis();
+  if (sRecoveries > 0 && now - sLastRecoverMs < I2C_RECOVER_MIN_GAP_MS) return;
+  sLastRecoverMs = now;
+  ++sRecoveries;
+  uint32_t hz = sClockHz;
+  Wire.end();
+  pinMode(I2C_SDA, INPUT_PULLUP);
+  pinMode(I2C_SCL, OUTPUT_OPEN_DRAIN);
+  digitalWrite(I2C_SCL, HIGH);
+  for (uint8_t i = 0; i < 9 && digitalRead(I2C_SDA) == LOW; ++i) {
+    digitalWrite(I2C_SCL, LOW);
+    delayMicroseconds(5);
+    digitalWrite(I2C_SCL, HIGH);
+    delayMicroseconds(5);
+  }
+  pinMode(I2C_SDA, OUTPUT_OPEN_DRAIN);
+  digitalWrite(I2C_SDA, LOW);
+  delayMicroseconds(5);
+  digitalWrite(I2C_SDA, HIGH);   // SDA naik saat SCL HIGH = STOP
+  delayMicroseconds(5);
+  wireBegin(hz);
+}
+
+static void healthOnResult(I2cDev dev, bool ok) {
+  DevHealth &h = sHealth[(uint8_t)dev];
+  if (ok) {
+    h.failSeq = 0;
+    h.offline = false;
+    h.backoffMs = 0;
+    return;
+  }
+  if (digitalRead(I2C_SDA) == LOW) busRecover();
+  if (h.failSeq < 255) ++h.failSeq;
+  if (h.offline) {
+    h.backoffMs = h.backoffMs * 2 > I2C_BACKOFF_MAX_MS ? I2C_BACKOFF_MAX_MS : h.backoffMs * 2;
+  } else if (h.failSeq >= I2C_FAIL_OFFLINE) {
+    h.offline = true;
+    h.backoffMs = I2C_BACKOFF_MIN_MS;
+    ++h.offlineCount;
+  } else {
+    return;
+  }
+  h.retryAtMs = millis() + h.backoffMs;
+}
+
+bool i2cBusProbe(uint8_t addr) {
+  Wire.beginTransmission(addr);
+  return Wire.endTransmission() == 0;
+}
+
+static bool execute(I2cDev dev, I2cJobFn fn, uint32_t arg, uint16_t estBytes, uint32_t enqUs) {
+  DevHealth &h = sHealth[(uint8_t)dev];
+  if (h.offline) {
+    ++h.skipped;   // degradasi: tidak menunggu timeout device yang hilang
+    return false;
+  }
+  uint32_t hz = devClockHz(dev);
+  if (hz != sClockHz) {
+    Wire.setClock(hz);
+    sClockHz = hz;
+  }
+  uint32_t t0 = micros();
+  bool ok = fn(arg);
+  uint32_t t1 = micros();
+  healthOnResult(dev, ok);
+
+  DevAcc &d = sDev[(uint8_t)dev];
+  uint32_t busy = t1 - t0;
+  uint32_t lat  = t1 - enqUs;
+  ++d.jobs;
+  if (!ok) ++d.fails;
+  d.bytes    += estBytes;
+  d.busyUs   += busy;
+  d.latSumUs += lat;
+  if (lat > d.latMaxUs) d.latMaxUs = lat;
+  sBusyWinUs += busy;
+  return ok;
+}
+
+void i2cBusInit() {
+  if (!sLock) sLock = xSemaphoreCreateRecursiveMutex();
+  wireBegin(I2C_BUS_CLOCK_HZ);
+  if (digitalRead(I2C_SDA) == LOW) busRecover();   // reset di tengah transaksi
+  memset(sQ, 0, sizeof(sQ));
+  memset(sDev, 0, sizeof(sDev));
+  memset(sHealth, 0, sizeof(sHealth));
+  sQCount = 0;
+  sWinStartMs = millis();
+}
+
+bool i2cBusSubmit(I2cDev dev, I2cPrio prio, I2cJobFn fn, uint32_t arg, uint16_t estBytes) {
+  if (!fn) return false;
+  DevHealth &h = sHealth[(uint8_t)dev];
+  if (h.offline) {
+    ++h.skipped;
+    return false;
+  }
+  if (!busLock()) return false;
+  // Flush OLED penuh tidak boleh menghabiskan slot voltmeter
+  if (prio != I2C_PRIO_HIGH && sQCount >= I2C_BUS_QUEUE_MAX - I2C_BUS_HIGH_RESERVE) {
+    ++sDeferred;
+    busUnlock();
+    return false;
+  }
+  for (uint8_t i = 0; i < I2C_BUS_QUEUE_MAX; ++i) {
+    if (sQ[i].used) continue;
+    I2cJob &j = sQ[i];
+    j.fn       = fn;
+    j.arg      = arg;
+    j.enqUs    = micros();
+    j.seq      = sSeq++;
+    j.estBytes = estBytes;
+    j.dev      = dev;
+    j.prio     = prio;
+    j.used     = true;
+    ++sQCount;
+    if (sQCount > sQPeak) sQPeak = sQCount;
+    busUnlock();
+    return true;
+  }
+  ++sDrops;
+  busUnlock();
+  return false;
+}
+
+bool i2cBusRun(I2cDev dev, I2cJobFn fn, uint32_t arg, uint16_t estBytes) {
+  if (!fn) return false;
+  if (!busLock()) return false;
+  bool ok = execute(dev, fn, arg, estBytes, micros());
+  busUnlock();
+  return ok;
+}
+
+// Job dengan prioritas tertinggi (angka terkecil), lalu yang paling lama antre
+static int pickNext(uint8_t minPrio, uint8_t maxPrio) {
+  int best = -1;
+  for (uint8_t i = 0; i < I2C_BUS_QUEUE_MAX; ++i) {
+    const I2cJob &j = sQ[i];
+    if (!j.used || j.prio < minPrio || j.prio > maxPrio) continue;
+    if (best < 0 || j.prio < sQ[best].prio ||
+        (j.prio == sQ[best].prio && (int32_t)(j.seq - sQ[best].seq) < 0)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+static void runSlot(int idx) {
+  I2cJob j = sQ[idx];
+  sQ[idx].used = false;
+  --sQCount;
+  execute(j.dev, j.fn, j.arg, j.estBytes, j.enqUs);
+}
+
+// Device offline: satu probe alamat saat backoff habis; ACK → online lagi
+static void probeOffline(uint32_t now) {
+  for (uint8_t d = 0; d < (uint8_t)I2cDev::Count; ++d) {
+    DevHealth &h = sHealth[d];
+    if (!h.offline || (int32_t)(now - h.retryAtMs) < 0) continue;
+    uint32_t hz = devClockHz((I2cDev)d);
+    if (hz != sClockHz) {
+      Wire.setClock(hz);
+      sClockHz = hz;
+    }
+    uint32_t t0 = micros();
+    bool ok = i2cBusProbe(DEV_ADDR[d]);
+    sBusyWinUs += micros() - t0;
+    healthOnResult((I2cDev)d, ok);
+  }
+}
+
+// Lock diambil per job (bukan per tick): task safety yang submit/tick di
+// tengah flush OLED menunggu paling lama satu chunk yang sedang jalan
+static bool runNext(uint8_t minPrio, uint8_t maxPrio) {
+  if (!busLock()) return false;
+  int idx = pickNext(minPrio, maxPrio);
+  if (idx >= 0) runSlot(idx);
+  busUnlock();
+  return idx >= 0;
+}
+
+void i2cBusTick(uint32_t now, I2cPrio minPrio, I2cPrio maxPrio) {
+  bool high = minPrio == I2C_PRIO_HIGH;
+  if (maxPrio > I2C_PRIO_HIGH && busLock()) {
+    probeOffline(now);
+    busUnlock();
+  }
+
+  // HIGH selalu habis; job HIGH baru yang disubmit di dalam job ikut jalan
+  while (high && runNext(I2C_PRIO_HIGH, I2C_PRIO_HIGH)) {}
+
+  uint32_t t0 = micros();
+  bool first = true;
+  uint8_t lo = minPrio > I2C_PRIO_NORMAL ? minPrio : I2C_PRIO_NORMAL;
+  while (maxPrio > I2C_PRIO_HIGH) {
+    if (!first && micros() - t0 >= I2C_BUS_TICK_BUDGET_US) {
+      ++sBudgetHits;
+      break;
+    }
+    if (!runNext(lo, maxPrio)) break;
+    first = false;
+    // Voltmeter yang masuk selama job panjang didahulukan
+    while (high && runNext(I2C_PRIO_HIGH, I2C_PRIO_HIGH)) {}
+  }
+
+  if (!busLock()) return;
+  uint32_t winMs = now - sWinStartMs;
+  if (winMs >= 1000) {
+    uint32_t pct = sBusyWinUs / (winMs * 10);
+    sUtilPct = (uint8_t)(pct > 100 ? 100 : pct);
+    sBusyWinUs = 0;
+    sWinStartMs = now;
+  }
+  busUnlock();
+}
+
+void i2cBusGetStats(I2cBusStats &out) {
+  out.clockHz    = I2C_BUS_CLOCK_HZ;
+  out.utilPct    = sUtilPct;
+  out.queue      = sQCount;
+  out.queuePeak  = sQPeak;
+  out.drops      = sDrops;
+  out.deferred   = sDeferred;
+  out.budgetHits = sBudgetHits;
+  out.recoveries = sRecoveries;
+  out.lockTimeouts = sLockTimeouts;
+  for (uint8_t i = 0; i < (uint8_t)I2cDev::Count; ++i) {
+    const DevAcc &d = sDev[i];
+    const DevHealth &h = sHealth[i];
+    I2cDevStats &o = out.dev[i];
+    o.online       = !h.offline;
+    o.backoffMs    = h.offline ? h.backoffMs : 0;
+    o.skipped      = h.skipped;
+    o.offlineCount = h.offlineCount;
+    o.jobs     = d.jobs;
+    o.fails    = d.fails;
+    o.bytes    = d.bytes;
+    o.busyUs   = d.busyUs;
+    o.latMaxUs = d.latMaxUs;
+    o.latAvgUs = d.jobs ? (uint32_t)(d.latSumUs / d.jobs) : 0;
+  }
+}
+
+uint8_t i2cBusQueued() { return sQCount; }
+
+bool i2cBusDevOnline(I2cDev dev) {
+  uint8_t i = (uint8_t)dev;
+  return i < (uint8_t)I2cDev::Count && !sHealth[i].offline;
+}
@@ -7,12 +7,18 @@ HardwareSerial espSerial(2);
 #include <cstring>
 
 #include "state.h"    // NVS, rev/hash, default speaker BIG
+#include "stats.h"    // statistik seumur hidup (jam ON, trip, histogram)
 #include "sensors.h"  // RTC, ADS1115, DS18B20, Analyzer (I2S)
 #include "power.h"    // Relay, speaker power/selector, fan PWM, auto PC
 #include "comms.h"    // UART link + telemetry + command handler (incl. buzz JSON)
 #include "buzzer.h"   // non-blocking scheduler
 #include "ui.h"       // OLED kecil (standby clock, status+VU saat ON)
 #include "ota.h"      // OTA over UART (verifikasi .bin, reboot)
+#include "i2c_bus.h"  // penjadwal transaksi I2C (RTC, ADS1115, OLED)
+#include "sched.h"    // job periodik/one-shot loop + tidur sampai deadline
+#include "tasks.h"    // task safety/ui/analyzer (FreeRTOS) + watchdog
+#include "perf.h"     // profiler siklus CPU per seksi
+#include "shed.h"     // anggaran waktu loop + load shedding
 
 #if LOG_ENABLE
   #define LOGF(...)  do { Serial.printf(__VA_ARGS__); } while (0)
@@ -97,8 +103,11 @@ void appInit() {
   LOGF("\n[%s] %s v%s\n", "BOOT", FW_NAME, FW_VERSION);
 #endif
 
-  // I2C (RTC + ADS1115)
-  Wire.begin(I2C_SDA, I2C_SCL);
+  // Modul mendaftarkan job loop-nya saat init → sched paling awal
+  schedInit();
+
+  // I2C (RTC + ADS1115 + OLED) lewat penjadwal bersama
+  i2cBusInit();
 
   ensureMainRelayOffRaw();
   ensureSpeakerPinsOffRaw();
@@ -111,6 +120,7 @@ void appInit() {
   // Subsystems
   buzzerInit();
   stateInit();
+  statsInit();
   commsInit();       // UART2 link ke Panel
   uiInit();
   checkManualFactoryResetCombo();
@@ -124,26 +134,32 @@ void appInit() {
 #endif
 
   buzzPattern(BuzzPatternId::BOOT);
+
+  // Task safety/ui/analyzer mulai setelah semua modul siap; loopTask ini
+  // menjadi task comms
+  tasksStart();
   LOGF("[INIT] done.\n");
 }
 
 // ---- Loop (dipanggil dari loop()) ------------------------------------------
 void appTick() {
-  static uint32_t lastUi = 0;
   static bool lastAnalyzerEnabled = true;
   static bool lastPowerOn = false;
   static bool lastBtMode = false;
   static bool lastProtectFault = false;
   const uint32_t now = millis();
+  const uint32_t t0  = micros();
 
-  // 1) Service sensor/fan/power/PC auto
-  sensorsTick(now);      // update suhu (heatsink), volt (ADS), analyzer (I2S), VU
-  powerTick(now);        // fan curve, proteksi SMPS (bypass via config), auto PC ON/OFF
+  // 1) Proteksi/voltmeter/kipas ada di task safety; di sini hanya sisi comms
+  { PERF_SCOPE(SensorsTick); sensorsTick(now); }   // jam SQW
+  { PERF_SCOPE(PowerTick);   powerTick(now); }     // log event safety, BT, auto PC ON/OFF
 
   bool powerOn = powerIsOn();
   if (powerOn != lastPowerOn) {
     if (!powerOn) {
       buzzPattern(BuzzPatternId::SHUTDOWN);
+      stateFlush();  // shutdown: jangan biarkan setting menunggu debounce
+      statsFlush(false);
     }
     lastPowerOn = powerOn;
   }
@@ -168,11 +184,7 @@ void appTick() {
   //    - Mode ON: rate = TELEMETRY_HZ_ACTIVE
   //    - Mode STANDBY: rate = TELEMETRY_HZ_STANDBY, sinkron lewat SQW 1 Hz
   bool sqw = sensorsSqwConsumeTick();
-  commsTick(now, sqw);   // internal: kirim Telemetry, proses RX JSON (buzz, setConfig, OTA, dll.)
-
-#if OTA_ENABLE
-  otaTick(now);          // non-blocking OTA state machine
-#endif
+  { PERF_SCOPE(CommsTick); commsTick(now, sqw); }   // internal: kirim Telemetry, proses RX JSON (buzz, setConfig, OTA, dll.)
 
   // Update UI context info
   uiSetInputStatus(powerBtMode(), powerGetSpeakerSelectBig());
@@ -192,20 +204,21 @@ void appTick() {
     }
   }
 
-  // 3) UI kecil di amplifier
-  if (now - lastUi >= 33) {
-    lastUi = now;
-    uiTick(now);            // standby: jam besar; ON: status bar (HH:MM BT/AUX | °C + Volt) + VU
-  }
+  // 3) Job terjadwal: DS18B20, suhu RTC, NVS, statistik
+  { PERF_SCOPE(SchedRun); schedRun(now); }
+  uint32_t iterUs = micros() - t0;
+  tasksIterDone(TaskId::Comms, iterUs);
+  shedLoopSample(millis(), iterUs);
 
-  // 4) Buzzer & NVS
-  buzzTick(now);
-  stateTick();
+  // 4) Tidur sampai deadline job; ISR (tepi GPIO, SQW) membangunkan lebih awal
+  schedIdle(UINT32_MAX);
 }
 
 // ---- Helpers ----------------------------------------------------------------
 void appSafeReboot() {
   LOGF("[SYS] reboot...\n");
+  stateFlush();
+  statsFlush();
   delay(50);
   ESP.restart();
 }
@@ -2,6 +2,10 @@
 #include "config.h"
 #include "comms.h"
 #include "power.h"
+#include "state.h"
+#include "stats.h"
+#include "sched.h"
+#include "trace.h"
 
 #include <Update.h>
 #include <esp_partition.h>
@@ -14,8 +18,7 @@ static size_t    sExpectedSize = 0;
 static uint32_t  sExpectedCrc  = 0;
 static size_t    sWritten      = 0;
 static uint32_t  sCrcRunning   = 0;
-static bool      sRebootPending = false;
-static uint32_t  sRebootAtMs    = 0;
+static SchedId   sRebootJob     = -1;   // one-shot: reboot tertunda setelah otaEnd
 
 // CRC32 tabel (polynomial 0xEDB88320)
 static uint32_t crc32_update(uint32_t crc, const uint8_t *buf, size_t len) {
@@ -50,18 +53,17 @@ void otaInit() {
   sExpectedCrc = 0;
   sWritten = 0;
   sCrcRunning = 0;
-  sRebootPending = false;
-  sRebootAtMs = 0;
+  if (sRebootJob < 0) sRebootJob = schedOnce("reboot", otaTick, 0);
+  schedCancel(sRebootJob);
   commsSetOtaReady(true);
   powerSetOtaActive(false);
 }
 
-void otaTick(uint32_t now) {
-  if (sRebootPending && now >= sRebootAtMs) {
-    sRebootPending = false;
-    delay(50);
-    ESP.restart();
-  }
+void otaTick(uint32_t) {
+  stateFlush();
+  statsFlush();
+  delay(50);
+  ESP.restart();
 }
 
 OtaStatus otaStatus() { return sStatus; }
@@ -100,8 +102,8 @@ bool otaBegin(size_t expectedSize, uint32_t expectedCrc32) {
   sCrcRunning   = 0;
   sStatus       = OtaStatus::InProgress;
   sErr          = "";
-  sRebootPending = false;
-  sRebootAtMs    = 0;
+  schedCancel(sRebootJob);
+  traceEmit(TraceEv::OtaBegin, 0, (uint32_t)expectedSize);
 
   return true;
 }
@@ -117,7 +119,9 @@ int otaWrite(const uint8_t* data, size_t len) {
   size_t remain = (sExpectedSize > sWritten) ? (sExpectedSize - sWritten) : 0;
   if (len > remain) len = remain;
 
+  uint32_t t0 = micros();
   size_t w = Update.write(const_cast<uint8_t*>(data), len);
+  traceSpan(TraceEv::OtaWrite, t0, (uint16_t)w);
   if (w != len) {
     setError(Update.errorString());
     sStatus = OtaStatus::Failed;
@@ -168,6 +172,7 @@ bool otaEnd(bool doReboot) {
 
   sStatus = OtaStatus::Success;
   sErr = "";
+  traceEmit(TraceEv::OtaEnd, 1);
 
   // Kembalikan flag & reboot jika diminta
   if (!doReboot) {
@@ -176,8 +181,7 @@ bool otaEnd(bool doReboot) {
   }
 
   if (doReboot) {
-    sRebootPending = true;
-    sRebootAtMs = millis() + 200;
+    schedArm(sRebootJob, 200);
   }
   return true;
 }
@@ -192,8 +196,8 @@ void otaAbort() {
   sExpectedCrc = 0;
   sWritten = 0;
   sCrcRunning = 0;
-  sRebootPending = false;
-  sRebootAtMs = 0;
+  schedCancel(sRebootJob);
+  traceEmit(TraceEv::OtaEnd, 2);
 
   commsSetOtaReady(true);
   powerSetOtaActive(false);
@@ -0,0 +1,94 @@
+#include "perf.h"
+
+#include <string.h>
+#if defined(ESP_PLATFORM)
+  #include <Arduino.h>
+#endif
+
+struct PerfSlot {
+  uint32_t count;
+  uint32_t minCyc;
+  uint32_t maxCyc;
+  uint64_t sumCyc;
+  uint32_t hist[PERF_HIST_BINS];
+};
+
+static PerfSlot sSlots[(uint8_t)PerfSec::Count];
+
+static const char* const kNames[(uint8_t)PerfSec::Count] = {
+  "sensors", "power_safety", "power", "comms", "sched", "ota_write", "ui", "buzz", "analyzer"
+};
+
+// Bin 2k = [2^k, 1.5·2^k), bin 2k+1 = [1.5·2^k, 2^(k+1))
+static inline uint8_t binOf(uint32_t c) {
+  if (c < 2) return 0;
+  uint8_t o = (uint8_t)(31 - __builtin_clz(c));
+  uint8_t b = (uint8_t)(o * 2 + ((c >> (o - 1)) & 1));
+  return b >= PERF_HIST_BINS ? PERF_HIST_BINS - 1 : b;
+}
+
+uint32_t perfBinLowCyc(uint8_t bin) {
+  uint8_t o = bin / 2;
+  if (o == 0) return 0;
+  return (1UL << o) + ((bin & 1) ? (1UL << (o - 1)) : 0);
+}
+
+void perfRecord(PerfSec s, uint32_t cycles) {
+  PerfSlot &p = sSlots[(uint8_t)s];
+  if (p.count == 0 || cycles < p.minCyc) p.minCyc = cycles;
+  if (cycles > p.maxCyc) p.maxCyc = cycles;
+  p.sumCyc += cycles;
+  ++p.count;
+  ++p.hist[binOf(cycles)];
+}
+
+// Reset dari task comms bisa bertabrakan dengan satu perfRecord di task lain;
+// akibatnya paling banyak satu sampel janggal (hanya untuk diagnostik)
+void perfReset() {
+  memset(sSlots, 0, sizeof(sSlots));
+}
+
+const char* perfName(PerfSec s) {
+  return (uint8_t)s < (uint8_t)PerfSec::Count ? kNames[(uint8_t)s] : "?";
+}
+
+uint32_t perfCyclesPerUs() {
+#if defined(ESP_PLATFORM)
+  return ESP.getCpuFreqMHz();
+#else
+  return 1000;   // ns
+#endif
+}
+
+// Batas atas bin yang memuat persentil pct (dibatasi max agar tidak melebihi
+// sampel terlama)
+static uint32_t percentile(const PerfStats &st, uint8_t pct) {
+  uint32_t need = (uint32_t)(((uint64_t)st.count * pct + 99) / 100);
+  uint32_t acc  = 0;
+  for (uint8_t b = 0; b < PERF_HIST_BINS; ++b) {
+    acc += st.hist[b];
+    if (acc >= need) {
+      if (b + 1 >= PERF_HIST_BINS) return st.maxCyc;
+      uint32_t hi = perfBinLowCyc(b + 1) - 1;
+      return hi < st.maxCyc ? hi : st.maxCyc;
+    }
+  }
+  return st.maxCyc;
+}
+
+bool perfGet(PerfSec s, PerfStats &out) {
+  if ((uint8_t)s >= (uint8_t)PerfSec::Count) return false;
+  const PerfSlot &p = sSlots[(uint8_t)s];
+  out.minCyc = p.minCyc;
+  out.maxCyc = p.maxCyc;
+  out.avgCyc = p.count ? (uint32_t)(p.sumCyc / p.count) : 0;
+  memcpy(out.hist, p.hist, sizeof(out.hist));
+  // Salinan bisa sedikit tidak konsisten (task lain mencatat); jumlah bin
+  // dipakai sebagai total agar persentil tetap dalam histogram
+  uint32_t total = 0;
+  for (uint8_t b = 0; b < PERF_HIST_BINS; ++b) total += out.hist[b];
+  out.count  = total;
+  out.p50Cyc = total ? percentile(out, 50) : 0;
+  out.p99Cyc = total ? percentile(out, 99) : 0;
+  return true;
+}
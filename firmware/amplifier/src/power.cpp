@@ -2,9 +2,20 @@
 #include "config.h"
 #include "state.h"
 #include "sensors.h"
+#include "comms.h"
+#include "stats.h"
+#include "gpio_edge.h"
+#include "i2c_bus.h"
+#include "trace.h"
 
 #include <driver/ledc.h>
 
+#if LOG_ENABLE
+  #define LOGF(...)  do { Serial.printf(__VA_ARGS__); } while (0)
+#else
+  #define LOGF(...)  do {} while (0)
+#endif
+
 // -------------------- Static state --------------------
 static bool   sRelayOn = false;
 static bool   sRelayRequested = false;
@@ -24,11 +35,16 @@ static uint32_t protectLastChangeMs = 0;
 static bool   protectFaultLatched = false;
 static bool   protectFaultLogged = false;
 
+// Latensi proteksi: jarak antar eksekusi smpsProtectTick (µs)
+static uint32_t sProtLastUs   = 0;
+static uint32_t sProtMaxGapUs = 0;
+
 static uint32_t btLastEnteredBtMs = 0;  // reset timer auto-off ketika masuk BT
 static uint32_t btLastAuxMs       = 0;  // melacak lama berada di AUX
 
-// AUX→BT membutuhkan LOW stabil >= 3s, jika SUDAH BT lalu HIGH → segera AUX
-static uint32_t btLowSinceMs      = 0;
+// AUX→BT membutuhkan LOW stabil >= 3s (dihitung dari tepi LOW, tidak lebih
+// awal dari modul menyala), jika SUDAH BT lalu HIGH → segera AUX
+static uint32_t btHwOnMs          = 0;
 
 // PC detect
 static bool     pcOn = false;
@@ -44,103 +60,272 @@ static bool     fanBootTestDone = false;
 static bool     smpsFaultLatched = false;
 static bool     smpsCutActive    = false;
 
+// Trip hardware via ALERT ADS1115: ISR membuka relay, loop menyusul statusnya
+static volatile bool     sHwArmed   = false;
+static volatile bool     sHwTripped = false;
+static volatile uint32_t sHwTripUs  = 0;
+static volatile uint32_t sHwConvUs  = 0;   // mulai konversi yang memicu ALERT
+static uint32_t sHwTrips     = 0;
+static uint32_t sSwTrips     = 0;
+static uint32_t sHwLatLastUs = 0;
+static uint32_t sHwLatMaxUs  = 0;
+static uint32_t sHwAckMaxUs  = 0;
+
+
+// Hook proteksi rail tambahan (sekuencer ADS): batas per channel, NAN = off
+struct RailLimit { float lo; float hi; };
+static const RailLimit RAIL_LIMITS[ADS_NUM_CH] = {
+  { NAN, NAN },   // ch0 = SMPS, lewat smpsProtectTick + comparator
+  { ADS_NEG_TRIP_MIN,   ADS_NEG_TRIP_MAX },
+  { ADS_AUX12_TRIP_MIN, ADS_AUX12_TRIP_MAX },
+  { ADS_SHUNT_TRIP_MIN, ADS_SHUNT_TRIP_MAX },
+};
+static uint8_t  sRailBad[ADS_NUM_CH];
+static uint8_t  sRailFaultMask = 0;
+
+// State relay/proteksi diubah task safety dan task comms (command, auto PC)
+// → mutex dengan priority inheritance
+static SemaphoreHandle_t sLock = nullptr;
+
+static inline void powerLock() {
+  if (sLock) xSemaphoreTake(sLock, portMAX_DELAY);
+}
+
+static inline void powerUnlock() {
+  if (sLock) xSemaphoreGive(sLock);
+}
+
+// Event task safety → log di task comms (commsLog tidak thread-safe)
+enum class SafetyEvt : uint8_t {
+  SmpsHwTrip = 0,
+  RailTrip,
+  SpkFault,
+  SpkClear,
+  ThermalHot,
+  ThermalOk,
+};
+static QueueHandle_t sEvtQ = nullptr;
+static uint32_t      sEvtDrops = 0;
+
+static void safetyPost(SafetyEvt e) {
+  if (!sEvtQ || xQueueSend(sEvtQ, &e, 0) != pdTRUE) ++sEvtDrops;
+}
+
+// Thermal supervisor: probe terpanas ≥ SAFETY_HEAT_FULL_FAN_C → kipas penuh
+static bool     sThermalHot = false;
 
 // -------------------- Helpers --------------------
-static inline void _writeRelay(bool on) {
+static inline void IRAM_ATTR _writeRelayPin(bool on) {
 #if RELAY_MAIN_ACTIVE_HIGH
   digitalWrite(RELAY_MAIN_PIN, on ? HIGH : LOW);
 #else
   digitalWrite(RELAY_MAIN_PIN, on ? LOW : HIGH);
 #endif
+}
+
+static inline void _writeRelay(bool on) {
+  _writeRelayPin(on);
   sRelayOn = on;
 }
 
+static void IRAM_ATTR onAdsAlert() {
+  if (sensorsAdsAlertIsr()) return;   // scope: pulsa conversion-ready
+  if (!sHwArmed) return;
+  _writeRelayPin(false);
+  sHwArmed   = false;
+  sHwTripUs  = micros();
+  sHwConvUs  = sensorsAdsConvStartUs();
+  sHwTripped = true;
+}
+
 static inline void applyRelay(bool on) {
+  if (!on) sHwArmed = false;
   _writeRelay(on);
   powerSetOn(on);
+  statsOnRelay(on);
+  traceEmit(TraceEv::Relay, on);
 }
 
-static inline bool _readBtStatusActiveLow() {
-  int val = digitalRead(BT_STATUS_PIN);
-  if (BT_STATUS_ACTIVE_LOW) {
-    return val == LOW;
-  }
-  return val == HIGH;
+// Level input dari lapisan edge capture (ISR), bukan digitalRead per loop
+static inline bool _btStatusActive() {
+  bool high = gpioEdgeLevel(EdgeSrc::BtStatus);
+  return BT_STATUS_ACTIVE_LOW ? !high : high;
 }
 
-static inline bool _readSpkProtectLedActiveHigh() {
+static inline bool _spkProtectLedOn() {
   // true jika LED ON (normal), false jika LED OFF (potensi fault)
-#if SPK_PROTECT_ACTIVE_HIGH
-  return digitalRead(SPK_PROTECT_LED_PIN) == HIGH;
-#else
-  return digitalRead(SPK_PROTECT_LED_PIN) == LOW;
-#endif
+  bool high = gpioEdgeLevel(EdgeSrc::SpkLed);
+  return SPK_PROTECT_ACTIVE_HIGH ? high : !high;
 }
 
-static inline bool _readPcDetectActiveLow() {
-#if PC_DETECT_ACTIVE_LOW
-  return digitalRead(PC_DETECT_PIN) == LOW;
-#else
-  return digitalRead(PC_DETECT_PIN) == HIGH;
-#endif
+static inline bool _pcDetectActive() {
+  bool high = gpioEdgeLevel(EdgeSrc::PcDetect);
+  return PC_DETECT_ACTIVE_LOW ? !high : high;
 }
 
 static inline uint32_t ms() { return millis(); }
 
-// Fan duty 0..1023
+// Fan duty 0..1023; LEDC hanya ditulis bila duty berubah
+static FanCtrl  sFan;
+static uint32_t sFanCurveRev = 0;
+static uint32_t sFanLastMs   = 0;
+static uint16_t sFanDuty     = 0xFFFF;   // duty terpasang di LEDC
+static uint32_t sFanWrites   = 0;
+
 static inline void fanWriteDuty(uint16_t duty) {
   if (duty > 1023) duty = 1023;
+  if (duty == sFanDuty) return;
+  sFanDuty = duty;
   ledcWrite(FAN_PWM_CH, duty);
+  ++sFanWrites;
+  statsOnFanDuty(duty);
+  traceEmit(TraceEv::FanDuty, duty);
 }
 
-// Linear map T → duty (t1..t2..t3)
-static uint16_t fanCurveAuto(float tC) {
-  if (isnan(tC)) {
-    // sensor gagal → pilih duty aman sedang
-    return (FAN_AUTO_D1 + FAN_AUTO_D2) / 2;
-  }
-  if (tC <= FAN_AUTO_T1_C) return FAN_AUTO_D1;
-  if (tC >= FAN_AUTO_T3_C) return FAN_AUTO_D3;
+static void fanCtrlSetup() {
+  FanCtrlParams p;
+  p.pi           = stateFanPi();
+  p.setpointC    = FAN_PI_SETPOINT_C;
+  p.kp           = FAN_PI_KP;
+  p.ki           = FAN_PI_KI;
+  p.integMax     = FAN_PI_INTEG_MAX;
+  p.hystC        = FAN_HYST_C;
+  p.slewUpPerS   = FAN_SLEW_UP_PER_S;
+  p.slewDownPerS = FAN_SLEW_DOWN_PER_S;
+  p.deadband     = FAN_DUTY_DEADBAND;
+  p.failDuty     = FAN_SENSOR_FAIL_DUTY;
+  FanCurve curve;
+  stateGetFanCurve(curve);   // sebelum task jalan: belum ada penulis lain
+  fanCtrlInit(sFan, p, curve);
+  sFanCurveRev = stateFanCurveRev();
+}
 
-  if (tC <= FAN_AUTO_T2_C) {
-    // T1..T2
-    float f = (tC - FAN_AUTO_T1_C) / (FAN_AUTO_T2_C - FAN_AUTO_T1_C);
-    return (uint16_t)(FAN_AUTO_D1 + f * (FAN_AUTO_D2 - FAN_AUTO_D1));
-  } else {
-    // T2..T3
-    float f = (tC - FAN_AUTO_T2_C) / (FAN_AUTO_T3_C - FAN_AUTO_T2_C);
-    return (uint16_t)(FAN_AUTO_D2 + f * (FAN_AUTO_D3 - FAN_AUTO_D2));
+// Task safety tiap FAN_CTRL_PERIOD_MS (suhu sendiri baru tiap ~1 s)
+static void fanTick(uint32_t now) {
+  if (sFanLastMs != 0 && now - sFanLastMs < FAN_CTRL_PERIOD_MS) return;
+  float dtS = sFanLastMs != 0 ? (now - sFanLastMs) / 1000.0f : 0.0f;
+  sFanLastMs = now;
+
+  // Kurva ditulis task comms (seqlock): salinan setengah jadi ditolak,
+  // dicoba lagi periode berikutnya
+  if (sFanCurveRev != stateFanCurveRev()) {
+    FanCurve curve;
+    uint32_t rev;
+    if (stateSnapshotFanCurve(curve, rev)) {
+      fanCtrlSetCurve(sFan, curve);
+      sFanCurveRev = rev;
+    }
   }
-}
+  sFan.p.pi = stateFanPi();
 
-static void fanTick() {
-  FanMode m = stateGetFanMode();
   uint16_t duty = 0;
-
-  switch (m) {
-    case FanMode::AUTO: {
-      float t = getHeatsinkC();             // Celsius (NAN jika belum valid)
-      duty = fanCurveAuto(t);
+  switch (safeModeActive ? FanMode::FAILSAFE : stateGetFanMode()) {
+    case FanMode::AUTO:
+      // Probe terpanas; ada probe gagal → minimal duty aman
+      duty = fanCtrlStep(sFan, sensorsTempMaxC(), dtS);
+      if (sensorsTempFault() && duty < FAN_SENSOR_FAIL_DUTY) {
+        duty = FAN_SENSOR_FAIL_DUTY;
+        fanCtrlTrack(sFan, duty);
+      }
       break;
-    }
     case FanMode::CUSTOM:
       duty = stateGetFanCustomDuty();
+      fanCtrlTrack(sFan, duty);
       break;
     case FanMode::FAILSAFE:
     default:
-      duty = FAN_FALLBACK_DUTY;
+      duty = safeModeActive ? 0 : FAN_FALLBACK_DUTY;
+      fanCtrlTrack(sFan, duty);
       break;
   }
 
+  // Override di semua mode (termasuk CUSTOM/safe mode); lepas setelah turun FAN_HYST_C
+  float tMax = sensorsTempMaxC();
+  bool hot = !isnan(tMax) &&
+             (tMax >= SAFETY_HEAT_FULL_FAN_C || (sThermalHot && tMax > SAFETY_HEAT_FULL_FAN_C - FAN_HYST_C));
+  if (hot != sThermalHot) {
+    sThermalHot = hot;
+    safetyPost(hot ? SafetyEvt::ThermalHot : SafetyEvt::ThermalOk);
+  }
+  if (hot) {
+    duty = 1023;
+    fanCtrlTrack(sFan, duty);
+  }
+
   fanWriteDuty(duty);
 }
 
+void powerGetFanStats(FanStats &out) {
+  out.duty   = sFanDuty > 1023 ? 0 : sFanDuty;
+  out.writes = sFanWrites;
+  out.pi     = sFan.p.pi;
+  out.tEffC  = sFan.primed ? sFan.tEff : NAN;
+  out.integ  = sFan.integ;
+  out.lutMin = sFan.lut[0];
+  out.lutMax = sFan.lut[FAN_LUT_SIZE - 1];
+  out.hot    = sThermalHot;
+}
+
+uint32_t powerSafetyEvtDrops() {
+  return sEvtDrops;
+}
+
 static void applyBtHardware() {
   bool shouldOn = sBtEn && powerIsOn() && !safeModeActive;
   if (shouldOn != sBtHwOn) {
     digitalWrite(BT_ENABLE_PIN, shouldOn ? HIGH : LOW);
     sBtHwOn = shouldOn;
+    if (shouldOn) btHwOnMs = ms();
+    traceEmit(TraceEv::BtHw, shouldOn);
+  }
+}
+
+static void onRailSample(uint8_t ch, float v) {
+  const RailLimit &lim = RAIL_LIMITS[ch];
+  bool out = (!isnan(lim.lo) && v < lim.lo) || (!isnan(lim.hi) && v > lim.hi);
+  if (!FEAT_SMPS_PROTECT_ENABLE || stateSmpsBypass() || !sRelayOn || !out) {
+    sRailBad[ch] = 0;
+    return;
+  }
+  if (++sRailBad[ch] < ADS_RAIL_TRIP_SAMPLES) return;
+  sRailBad[ch] = 0;
+  powerLock();
+  sRailFaultMask |= (uint8_t)(1u << ch);
+  traceEmit(TraceEv::SmpsTrip, 2, (uint32_t)(v * 1000.0f));
+  applyRelay(false);
+  powerUnlock();
+  safetyPost(SafetyEvt::RailTrip);
+}
+
+// Relay sudah dibuka ISR; samakan status software + catat latensi
+static void smpsHwTripService() {
+  if (!sHwTripped) return;
+  sHwTripped = false;
+  uint32_t tripUs = sHwTripUs;
+  uint32_t lat = tripUs - sHwConvUs;        // mulai konversi → relay dibuka
+  uint32_t ack = micros() - tripUs;         // ISR → loop menyusul
+  sHwLatLastUs = lat;
+  if (lat > sHwLatMaxUs) sHwLatMaxUs = lat;
+  if (ack > sHwAckMaxUs) sHwAckMaxUs = ack;
+  ++sHwTrips;
+  if (!smpsCutActive) {
+    smpsCutActive = true;
+    smpsFaultLatched = true;
+    statsOnSmpsTrip();
   }
+  traceEmit(TraceEv::SmpsTrip, 1, (uint32_t)(getVoltageInstant() * 1000.0f));
+  applyRelay(false);
+  safetyPost(SafetyEvt::SmpsHwTrip);
+}
+
+// Comparator hanya di-arm setelah rail terlihat di atas cutoff oleh loop,
+// sama seperti syarat v > 0 pada jalur software.
+static void smpsHwTripArm() {
+  if (!FEAT_SMPS_HW_TRIP) return;
+  float cutoff = stateSmpsCutoffV();
+  sensorsSetUvTripV(cutoff);
+  sHwArmed = FEAT_SMPS_PROTECT_ENABLE && !stateSmpsBypass() && !sensorsAdsRdyMode() && sRelayRequested &&
+             sRelayOn && !smpsCutActive && getVoltageInstant() >= cutoff;
 }
 
 static void smpsProtectTick() {
@@ -178,13 +363,16 @@ static void smpsProtectTick() {
   if (!smpsCutActive && sRelayOn && v > 0.0f && v < cutoff) {
     smpsCutActive = true;
     smpsFaultLatched = true;
+    traceEmit(TraceEv::SmpsTrip, 0, (uint32_t)(v * 1000.0f));
     applyRelay(false);
+    statsOnSmpsTrip();
+    ++sSwTrips;
   }
 
   if (smpsCutActive && v >= recover) {
     smpsCutActive = false;
     smpsFaultLatched = false;
-    if (sRelayRequested) {
+    if (sRelayRequested && sRailFaultMask == 0) {
       applyRelay(true);
     }
   }
@@ -193,6 +381,8 @@ static void smpsProtectTick() {
 // -------------------- Public API --------------------
 void powerInit() {
   safeModeActive = stateSafeModeSoft();
+  if (!sLock) sLock = xSemaphoreCreateMutex();
+  if (!sEvtQ) sEvtQ = xQueueCreate(SAFETY_EVT_QUEUE_LEN, sizeof(SafetyEvt));
 
   // Relay
   pinMode(RELAY_MAIN_PIN, OUTPUT);
@@ -201,6 +391,20 @@ void powerInit() {
   smpsCutActive = false;
   smpsFaultLatched = false;
 
+  sRailFaultMask = 0;
+  for (uint8_t ch = 1; ch < ADS_NUM_CH; ++ch) {
+    sRailBad[ch] = 0;
+    if (!isnan(RAIL_LIMITS[ch].lo) || !isnan(RAIL_LIMITS[ch].hi)) {
+      sensorsSetAdsHook(ch, onRailSample);
+    }
+  }
+
+#if FEAT_SMPS_HW_TRIP || ADS_SCOPE_CONTINUOUS
+  // ALERT open-drain; pull-up eksternal disarankan (internal sebagai cadangan)
+  pinMode(ADS_ALERT_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(ADS_ALERT_PIN), onAdsAlert, FALLING);
+#endif
+
   // Speaker control
   pinMode(SPEAKER_POWER_SWITCH_PIN, OUTPUT);
   pinMode(SPEAKER_SELECTOR_PIN, OUTPUT);
@@ -211,27 +415,29 @@ void powerInit() {
   digitalWrite(SPEAKER_SELECTOR_PIN, sSpkBig ? HIGH : LOW);
   digitalWrite(SPEAKER_POWER_SWITCH_PIN, sSpkPwr ? HIGH : LOW);
 
+  // Input status (BT, PC detect, LED protector) → edge capture ISR
+  pinMode(BT_STATUS_PIN, INPUT);
+  pinMode(PC_DETECT_PIN, PC_DETECT_INPUT_PULL);
+  pinMode(SPK_PROTECT_LED_PIN, INPUT);
+  gpioEdgeInit();
+
   // BT
   pinMode(BT_ENABLE_PIN, OUTPUT);
-  pinMode(BT_STATUS_PIN, INPUT);
   sBtEn = stateBtEnabled();
   uint32_t now = ms();
-  sBtMode = (FEAT_BT_AUTOSWITCH_AUX && sBtHwOn) ? _readBtStatusActiveLow() : false;
+  sBtMode = (FEAT_BT_AUTOSWITCH_AUX && sBtHwOn) ? _btStatusActive() : false;
   btLastEnteredBtMs = sBtMode ? now : 0;
   btLastAuxMs       = sBtMode ? 0   : now;
-  btLowSinceMs      = sBtMode ? now : 0;
 
   // PC detect
-  pinMode(PC_DETECT_PIN, PC_DETECT_INPUT_PULL);
-  pcRaw = _readPcDetectActiveLow();
+  pcRaw = _pcDetectActive();
   pcOn = pcRaw;
   pcLastRawMs = now;
   pcGraceUntilMs = now + PC_DETECT_GRACE_MS;
   pcOffSchedAt = 0;
 
   // Speaker protector LED monitor
-  pinMode(SPK_PROTECT_LED_PIN, INPUT);
-  sSpkProtectOk = _readSpkProtectLedActiveHigh();
+  sSpkProtectOk = _spkProtectLedOn();
   protectLastChangeMs = now;
   protectFaultLatched = false;
 
@@ -245,7 +451,9 @@ void powerInit() {
     delay(FAN_BOOT_TEST_MS);
   }
   fanBootTestDone = true;
-  fanTick();
+  fanCtrlSetup();
+  fanCtrlTrack(sFan, sFanDuty > 1023 ? 0 : sFanDuty);
+  fanTick(now);
 
   applyBtHardware();
 
@@ -260,44 +468,80 @@ void powerInit() {
   }
 }
 
-void powerTick(uint32_t now) {
-  // ---------------- Fan control ----------------
-  fanTick();
-  if (safeModeActive) {
-    fanWriteDuty(0);
+// Task safety (periode SAFETY_PERIOD_MS, prioritas tertinggi): voltmeter,
+// proteksi SMPS/rail, LED protector, kipas/thermal. Tidak memanggil comms.
+void powerSafetyTick(uint32_t now) {
+  uint32_t nowUs = micros();
+  if (sProtLastUs != 0 && nowUs - sProtLastUs > sProtMaxGapUs) {
+    sProtMaxGapUs = nowUs - sProtLastUs;
   }
+  sProtLastUs = nowUs;
+  // I2C di luar powerLock: tunggu bus tidak ikut menahan command relay;
+  // hook rail mengambil lock sendiri
+  sensorsSafetyTick(now);
+  i2cBusTick(now, I2C_PRIO_HIGH, I2C_PRIO_HIGH);
+  powerLock();
+  smpsHwTripService();
   smpsProtectTick();
+  smpsHwTripArm();
+  powerUnlock();
+
+  // Event tepi dari ISR; waktu tepi = awal jendela debounce/latch
+  gpioEdgeService(now);
 
   // ---------------- Speaker protector monitor ----------------
-  bool ok = _readSpkProtectLedActiveHigh();
+  bool ok = _spkProtectLedOn();
   if (ok != sSpkProtectOk) {
     sSpkProtectOk = ok;
-    protectLastChangeMs = now;
-  } else {
-    if (!sSpkProtectOk && !protectFaultLatched) {
-      if (now - protectLastChangeMs >= SPK_PROTECT_FAULT_MS) {
-        protectFaultLatched = true;
-      }
-    }
-    if (sSpkProtectOk && protectFaultLatched) {
-      protectFaultLatched = false;
+    protectLastChangeMs = gpioEdgeSinceMs(EdgeSrc::SpkLed);
+    traceEmit(TraceEv::SpkProtect, ok);
+  }
+  if (!sSpkProtectOk && !protectFaultLatched) {
+    if (now - protectLastChangeMs >= SPK_PROTECT_FAULT_MS) {
+      protectFaultLatched = true;
+      statsOnSpkFault();
     }
   }
+  if (sSpkProtectOk && protectFaultLatched) {
+    protectFaultLatched = false;
+  }
   if (protectFaultLatched != protectFaultLogged) {
     protectFaultLogged = protectFaultLatched;
-#if LOG_ENABLE
-    LOGF(protectFaultLatched ? "[PROTECT] speaker_fail\n" : "[PROTECT] speaker_clear\n");
-#endif
+    safetyPost(protectFaultLatched ? SafetyEvt::SpkFault : SafetyEvt::SpkClear);
+  }
+
+  // ---------------- Fan / thermal ----------------
+  fanTick(now);
+}
+
+// Kuras event task safety (konteks comms)
+static void safetyEventsService() {
+  SafetyEvt e;
+  while (sEvtQ && xQueueReceive(sEvtQ, &e, 0) == pdTRUE) {
+    switch (e) {
+      case SafetyEvt::SmpsHwTrip: commsLog("warn", "smps_hw_trip"); break;
+      case SafetyEvt::RailTrip:   commsLog("warn", "rail_trip"); break;
+      case SafetyEvt::ThermalHot: commsLog("warn", "thermal_full_fan"); break;
+      case SafetyEvt::ThermalOk:  commsLog("info", "thermal_ok"); break;
+      case SafetyEvt::SpkFault:   LOGF("[PROTECT] speaker_fail\n"); break;
+      case SafetyEvt::SpkClear:   LOGF("[PROTECT] speaker_clear\n"); break;
+    }
   }
+}
+
+void powerTick(uint32_t now) {
+  safetyEventsService();
 
   // ---------------- BT logic (real-time) ----------------
   if (FEAT_BT_AUTOSWITCH_AUX && sBtHwOn) {
-    bool lowNow = _readBtStatusActiveLow();
+    bool lowNow = _btStatusActive();
     if (lowNow) {
       if (!sBtMode) {
-        if (btLowSinceMs == 0) btLowSinceMs = now;
-        if ((now - btLowSinceMs) >= AUX_TO_BT_LOW_MS) {
+        uint32_t lowSince = gpioEdgeSinceMs(EdgeSrc::BtStatus);
+        if ((int32_t)(lowSince - btHwOnMs) < 0) lowSince = btHwOnMs;
+        if ((now - lowSince) >= AUX_TO_BT_LOW_MS) {
           sBtMode = true;
+          traceEmit(TraceEv::BtMode, 1);
           btLastEnteredBtMs = now;
           btLastAuxMs = 0;
         }
@@ -306,9 +550,9 @@ void powerTick(uint32_t now) {
         btLastAuxMs = 0;
       }
     } else {
-      btLowSinceMs = 0;
       if (sBtMode) {
         sBtMode = false;
+        traceEmit(TraceEv::BtMode, 0);
         btLastAuxMs = now;
       } else if (btLastAuxMs == 0) {
         btLastAuxMs = now;
@@ -328,10 +572,10 @@ void powerTick(uint32_t now) {
 
   // ---------------- Auto power via PC detect ----------------
   if (FEAT_PC_DETECT_ENABLE && !sOta && !safeModeActive) {
-    bool raw = _readPcDetectActiveLow();
+    bool raw = _pcDetectActive();
     if (raw != pcRaw) {
       pcRaw = raw;
-      pcLastRawMs = now;
+      pcLastRawMs = gpioEdgeSinceMs(EdgeSrc::PcDetect);
     }
     if ((now - pcLastRawMs) >= PC_DETECT_DEBOUNCE_MS) {
       if (raw != pcOn) {
@@ -357,6 +601,7 @@ void powerTick(uint32_t now) {
 
 // ---------------- Relay ----------------
 void powerSetMainRelay(bool on) {
+  powerLock();
   sRelayRequested = on;
   if (safeModeActive) {
     on = false;
@@ -364,8 +609,10 @@ void powerSetMainRelay(bool on) {
   if (!on) {
     smpsCutActive = false;
     smpsFaultLatched = false;
+    sRailFaultMask = 0;
   }
   applyRelay(on);
+  powerUnlock();
   if (on && FEAT_PC_DETECT_ENABLE) {
     pcGraceUntilMs = ms() + PC_DETECT_GRACE_MS;
   }
@@ -397,13 +644,12 @@ void powerSetBtEnabled(bool en) {
   uint32_t now = ms();
   applyBtHardware();
   if (en && sBtHwOn) {
-    sBtMode = _readBtStatusActiveLow();
-    btLowSinceMs = sBtMode ? now : 0;
+    sBtMode = _btStatusActive();
+    traceEmit(TraceEv::BtMode, sBtMode);
     btLastEnteredBtMs = sBtMode ? now : 0;
     btLastAuxMs = sBtMode ? 0 : now;
   }
   if (!en) {
-    btLowSinceMs = 0;
     btLastEnteredBtMs = 0;
     btLastAuxMs = now;
   }
@@ -422,7 +668,28 @@ bool powerSpkProtectFault() {
   return protectFaultLatched;
 }
 
+uint8_t powerRailFaultMask() {
+  return sRailFaultMask;
+}
+
 // ---------------- Input mode string ----------------
 const char* powerInputModeStr() {
   return sBtMode ? "bt" : "aux";
-}
\ No newline at end of file
+}
+
+// ---------------- Latensi proteksi ----------------
+uint32_t powerProtectMaxGapUs(bool reset) {
+  uint32_t v = sProtMaxGapUs;
+  if (reset) sProtMaxGapUs = 0;
+  return v;
+}
+
+void powerGetSmpsTripStats(SmpsTripStats &out) {
+  out.hwEnabled = FEAT_SMPS_HW_TRIP;
+  out.armed     = sHwArmed;
+  out.hwTrips   = sHwTrips;
+  out.swTrips   = sSwTrips;
+  out.latLastUs = sHwLatLastUs;
+  out.latMaxUs  = sHwLatMaxUs;
+  out.ackMaxUs  = sHwAckMaxUs;
+}
@@ -0,0 +1,167 @@
+#include "sched.h"
+#include "config.h"
+
+struct SchedJob {
+  const char *name;
+  SchedFn  fn;
+  uint32_t periodMs;
+  uint32_t budgetUs;
+  uint32_t dueMs;
+  bool     armed;
+  // statistik
+  uint32_t runs;
+  uint32_t late;
+  uint32_t overruns;
+  uint32_t skipped;
+  uint32_t maxUs;
+  uint32_t lateMaxMs;
+};
+
+static SchedJob     sJobs[SCHED_MAX_JOBS];
+static uint8_t      sCount    = 0;
+static TaskHandle_t sLoopTask = nullptr;
+
+// Jendela 1 detik untuk loops/s & porsi tidur
+static uint32_t sWinStartMs = 0;
+static uint32_t sWinLoops   = 0;
+static uint32_t sWinSleepUs = 0;
+static uint16_t sLoopsPerS  = 0;
+static uint8_t  sSleepPct   = 0;
+static uint32_t sIsrWakes   = 0;
+
+static SchedId addJob(const char *name, SchedFn fn, uint32_t periodMs, uint32_t budgetUs) {
+  if (!fn || sCount >= SCHED_MAX_JOBS) return -1;
+  SchedJob &j = sJobs[sCount];
+  memset(&j, 0, sizeof(j));
+  j.name     = name;
+  j.fn       = fn;
+  j.periodMs = periodMs;
+  j.budgetUs = budgetUs;
+  j.dueMs    = millis() + periodMs;
+  j.armed    = periodMs > 0;
+  return (SchedId)sCount++;
+}
+
+SchedId schedEvery(const char *name, SchedFn fn, uint32_t periodMs, uint32_t budgetUs) {
+  return addJob(name, fn, periodMs > 0 ? periodMs : 1, budgetUs);
+}
+
+SchedId schedOnce(const char *name, SchedFn fn, uint32_t budgetUs) {
+  return addJob(name, fn, 0, budgetUs);
+}
+
+void schedArm(SchedId id, uint32_t delayMs) {
+  if (id < 0 || id >= sCount) return;
+  sJobs[id].dueMs = millis() + delayMs;
+  sJobs[id].armed = true;
+}
+
+void schedCancel(SchedId id) {
+  if (id < 0 || id >= sCount) return;
+  sJobs[id].armed = false;
+}
+
+bool schedArmed(SchedId id) {
+  return id >= 0 && id < sCount && sJobs[id].armed;
+}
+
+void schedInit() {
+  sLoopTask   = xTaskGetCurrentTaskHandle();
+  sWinStartMs = millis();
+}
+
+void schedRun(uint32_t now) {
+  for (uint8_t i = 0; i < sCount; ++i) {
+    SchedJob &j = sJobs[i];
+    if (!j.armed) continue;
+    int32_t lateMs = (int32_t)(now - j.dueMs);
+    if (lateMs < 0) continue;
+
+    if ((uint32_t)lateMs > SCHED_LATE_MS) ++j.late;
+    if ((uint32_t)lateMs > j.lateMaxMs) j.lateMaxMs = (uint32_t)lateMs;
+    // Deadline berikut diset sebelum fn agar one-shot boleh arm ulang dirinya
+    if (j.periodMs > 0) {
+      j.dueMs += j.periodMs;
+      if ((int32_t)(now - j.dueMs) >= 0) {
+        j.skipped += (now - j.dueMs) / j.periodMs + 1;
+        j.dueMs = now + j.periodMs;
+      }
+    } else {
+      j.armed = false;
+    }
+
+    uint32_t t0 = micros();
+    j.fn(now);
+    uint32_t us = micros() - t0;
+    ++j.runs;
+    if (j.budgetUs > 0 && us > j.budgetUs) ++j.overruns;
+    if (us > j.maxUs) j.maxUs = us;
+  }
+}
+
+static uint32_t nextDueUs(uint32_t now) {
+  uint32_t best = UINT32_MAX;
+  for (uint8_t i = 0; i < sCount; ++i) {
+    const SchedJob &j = sJobs[i];
+    if (!j.armed) continue;
+    int32_t dt = (int32_t)(j.dueMs - now);
+    if (dt <= 0) return 0;
+    if ((uint32_t)dt * 1000UL < best) best = (uint32_t)dt * 1000UL;
+  }
+  return best;
+}
+
+void schedIdle(uint32_t maxWaitUs) {
+  uint32_t now = millis();
+  ++sWinLoops;
+  uint32_t winMs = now - sWinStartMs;
+  if (winMs >= 1000) {
+    sLoopsPerS  = (uint16_t)(sWinLoops > 65535 ? 65535 : sWinLoops * 1000UL / winMs);
+    uint32_t pct = sWinSleepUs / (winMs * 10);
+    sSleepPct   = (uint8_t)(pct > 100 ? 100 : pct);
+    sWinLoops   = 0;
+    sWinSleepUs = 0;
+    sWinStartMs = now;
+  }
+
+  uint32_t waitUs = nextDueUs(now);
+  if (maxWaitUs < waitUs) waitUs = maxWaitUs;
+  if (waitUs > SCHED_MAX_SLEEP_MS * 1000UL) waitUs = SCHED_MAX_SLEEP_MS * 1000UL;
+  // Bulatkan ke bawah: tick berikutnya bisa datang < 1 periode lagi, jadi
+  // tidur N tick tidak pernah melewati deadline
+  TickType_t ticks = waitUs / (portTICK_PERIOD_MS * 1000UL);
+  if (ticks == 0 || !sLoopTask) return;
+
+  uint32_t t0 = micros();
+  if (ulTaskNotifyTake(pdTRUE, ticks) > 0) ++sIsrWakes;
+  sWinSleepUs += micros() - t0;
+}
+
+void IRAM_ATTR schedWakeFromIsr() {
+  if (!sLoopTask) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(sLoopTask, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+void schedGetStats(SchedStats &out) {
+  out.loopsPerS = sLoopsPerS;
+  out.sleepPct  = sSleepPct;
+  out.isrWakes  = sIsrWakes;
+  out.jobs      = sCount;
+}
+
+bool schedGetJobStats(uint8_t idx, SchedJobStats &out) {
+  if (idx >= sCount) return false;
+  const SchedJob &j = sJobs[idx];
+  out.name      = j.name;
+  out.periodMs  = j.periodMs;
+  out.budgetUs  = j.budgetUs;
+  out.runs      = j.runs;
+  out.late      = j.late;
+  out.overruns  = j.overruns;
+  out.skipped   = j.skipped;
+  out.maxUs     = j.maxUs;
+  out.lateMaxMs = j.lateMaxMs;
+  return true;
+}
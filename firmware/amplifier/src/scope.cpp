@@ -0,0 +1,179 @@
+#include "scope.h"
+#include "config.h"
+
+static int16_t  sBuf[SCOPE_BUF_SAMPLES];
+static uint16_t sHead   = 0;     // slot tulis berikutnya
+static uint16_t sFill   = 0;     // sampel valid di ring (≤ SCOPE_BUF_SAMPLES)
+static ScopeState sState = ScopeState::Idle;
+
+static int16_t  sTrigCode  = INT16_MIN;
+static uint16_t sPreWant   = 0;
+static uint16_t sTotal     = 0;
+static uint16_t sPostLeft  = 0;
+static uint16_t sPre       = 0;   // pre aktual saat trigger
+static bool     sManual    = false;
+static bool     sManualReq = false;
+static bool     sDoneEvt   = false;
+
+static uint32_t sLastUs    = 0;
+static uint32_t sTrigUs    = 0;
+static uint32_t sEndUs     = 0;
+static uint32_t sMaxGapUs  = 0;
+static uint32_t sTrigMs    = 0;
+
+// Statistik berjalan (jendela aktif + hasil jendela terakhir)
+static int16_t  sWinMin = INT16_MAX;
+static int16_t  sWinMax = INT16_MIN;
+static int32_t  sWinSum = 0;
+static uint32_t sWinN   = 0;
+static uint32_t sWinStartUs = 0;
+static ScopeRunStats sRun = {};
+
+const char* scopeStateToStr(ScopeState s) {
+  switch (s) {
+    case ScopeState::Armed:     return "armed";
+    case ScopeState::Triggered: return "triggered";
+    case ScopeState::Done:      return "done";
+    case ScopeState::Idle:
+    default:                    return "idle";
+  }
+}
+
+void scopeInit() {
+  sState = ScopeState::Idle;
+  sHead = 0;
+  sFill = 0;
+  sDoneEvt = false;
+  sWinMin = INT16_MAX;
+  sWinMax = INT16_MIN;
+  sWinSum = 0;
+  sWinN   = 0;
+  sWinStartUs = micros();
+  memset(&sRun, 0, sizeof(sRun));
+}
+
+static void runStatsAdd(int16_t raw, uint32_t t) {
+  if (raw < sWinMin) sWinMin = raw;
+  if (raw > sWinMax) sWinMax = raw;
+  sWinSum += raw;
+  ++sWinN;
+  if (t - sWinStartUs >= (uint32_t)SCOPE_STATS_WINDOW_MS * 1000UL) {
+    sRun.minCode = sWinMin;
+    sRun.maxCode = sWinMax;
+    sRun.avgCode = sWinSum / (int32_t)sWinN;
+    sRun.samples = sWinN;
+    sWinMin = INT16_MAX;
+    sWinMax = INT16_MIN;
+    sWinSum = 0;
+    sWinN   = 0;
+    sWinStartUs = t;
+  }
+}
+
+void scopeOnSample(int16_t raw, uint32_t t) {
+  runStatsAdd(raw, t);
+  if (sState != ScopeState::Armed && sState != ScopeState::Triggered) return;
+
+  if (sFill > 0 && t - sLastUs > sMaxGapUs) sMaxGapUs = t - sLastUs;
+  sLastUs = t;
+  sBuf[sHead] = raw;
+  sHead = (uint16_t)((sHead + 1) % SCOPE_BUF_SAMPLES);
+  if (sFill < SCOPE_BUF_SAMPLES) ++sFill;
+
+  if (sState == ScopeState::Armed) {
+    // Pre-trigger harus terisi dulu, kecuali trigger manual
+    bool level = sTrigCode != INT16_MIN && raw < sTrigCode && sFill > sPreWant;
+    if (!level && !sManualReq) return;
+    sManual    = !level;
+    sManualReq = false;
+    sPre       = (uint16_t)(sFill - 1 < sPreWant ? sFill - 1 : sPreWant);
+    sPostLeft  = (uint16_t)(sTotal - sPre - 1);
+    sTrigUs    = t;
+    sTrigMs    = millis();
+    sState     = ScopeState::Triggered;
+  } else if (sPostLeft > 0) {
+    --sPostLeft;
+  }
+
+  if (sState == ScopeState::Triggered && sPostLeft == 0) {
+    sEndUs   = t;
+    sState   = ScopeState::Done;
+    sDoneEvt = true;
+  }
+}
+
+bool scopeFast() {
+  return sState == ScopeState::Armed || sState == ScopeState::Triggered;
+}
+
+bool scopeArm(int16_t trigCode, uint16_t pre, uint16_t total) {
+  if (total < 2 || total > SCOPE_BUF_SAMPLES || pre >= total) return false;
+  sTrigCode  = trigCode;
+  sPreWant   = pre;
+  sTotal     = total;
+  sPre       = 0;
+  sHead      = 0;
+  sFill      = 0;
+  sMaxGapUs  = 0;
+  sManual    = false;
+  sManualReq = false;
+  sDoneEvt   = false;
+  sState     = ScopeState::Armed;
+  return true;
+}
+
+bool scopeTrigger() {
+  if (sState != ScopeState::Armed) return false;
+  sManualReq = true;   // dieksekusi di sampel berikutnya
+  return true;
+}
+
+void scopeAbort() {
+  sState = ScopeState::Idle;
+  sManualReq = false;
+  sDoneEvt = false;
+}
+
+ScopeState scopeState() {
+  return sState;
+}
+
+static uint16_t captureCount() {
+  return sState == ScopeState::Done ? sTotal : sFill;
+}
+
+void scopeGetInfo(ScopeInfo &out) {
+  out.state    = sState;
+  out.manual   = sManual;
+  out.trigCode = sTrigCode;
+  out.pre      = sPre;
+  out.count    = captureCount();
+  uint16_t post = (uint16_t)(sTotal - sPre - 1);
+  out.periodUs = (sState == ScopeState::Done && post > 0) ? (sEndUs - sTrigUs) / post : 0;
+  out.maxGapUs = sMaxGapUs;
+  out.trigAgoMs = (sState == ScopeState::Done || sState == ScopeState::Triggered)
+                    ? millis() - sTrigMs : 0;
+}
+
+void scopeGetRunStats(ScopeRunStats &out) {
+  out = sRun;
+}
+
+uint16_t scopeRead(uint16_t off, int16_t *out, uint16_t n) {
+  if (sState != ScopeState::Done || !out) return 0;
+  uint16_t count = captureCount();
+  if (off >= count) return 0;
+  if (n > count - off) n = (uint16_t)(count - off);
+  // Sampel tertua capture = head − count (ring)
+  uint16_t start = (uint16_t)((sHead + SCOPE_BUF_SAMPLES - count + off) % SCOPE_BUF_SAMPLES);
+  for (uint16_t i = 0; i < n; ++i) {
+    out[i] = sBuf[(start + i) % SCOPE_BUF_SAMPLES];
+  }
+  return n;
+}
+
+bool scopeConsumeDone() {
+  if (!sDoneEvt) return false;
+  sDoneEvt = false;
+  return true;
+}
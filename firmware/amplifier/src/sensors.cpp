@@ -1,5 +1,11 @@
 #include "sensors.h"
 #include "config.h"
+#include "stats.h"
+#include "i2c_bus.h"
+#include "scope.h"
+#include "sched.h"
+#include "tasks.h"
+#include "trace.h"
 
 #include <Wire.h>
 #include <RTClib.h>
@@ -18,42 +24,575 @@ static inline float adcToRealVolt(float vAdc) {
 // Nilai terakhir (langsung, tanpa smoothing)
 static float gVoltInstant = 0.0f;
 
-// ====== DS18B20 (heatsink) ======
+// Sekuencer channel: ch0 (SMPS) tiap ADS_SAMPLE_INTERVAL_US, channel lain
+// disisipkan round-robin sesuai periode masing-masing.
+struct AdsChCfg {
+  bool      en;
+  uint8_t   ain;
+  adsGain_t gain;
+  uint16_t  rate;
+  uint16_t  periodMs;
+  float     scale;
+  float     offset;
+};
+
+static const AdsChCfg ADS_CH[ADS_NUM_CH] = {
+  { true, ADS_CHANNEL, GAIN_ONE, RATE_ADS1115_860SPS, 0,
+    (R1_OHMS + R2_OHMS) / R2_OHMS, 0.0f },
+  { ADS_NEG_ENABLE, ADS_NEG_AIN, ADS_NEG_GAIN, ADS_NEG_RATE, ADS_NEG_PERIOD_MS,
+    ADS_NEG_SCALE, ADS_NEG_OFFSET },
+  { ADS_AUX12_ENABLE, ADS_AUX12_AIN, ADS_AUX12_GAIN, ADS_AUX12_RATE, ADS_AUX12_PERIOD_MS,
+    ADS_AUX12_SCALE, ADS_AUX12_OFFSET },
+  { ADS_SHUNT_ENABLE, ADS_SHUNT_AIN, ADS_SHUNT_GAIN, ADS_SHUNT_RATE, ADS_SHUNT_PERIOD_MS,
+    ADS_SHUNT_SCALE, ADS_SHUNT_OFFSET },
+};
+
+static const char *const ADS_CH_NAMES[ADS_NUM_CH] = { "smps_v", "neg_v", "aux12_v", "shunt_a" };
+
+static float     adsChValue[ADS_NUM_CH];
+static uint32_t  adsChLastMs[ADS_NUM_CH];
+static uint32_t  adsChSamples[ADS_NUM_CH];
+static AdsChHook adsChHook[ADS_NUM_CH];
+static uint8_t   adsCurCh   = 0;   // channel konversi yang sedang berjalan
+static uint8_t   adsLastAux = 0;
+
+// Anggaran bus ADS per jendela 1 s
+static uint32_t adsBusWinUs     = 0;
+static uint32_t adsBusWinStart  = 0;
+static uint32_t adsBusUsPerS    = 0;
+static uint32_t adsAuxDeferred  = 0;
+
+static float gainFullScaleV(adsGain_t g) {
+  switch (g) {
+    case GAIN_TWOTHIRDS: return 6.144f;
+    case GAIN_TWO:       return 2.048f;
+    case GAIN_FOUR:      return 1.024f;
+    case GAIN_EIGHT:     return 0.512f;
+    case GAIN_SIXTEEN:   return 0.256f;
+    case GAIN_ONE:
+    default:             return 4.096f;
+  }
+}
+
+static uint16_t rateSps(uint16_t rate) {
+  static const uint16_t SPS[8] = { 8, 16, 32, 64, 128, 250, 475, 860 };
+  return SPS[(rate >> 5) & 0x07];
+}
+
+// Waktu konversi + 10% toleransi osilator internal ADS
+static uint32_t adsConvUs(uint8_t ch) {
+  return 1100000UL / rateSps(ADS_CH[ch].rate);
+}
+
+// Pipeline single-shot non-blocking: satu job = baca hasil konversi
+// sebelumnya + mulai konversi berikutnya (tanpa menunggu 8 ms seperti
+// readADC_SingleEnded pada 128 SPS).
+static bool     adsConvPending = false;
+static bool     adsJobQueued   = false;
+static volatile uint32_t adsStartUs = 0;   // dibaca ISR ALERT (latensi trip)
+
+// Ambang bawah comparator (kode ADC); INT16_MIN = belum diprogram
+static int16_t  adsAlertLoCode = INT16_MIN;
+static int16_t  adsAlertLoWant = INT16_MIN;
+static bool     adsThreshQueued = false;
+
+// Scope: continuous + conversion-ready (lihat ADS_SCOPE_CONTINUOUS)
+static volatile bool     adsRdyMode  = false;
+static volatile uint32_t adsRdyCount = 0;
+static volatile uint32_t adsRdyUs    = 0;
+static uint32_t          adsRdySeen  = 0;
+
+static bool adsWriteReg(uint8_t reg, uint16_t val) {
+  Wire.beginTransmission(ADS_I2C_ADDR);
+  Wire.write(reg);
+  Wire.write((uint8_t)(val >> 8));
+  Wire.write((uint8_t)(val & 0xFF));
+  return Wire.endTransmission() == 0;
+}
+
+// startADCReading() milik library menimpa register ambang (ALERT jadi
+// conversion-ready), jadi config ditulis sendiri agar comparator tetap aktif.
+// Comparator hanya untuk ch0; channel lain CQUE_NONE (ALERT dilepas) agar
+// nilainya tidak dibandingkan dengan ambang SMPS.
+static bool adsStartConversion(uint8_t ch) {
+  const AdsChCfg &c = ADS_CH[ch];
+  uint16_t cfg = ADS1X15_REG_CONFIG_OS_SINGLE |
+                 (uint16_t)(ADS1X15_REG_CONFIG_MUX_SINGLE_0 + (c.ain << 12)) |
+                 (uint16_t)c.gain | ADS1X15_REG_CONFIG_MODE_SINGLE | c.rate;
+  if (FEAT_SMPS_HW_TRIP && ch == 0) {
+    // Window: ALERT aktif bila hasil < LO_THRESH (HI = maks) setelah 1 konversi
+    cfg |= ADS1X15_REG_CONFIG_CMODE_WINDOW | ADS1X15_REG_CONFIG_CPOL_ACTVLOW |
+           ADS1X15_REG_CONFIG_CLAT_NONLAT | ADS1X15_REG_CONFIG_CQUE_1CONV;
+  } else {
+    cfg |= ADS1X15_REG_CONFIG_CQUE_NONE;
+  }
+  return adsWriteReg(ADS1X15_REG_POINTER_CONFIG, cfg);
+}
+
+// Channel berikut: ch0 bila scope aktif / anggaran habis / tidak ada yang jatuh tempo
+static uint8_t adsPickNext(uint32_t nowMs) {
+  if (adsCurCh != 0 || scopeFast()) return 0;   // selingi tiap aux dengan ch0
+  for (uint8_t i = 1; i < ADS_NUM_CH; ++i) {
+    uint8_t ch = (uint8_t)(1 + (adsLastAux + i - 1) % (ADS_NUM_CH - 1));
+    const AdsChCfg &c = ADS_CH[ch];
+    if (!c.en || nowMs - adsChLastMs[ch] < c.periodMs) continue;
+    if (adsBusWinUs >= ADS_BUS_BUDGET_US) {
+      ++adsAuxDeferred;
+      return 0;
+    }
+    adsLastAux = ch;
+    return ch;
+  }
+  return 0;
+}
+
+static void adsOnResult(uint8_t ch, int16_t raw, uint32_t startUs) {
+  if (ch == 0) {
+    scopeOnSample(raw, startUs);
+    float vAdc  = ads.computeVolts(raw);   // Volt di pin ADS
+    float vReal = adcToRealVolt(vAdc);
+    gVoltInstant = (vReal >= VOLT_MIN_VALID_V) ? vReal : 0.0f;
+    adsChValue[0] = gVoltInstant;
+  } else {
+    const AdsChCfg &c = ADS_CH[ch];
+    float vPin = raw * gainFullScaleV(c.gain) / 32768.0f;
+    adsChValue[ch] = vPin * c.scale + c.offset;
+  }
+  adsChLastMs[ch] = millis();
+  ++adsChSamples[ch];
+  if (adsChHook[ch]) adsChHook[ch](ch, adsChValue[ch]);
+}
+
+static void adsBusAccount(uint32_t busyUs) {
+  uint32_t now = micros();
+  if (now - adsBusWinStart >= 1000000UL) {
+    adsBusUsPerS   = adsBusWinUs;
+    adsBusWinUs    = 0;
+    adsBusWinStart = now;
+  }
+  adsBusWinUs += busyUs;
+}
+
+static bool adsThreshJob(uint32_t) {
+  adsThreshQueued = false;
+  int16_t code = adsAlertLoWant;
+  bool ok = adsWriteReg(ADS1X15_REG_POINTER_HITHRESH, 0x7FFF) &&
+            adsWriteReg(ADS1X15_REG_POINTER_LOWTHRESH, (uint16_t)code);
+  if (ok) adsAlertLoCode = code;
+  return ok;
+}
+
+bool IRAM_ATTR sensorsAdsAlertIsr() {
+  if (!adsRdyMode) return false;
+  adsRdyUs = micros();
+  adsRdyCount = adsRdyCount + 1;
+  return true;
+}
+
+bool sensorsAdsRdyMode() {
+  return adsRdyMode;
+}
+
+// Masuk scope: HI_THRESH MSB=1 & LO_THRESH MSB=0 → ALERT pulsa tiap akhir
+// konversi; ch0 continuous. Konversi single-shot yang tertunda dibuang.
+static bool adsEnterContinuous() {
+  adsRdyMode = true;   // sebelum tulis register: pulsa pertama bukan trip
+  adsRdySeen = adsRdyCount;
+  adsAlertLoCode = INT16_MIN;
+  adsConvPending = false;
+  adsCurCh = 0;
+  const AdsChCfg &c = ADS_CH[0];
+  uint16_t cfg = (uint16_t)(ADS1X15_REG_CONFIG_MUX_SINGLE_0 + (c.ain << 12)) |
+                 (uint16_t)c.gain | ADS1X15_REG_CONFIG_MODE_CONTIN | RATE_ADS1115_860SPS |
+                 ADS1X15_REG_CONFIG_CMODE_TRAD | ADS1X15_REG_CONFIG_CPOL_ACTVLOW |
+                 ADS1X15_REG_CONFIG_CLAT_NONLAT | ADS1X15_REG_CONFIG_CQUE_1CONV;
+  return adsWriteReg(ADS1X15_REG_POINTER_HITHRESH, 0x8000) &&
+         adsWriteReg(ADS1X15_REG_POINTER_LOWTHRESH, 0x0000) &&
+         adsWriteReg(ADS1X15_REG_POINTER_CONFIG, cfg);
+}
+
+// Keluar scope: ambang UV dipulihkan dulu, baru pipeline single-shot jalan
+// lagi (config single-shot sekaligus menghentikan mode continuous)
+static bool adsExitContinuous() {
+  int16_t lo = (FEAT_SMPS_HW_TRIP && adsAlertLoWant != INT16_MIN) ? adsAlertLoWant : INT16_MIN;
+  bool ok = adsWriteReg(ADS1X15_REG_POINTER_HITHRESH, 0x7FFF) &&
+            adsWriteReg(ADS1X15_REG_POINTER_LOWTHRESH, (uint16_t)lo);
+  if (ok && FEAT_SMPS_HW_TRIP) adsAlertLoCode = lo;
+  ok = ok && adsStartConversion(0);
+  adsRdyMode = false;
+  adsConvPending = ok;
+  adsCurCh = 0;
+  adsStartUs = micros();
+  return ok;
+}
+
+// Continuous: ambil sampel bila ISR mencatat konversi baru sejak job lalu
+static bool adsRdyJob(uint32_t t0) {
+  uint32_t n = adsRdyCount;
+  if (n == adsRdySeen) {
+    adsBusAccount(micros() - t0);
+    return true;
+  }
+  uint32_t t = adsRdyUs;
+  adsRdySeen = n;
+  adsOnResult(0, ads.getLastConversionResults(), t);
+  adsBusAccount(micros() - t0);
+  return true;
+}
+
+static bool adsJob(uint32_t) {
+  adsJobQueued = false;
+  uint32_t t0 = micros();
+  bool wantRdy = ADS_SCOPE_CONTINUOUS && scopeFast();
+  if (wantRdy != adsRdyMode) {
+    bool ok = wantRdy ? adsEnterContinuous() : adsExitContinuous();
+    adsBusAccount(micros() - t0);
+    return ok;
+  }
+  if (adsRdyMode) return adsRdyJob(t0);
+  if (adsConvPending) {
+    // Scope mode / channel laju rendah: cek bit OS agar tidak membaca hasil basi
+    if ((scopeFast() || adsCurCh != 0) && !ads.conversionComplete()) {
+      adsBusAccount(micros() - t0);
+      return true;
+    }
+    adsOnResult(adsCurCh, ads.getLastConversionResults(), adsStartUs);
+  }
+  uint8_t next = adsPickNext(millis());
+  bool ok = adsStartConversion(next);
+  adsConvPending = ok;
+  adsCurCh = next;
+  adsStartUs = micros();
+  adsBusAccount(adsStartUs - t0);
+  return ok;
+}
+
+// ====== DS18B20 (heatsink, trafo, PSU) ======
 #include <OneWire.h>
 #include <DallasTemperature.h>
+#include <Preferences.h>
 
 static OneWire         oneWire(DS18B20_PIN);
 static DallasTemperature dallas(&oneWire);
 static float           gHeatC = NAN;
-static uint32_t        lastTempMs = 0;
+static float           gTempMaxC = NAN;
+
+static constexpr const char* DS_NS    = "jacktor_ds18";
+static constexpr const char* DS_K_ROM = "rom";
+static constexpr uint8_t DS_FAMILY    = 0x28;
+static const char *const DS_NAMES[DS18B20_MAX_SENSORS] = DS18B20_NAMES;
+static const uint8_t     DS_RES[DS18B20_MAX_SENSORS]   = DS18B20_RES_BITS;
+
+struct DsProbe {
+  DeviceAddress rom;
+  bool     used;       // slot punya ROM (dari cache/enumerasi)
+  bool     present;    // ditemukan saat enumerasi boot
+  uint8_t  failSeq;
+  float    tempC;
+};
+static DsProbe dsProbe[DS18B20_MAX_SENSORS];
+
+enum class DsPhase : uint8_t { Idle, Converting, Reading };
+static DsPhase  dsPhase       = DsPhase::Idle;
+static uint32_t dsConvStartMs = 0;
+static uint16_t dsConvMs      = 750;
+static uint8_t  dsReadIdx     = 0;
+static uint8_t  dsFound       = 0;
+static uint32_t dsCrcErrors   = 0;
+static uint32_t dsMisses      = 0;
+static uint32_t dsReadUsMax   = 0;
+
+static bool dsRomValid(const uint8_t *rom) {
+  return rom[0] == DS_FAMILY && OneWire::crc8(rom, 7) == rom[7];
+}
+
+// Enumerasi sekali saat boot. Slot mengikuti cache NVS; probe baru mengisi
+// slot kosong dulu, baru slot yang ROM-nya tidak ditemukan (probe diganti).
+static void dsEnumerate() {
+  uint8_t cache[DS18B20_MAX_SENSORS][8] = {};
+  Preferences nv;
+  nv.begin(DS_NS, /*readOnly=*/false);
+  if (nv.getBytesLength(DS_K_ROM) == sizeof(cache)) {
+    nv.getBytes(DS_K_ROM, cache, sizeof(cache));
+  }
+  for (uint8_t i = 0; i < DS18B20_MAX_SENSORS; ++i) {
+    DsProbe &p = dsProbe[i];
+    memset(&p, 0, sizeof(p));
+    p.tempC = NAN;
+    if (dsRomValid(cache[i])) {
+      memcpy(p.rom, cache[i], 8);
+      p.used = true;
+    }
+  }
+
+  DeviceAddress fresh[DS18B20_MAX_SENSORS];
+  uint8_t nFresh = 0;
+  DeviceAddress rom;
+  dsFound = 0;
+  oneWire.reset_search();
+  while (oneWire.search(rom)) {
+    if (!dsRomValid(rom)) continue;
+    ++dsFound;
+    bool known = false;
+    for (DsProbe &p : dsProbe) {
+      if (p.used && memcmp(p.rom, rom, 8) == 0) {
+        p.present = known = true;
+        break;
+      }
+    }
+    if (!known && nFresh < DS18B20_MAX_SENSORS) memcpy(fresh[nFresh++], rom, 8);
+  }
+
+  bool changed = false;
+  for (uint8_t f = 0; f < nFresh; ++f) {
+    int slot = -1;
+    for (uint8_t i = 0; i < DS18B20_MAX_SENSORS && slot < 0; ++i) {
+      if (!dsProbe[i].used) slot = i;
+    }
+    for (uint8_t i = 0; i < DS18B20_MAX_SENSORS && slot < 0; ++i) {
+      if (!dsProbe[i].present) slot = i;
+    }
+    if (slot < 0) break;   // lebih dari DS18B20_MAX_SENSORS probe
+    memcpy(dsProbe[slot].rom, fresh[f], 8);
+    dsProbe[slot].used    = true;
+    dsProbe[slot].present = true;
+    changed = true;
+  }
+
+  if (changed) {
+    for (uint8_t i = 0; i < DS18B20_MAX_SENSORS; ++i) {
+      if (dsProbe[i].used) memcpy(cache[i], dsProbe[i].rom, 8);
+      else memset(cache[i], 0, 8);
+    }
+    nv.putBytes(DS_K_ROM, cache, sizeof(cache));
+  }
+  nv.end();
+
+  // Resolusi per slot; waktu tunggu konversi broadcast = resolusi tertinggi
+  uint8_t maxRes = 9;
+  for (uint8_t i = 0; i < DS18B20_MAX_SENSORS; ++i) {
+    if (!dsProbe[i].present) continue;
+    uint8_t res = DS_RES[i] < 9 ? 9 : DS_RES[i] > 12 ? 12 : DS_RES[i];
+    dallas.setResolution(dsProbe[i].rom, res, /*skipGlobalResolutionCalculation=*/true);
+    if (res > maxRes) maxRes = res;
+  }
+  dsConvMs = (uint16_t)(750u >> (12 - maxRes));
+}
+
+// Baca scratchpad satu probe via Match ROM (bukan search) + cek CRC8
+static void dsReadOne(uint8_t idx) {
+  DsProbe &p = dsProbe[idx];
+  uint8_t sp[9];
+  uint32_t t0 = micros();
+  bool presence = dallas.readScratchPad(p.rom, sp);
+  uint32_t dt = micros() - t0;
+  if (dt > dsReadUsMax) dsReadUsMax = dt;
+  traceEmit(TraceEv::Ds18Read, idx, dt);
+
+  float t = NAN;
+  if (!presence) {
+    ++dsMisses;
+  } else if (OneWire::crc8(sp, 8) != sp[8]) {
+    ++dsCrcErrors;
+  } else {
+    // Bit LSB tak terdefinisi di resolusi < 12 bit (config byte 4: R1R0)
+    uint8_t res = 9 + ((sp[4] >> 5) & 0x03);
+    int16_t raw = (int16_t)((sp[1] << 8) | sp[0]);
+    raw &= (int16_t)~((1 << (12 - res)) - 1);
+    t = raw / 16.0f;
+    if (t <= -55.0f || t >= 125.0f) t = NAN;
+  }
+
+  if (isnan(t)) {
+    // Pertahankan nilai lama beberapa siklus, lalu nyatakan gagal
+    if (p.failSeq < 255) ++p.failSeq;
+    if (p.failSeq >= DS18B20_STALE_READS) p.tempC = NAN;
+    return;
+  }
+  p.failSeq = 0;
+  if (FEAT_FILTER_DS18B20_SOFT && !isnan(p.tempC)) {
+    p.tempC = 0.7f * p.tempC + 0.3f * t;
+  } else {
+    p.tempC = t;
+  }
+}
+
+static void dsPublish() {
+  float heat = NAN, mx = NAN;
+  for (uint8_t i = 0; i < DS18B20_MAX_SENSORS; ++i) {
+    float t = dsProbe[i].tempC;
+    if (!dsProbe[i].used || isnan(t)) continue;
+    if (isnan(mx) || t > mx) mx = t;
+    if ((DS18B20_HEATSINK_MASK >> i) & 1) {
+      if (isnan(heat) || t > heat) heat = t;
+    }
+  }
+  gHeatC    = heat;
+  gTempMaxC = mx;
+}
+
+// Idle → broadcast Convert T → tunggu dsConvMs → baca satu probe per tick.
+// Tanpa setWaitForConversion(true) → tidak ada delay konversi di loop.
+static void dsTick(uint32_t now) {
+  switch (dsPhase) {
+    case DsPhase::Idle:
+      if (dsFound == 0 || now - dsConvStartMs < DS18B20_PERIOD_MS) return;
+      dallas.requestTemperatures();
+      dsConvStartMs = now;
+      dsPhase = DsPhase::Converting;
+      return;
+    case DsPhase::Converting:
+      if (now - dsConvStartMs < dsConvMs) return;
+      dsReadIdx = 0;
+      dsPhase = DsPhase::Reading;
+      return;
+    case DsPhase::Reading:
+      while (dsReadIdx < DS18B20_MAX_SENSORS && !dsProbe[dsReadIdx].used) ++dsReadIdx;
+      if (dsReadIdx < DS18B20_MAX_SENSORS) {
+        dsReadOne(dsReadIdx++);
+        return;
+      }
+      dsPublish();
+      dsPhase = DsPhase::Idle;
+      return;
+  }
+}
 
 // ====== RTC DS3231 ======
 static RTC_DS3231 rtc;
 static bool       rtcReady = false;
 static volatile bool rtcSqwTick = false;
 static float      rtcTempC = NAN;
+static DateTime   rtcReadBuf;
+
+// RTClib tidak melaporkan error; probe alamat dulu agar DS3231 yang hilang
+// terdeteksi penjadwal (bukan membaca 0xFF sebagai waktu)
+static bool rtcTempJob(uint32_t) {
+  if (!i2cBusProbe(RTC_I2C_ADDR)) return false;
+  rtcTempC = rtc.getTemperature();
+  return true;
+}
+
+static bool rtcNowJob(uint32_t) {
+  if (!i2cBusProbe(RTC_I2C_ADDR)) return false;
+  rtcReadBuf = rtc.now();
+  return true;
+}
+
+static bool rtcAdjustJob(uint32_t epoch) {
+  if (!i2cBusProbe(RTC_I2C_ADDR)) return false;
+  rtc.adjust(DateTime(epoch));
+  return true;
+}
+
+// ====== Jam software (disiplin SQW 1 Hz) ======
+// RTC dibaca via I2C hanya saat boot, setelah sync, dan verifikasi berkala.
+// Detik maju dari ISR SQW; milidetik diinterpolasi dari millis() sejak tepi
+// terakhir. Bila SQW hilang, jam jalan bebas dari millis() sampai pulih.
+static portMUX_TYPE      sqwMux      = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t sqwEdges    = 0;
+static volatile uint32_t sqwEdgeMs   = 0;
+
+static uint32_t clkEpoch     = 0;      // detik UTC pada clkEdgeMs
+static uint32_t clkEdgeMs    = 0;
+static uint32_t clkEdgesSeen = 0;
+static bool     clkValid     = false;
+static bool     clkResync    = false;  // anchor ulang ke RTC pada tepi berikutnya
+static bool     clkSqwOk     = false;
+static uint32_t clkLastReadMs = 0;
+static uint32_t clkRtcReads  = 0;
+static uint32_t clkSqwLost   = 0;
+static int32_t  clkLastStepS = 0;      // koreksi terakhir saat verifikasi RTC
+
+static char     clkIso[24];
+static uint32_t clkIsoEpoch  = UINT32_MAX;
 
 static void IRAM_ATTR onRtcSqw() {
+  portENTER_CRITICAL_ISR(&sqwMux);
+  sqwEdgeMs = millis();
+  ++sqwEdges;
+  portEXIT_CRITICAL_ISR(&sqwMux);
   rtcSqwTick = true;
+  schedWakeFromIsr();   // telemetry standby sinkron ke detik RTC
+}
+
+static bool clockReadRtc(uint32_t &epoch) {
+  if (!i2cBusRun(I2cDev::Rtc, rtcNowJob, 0, 8)) return false;
+  epoch = rtcReadBuf.unixtime();
+  ++clkRtcReads;
+  clkLastReadMs = millis();
+  return true;
+}
+
+static void clockAnchor(uint32_t epoch, uint32_t edgeMs) {
+  if (clkValid) clkLastStepS = (int32_t)(epoch - clkEpoch);
+  clkEpoch  = epoch;
+  clkEdgeMs = edgeMs;
+  clkValid  = true;
+}
+
+static void clockTick(uint32_t now) {
+  if (!rtcReady) return;
+
+  uint32_t edges, edgeMs;
+  portENTER_CRITICAL(&sqwMux);
+  edges  = sqwEdges;
+  edgeMs = sqwEdgeMs;
+  portEXIT_CRITICAL(&sqwMux);
+
+  uint32_t delta = edges - clkEdgesSeen;
+  if (delta > 0) {
+    traceEmit(TraceEv::Sqw, (uint16_t)delta);
+    clkEdgesSeen = edges;
+    clkSqwOk = true;
+    if (!clkResync && now - clkLastReadMs >= RTC_CLOCK_VERIFY_MS) clkResync = true;
+    if (clkValid) {
+      clkEpoch  += delta;
+      clkEdgeMs  = edgeMs;
+    }
+    // Tepi SQW = register detik baru saja berganti → bacaan RTC tepat di awal detik
+    uint32_t epoch;
+    if (clkResync && clockReadRtc(epoch)) {
+      clockAnchor(epoch, edgeMs);
+      clkResync = false;
+    }
+    return;
+  }
+
+  // SQW diam: jalan bebas dari millis(), anchor ulang saat tepi kembali
+  if (clkValid && now - clkEdgeMs >= RTC_SQW_TIMEOUT_MS) {
+    if (clkSqwOk) {
+      clkSqwOk = false;
+      ++clkSqwLost;
+      clkResync = true;
+    }
+    uint32_t secs = (now - clkEdgeMs) / 1000;
+    clkEpoch  += secs;
+    clkEdgeMs += secs * 1000;
+  }
 }
 
 // ====== Analyzer (I²S ADC internal → FFT) ======
 #include <driver/i2s.h>
 #include <arduinoFFT.h>
 
+// Dimiliki task analyzer (core 0); loop/ui hanya membaca hasil lewat anaMux
 static ArduinoFFT<double> FFT;
 static bool     i2sReady = false;
 static bool     gAnalyzerEn = true;
+static volatile bool anaWantEn = true;   // permintaan dari loop, diterapkan task
 
 static double   vReal[ANA_N];
 static double   vImag[ANA_N];
 static uint16_t sampCount = 0;
+static uint32_t lastFftMs = 0;
 
+static portMUX_TYPE anaMux = portMUX_INITIALIZER_UNLOCKED;
 static uint8_t  bandsOut[ANA_BANDS];   // 0..255
+static uint8_t  vuOut = 0;
 static bool     bandsInit = false;
 
 static int      bandBins[ANA_BANDS + 1];
-static uint32_t lastFftMs = 0;
 
 // Window Hann
 static inline double hann(uint16_t n, uint16_t N) {
@@ -111,16 +650,19 @@ static bool i2sSetup() {
 #endif
 }
 
-// Ambil sampel dari I2S ke vReal/vImag; non-blocking-ish
-static void analyzerSample() {
-  if (!i2sReady) return;
-  if (!gAnalyzerEn) return;
-  if (sampCount >= ANA_N) return;
+// Ambil sampel dari I2S ke vReal/vImag; blok sampai DMA berisi atau maxMs
+static void analyzerSample(uint32_t maxMs) {
+  // Buffer penuh: tunggu jadwal FFT berikut (ANA_UPDATE_MS)
+  if (sampCount >= ANA_N) {
+    uint32_t since = millis() - lastFftMs;
+    if (since < ANA_UPDATE_MS) vTaskDelay(pdMS_TO_TICKS(ANA_UPDATE_MS - since));
+    return;
+  }
 
   // Baca chunk kecil
   int16_t buf[128];
   size_t  br = 0;
-  if (i2s_read(I2S_PORT, (void*)buf, sizeof(buf), &br, 0) != ESP_OK) return;
+  if (i2s_read(I2S_PORT, (void*)buf, sizeof(buf), &br, pdMS_TO_TICKS(maxMs)) != ESP_OK) return;
   int n16 = br / sizeof(int16_t);
   for (int i = 0; i < n16 && sampCount < ANA_N; ++i) {
     // Nilai raw ADC 12-bit terekspansi ke 16-bit; pusatkan di 0
@@ -132,12 +674,15 @@ static void analyzerSample() {
   }
 }
 
+static uint8_t computeVuMono();
+
 // Proses FFT → isi bandsOut (0..255)
 static void analyzerProcess(uint32_t now) {
   if (!bandsInit) makeBandBoundaries();
   if (sampCount < ANA_N) return;
   if (now - lastFftMs < ANA_UPDATE_MS) return;
   lastFftMs = now;
+  uint32_t t0 = micros();
 
   // Window Hann
   for (uint16_t i = 0; i < ANA_N; ++i) {
@@ -149,6 +694,7 @@ static void analyzerProcess(uint32_t now) {
   FFT.complexToMagnitude();
 
   // Agregasi band log-spaced (average magnitude)
+  uint8_t bands[ANA_BANDS];
   for (int b = 0; b < ANA_BANDS; ++b) {
     int k1 = bandBins[b];
     int k2 = bandBins[b + 1];
@@ -167,8 +713,16 @@ static void analyzerProcess(uint32_t now) {
     if (mag < 0.0) mag = 0.0;
     if (mag > 255.0) mag = 255.0;
 
-    bandsOut[b] = (uint8_t) (mag + 0.5);
+    bands[b] = (uint8_t) (mag + 0.5);
   }
+  // VU dari magnitudo frame yang sama (vReal ditimpa sampel baru setelah ini)
+  uint8_t vu = computeVuMono();
+
+  portENTER_CRITICAL(&anaMux);
+  memcpy(bandsOut, bands, sizeof(bandsOut));
+  vuOut = vu;
+  portEXIT_CRITICAL(&anaMux);
+  traceSpan(TraceEv::Fft, t0);
 
   // Siap siklus berikutnya
   sampCount = 0;
@@ -192,17 +746,73 @@ static uint8_t computeVuMono() {
   return (uint8_t)(vu + 0.5);
 }
 
+// ====== Task analyzer (tasks.cpp) ======
+// Bagian tunggu (I2S blocking / notifikasi enable) dipisah dari bagian kerja
+// agar beban CPU task hanya menghitung FFT, bukan waktu menunggu DMA.
+void analyzerWait(uint32_t maxMs) {
+  if (anaWantEn != gAnalyzerEn) return;
+  if (!i2sReady || !gAnalyzerEn) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(maxMs));   // standby: tidur sampai di-enable
+    return;
+  }
+  analyzerSample(maxMs);
+}
+
+void analyzerWork(uint32_t now) {
+  bool want = anaWantEn;
+  if (want != gAnalyzerEn) {
+    gAnalyzerEn = want;
+    sampCount = 0;
+#if I2S_USE_BUILTIN_ADC
+    if (i2sReady) {
+      if (want) {
+        i2s_adc_enable(I2S_PORT);
+      } else {
+        i2s_adc_disable(I2S_PORT);
+      }
+    }
+#endif
+  }
+  if (gAnalyzerEn) analyzerProcess(now);
+}
+
 // ====== Public API ======
+// ====== Job terjadwal (sched.cpp) ======
+static void tempJob(uint32_t) {
+  if (rtcReady && FEAT_RTC_TEMP_TELEMETRY && i2cBusDevOnline(I2cDev::Rtc)) {
+    i2cBusSubmit(I2cDev::Rtc, I2C_PRIO_NORMAL, rtcTempJob, 0, 3);
+  } else {
+    rtcTempC = NAN;
+  }
+  statsOnSensors1Hz(gHeatC, gVoltInstant);
+}
+
 void sensorsInit() {
-  // I2C backbone
-  Wire.begin(I2C_SDA, I2C_SCL);
+  // I2C backbone sudah disiapkan i2cBusInit(); init device di bawah masih
+  // langsung (sekali saat boot, sebelum penjadwal berjalan).
 
   // ADS1115 (gain ±4.096 V → cocok untuk divider 65V → ~3V di ADC)
   ads.begin(ADS_I2C_ADDR, &Wire);
   ads.setGain(GAIN_ONE); // ±4.096 V
+  ads.setDataRate(RATE_ADS1115_860SPS);
+  adsConvPending = false;
+  adsJobQueued = false;
+  adsAlertLoCode = INT16_MIN;
+  adsThreshQueued = false;
+  adsCurCh = 0;
+  adsLastAux = 0;
+  for (uint8_t i = 0; i < ADS_NUM_CH; ++i) {
+    adsChValue[i]   = NAN;
+    adsChLastMs[i]  = 0;
+    adsChSamples[i] = 0;
+  }
+  adsBusWinStart = micros();
+  scopeInit();
 
-  // DS18B20
+  // DS18B20: konversi non-blocking, alamat dari cache NVS
   dallas.begin();
+  dallas.setWaitForConversion(false);
+  dsEnumerate();
 
   // RTC DS3231
   rtcReady = rtc.begin(&Wire);
@@ -213,8 +823,17 @@ void sensorsInit() {
       rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
     }
   }
+  // Bacaan awal (fase detik belum diketahui); tepi SQW pertama meng-anchor ulang
+  clkValid = false;
+  clkSqwOk = false;
+  if (rtcReady) {
+    uint32_t epoch;
+    if (clockReadRtc(epoch)) clockAnchor(epoch, millis());
+    clkResync = true;
+  }
   pinMode(RTC_SQW_PIN, INPUT);
-  attachInterrupt(digitalPinToInterrupt(RTC_SQW_PIN), onRtcSqw, RISING);
+  clkEdgesSeen = sqwEdges;
+  attachInterrupt(digitalPinToInterrupt(RTC_SQW_PIN), onRtcSqw, RTC_SQW_EDGE);
 
   // I2S Analyzer
   i2sReady = i2sSetup();
@@ -222,49 +841,58 @@ void sensorsInit() {
   lastFftMs = 0;
   bandsInit = false;
   memset(bandsOut, 0, sizeof(bandsOut));
+  vuOut = 0;
 
   gVoltInstant = 0.0f;
   gHeatC = NAN;
-  lastTempMs = 0;
   rtcTempC = NAN;
   rtcSqwTick = false;
+
+  schedEvery("ds18", dsTick, SCHED_DS18_MS, SCHED_DS18_BUDGET_US);
+  schedEvery("temp", tempJob, SCHED_TEMP_MS, SCHED_TEMP_BUDGET_US);
+}
+
+// ADS hilang dari bus: nilai tidak lagi dipercaya; saat kembali, pipeline
+// dan ambang comparator diprogram ulang (chip mungkin ter-reset)
+static bool adsWasOnline = true;
+
+static void adsHealthTick() {
+  bool online = i2cBusDevOnline(I2cDev::Ads);
+  if (online == adsWasOnline) return;
+  adsWasOnline = online;
+  adsConvPending = false;
+  adsCurCh = 0;
+  adsAlertLoCode = INT16_MIN;
+  adsRdyMode = false;   // chip mungkin ter-reset → masuk ulang bila scope masih jalan
+  if (!online) {
+    gVoltInstant = 0.0f;
+    for (uint8_t i = 0; i < ADS_NUM_CH; ++i) adsChValue[i] = NAN;
+  }
 }
 
 void sensorsTick(uint32_t now) {
-  // --- Baca voltmeter (boleh 10–20 Hz; di sini kita jalankan setiap tick) ---
-  int16_t raw = ads.readADC_SingleEnded(ADS_CHANNEL);
-  float   vAdc = ads.computeVolts(raw);   // Volt di pin ADS
-  float   vReal = adcToRealVolt(vAdc);
-  gVoltInstant = (vReal >= VOLT_MIN_VALID_V) ? vReal : 0.0f;
-
-  // --- Heatsink temp (1 Hz cukup) ---
-  if (now - lastTempMs >= 1000) {
-    lastTempMs = now;
-    dallas.requestTemperatures();
-    float t = dallas.getTempCByIndex(0);
-    // DallasTemperature kembalikan 85.0 / DEVICE_DISCONNECTED_C saat gagal
-    if (t <= -127.0f || t >= 125.0f) {
-      // invalid → pertahankan nilai lama (biarkan NAN jika belum pernah valid)
-    } else {
-      if (FEAT_FILTER_DS18B20_SOFT && !isnan(gHeatC)) {
-        gHeatC = 0.7f * gHeatC + 0.3f * t;
-      } else {
-        gHeatC = t;
-      }
-    }
+  clockTick(now);
+  // DS18B20 dan suhu RTC 1 Hz berjalan sebagai job sched
+}
 
-    if (rtcReady && FEAT_RTC_TEMP_TELEMETRY) {
-      rtcTempC = rtc.getTemperature();
-    } else {
-      rtcTempC = NAN;
-    }
+// Task safety: pipeline ADS (job dieksekusi i2cBusTick HIGH di task yang sama)
+void sensorsSafetyTick(uint32_t) {
+  adsHealthTick();
+
+  // --- Voltmeter: job prioritas HIGH tiap ADS_SAMPLE_INTERVAL_US ---
+  // Continuous (scope): job tiap tick, baca hanya bila ada pulsa RDY baru
+  bool rdy = adsRdyMode || (ADS_SCOPE_CONTINUOUS && scopeFast());
+  uint32_t adsIntervalUs = adsCurCh != 0 ? adsConvUs(adsCurCh)
+                         : scopeFast()   ? ADS_SCOPE_INTERVAL_US
+                                         : ADS_SAMPLE_INTERVAL_US;
+  if (!adsJobQueued && (rdy || !adsConvPending || micros() - adsStartUs >= adsIntervalUs)) {
+    adsJobQueued = i2cBusSubmit(I2cDev::Ads, I2C_PRIO_HIGH, adsJob, 0, 6);
+  }
+  // Register ambang dipakai sebagai penanda RDY selama scope
+  if (FEAT_SMPS_HW_TRIP && !rdy && !adsThreshQueued && adsAlertLoWant != adsAlertLoCode) {
+    adsThreshQueued = i2cBusSubmit(I2cDev::Ads, I2C_PRIO_HIGH, adsThreshJob, 0, 6);
   }
 
-  // --- Analyzer (nonaktif saat standby dikelola di modul power/main) ---
-  // Di sini selalu sample & process; jika ingin OFF saat standby, panggil
-  // fungsi ini secara kondisional dari main (power state aware).
-  analyzerSample();
-  analyzerProcess(now);
 }
 
 // Voltmeter instant (tanpa smoothing)
@@ -272,11 +900,100 @@ float getVoltageInstant() {
   return gVoltInstant;
 }
 
+// Volt riil → kode ADC di pin: V·R2/(R1+R2) / LSB (LSB mengikuti gain aktif)
+int16_t sensorsVoltToAdsCode(float vReal) {
+  float lsb = ads.computeVolts(1);
+  if (lsb <= 0.0f) return 0;
+  float code = vReal * (R2_OHMS / (R1_OHMS + R2_OHMS)) / lsb;
+  if (code < 0.0f) code = 0.0f;
+  if (code > 32767.0f) code = 32767.0f;
+  return (int16_t)lroundf(code);
+}
+
+float sensorsAdsCodeToVolt(int16_t raw) {
+  return adcToRealVolt(ads.computeVolts(raw));
+}
+
+void sensorsSetUvTripV(float vReal) {
+  adsAlertLoWant = sensorsVoltToAdsCode(vReal);
+}
+
+float sensorsAdsChValue(uint8_t ch) {
+  if (ch >= ADS_NUM_CH || !ADS_CH[ch].en) return NAN;
+  return adsChValue[ch];
+}
+
+const char* sensorsAdsChName(uint8_t ch) {
+  return ch < ADS_NUM_CH ? ADS_CH_NAMES[ch] : "?";
+}
+
+void sensorsSetAdsHook(uint8_t ch, AdsChHook fn) {
+  if (ch < ADS_NUM_CH) adsChHook[ch] = fn;
+}
+
+void sensorsGetAdsStats(AdsSeqStats &out) {
+  out.busUsPerS = adsBusUsPerS;
+  out.budgetUs  = ADS_BUS_BUDGET_US;
+  out.deferred  = adsAuxDeferred;
+  for (uint8_t i = 0; i < ADS_NUM_CH; ++i) out.samples[i] = adsChSamples[i];
+}
+
+uint32_t IRAM_ATTR sensorsAdsConvStartUs() {
+  return adsStartUs;
+}
+
 // Heatsink temp (Celsius)
 float getHeatsinkC() {
   return gHeatC; // bisa NAN jika belum valid
 }
 
+uint8_t sensorsTempCount() {
+  return DS18B20_MAX_SENSORS;
+}
+
+float sensorsTempC(uint8_t idx) {
+  if (idx >= DS18B20_MAX_SENSORS || !dsProbe[idx].used) return NAN;
+  return dsProbe[idx].tempC;
+}
+
+const char* sensorsTempName(uint8_t idx) {
+  return idx < DS18B20_MAX_SENSORS ? DS_NAMES[idx] : "?";
+}
+
+bool sensorsTempRom(uint8_t idx, char* out, size_t n) {
+  if (idx >= DS18B20_MAX_SENSORS || !dsProbe[idx].used || !out || n < 17) return false;
+  const uint8_t *r = dsProbe[idx].rom;
+  snprintf(out, n, "%02X%02X%02X%02X%02X%02X%02X%02X",
+           r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7]);
+  return true;
+}
+
+float sensorsTempMaxC() {
+  return gTempMaxC;
+}
+
+bool sensorsTempFault() {
+  bool any = false;
+  for (const DsProbe &p : dsProbe) {
+    if (!p.used) continue;
+    any = true;
+    if (isnan(p.tempC)) return true;
+  }
+  return !any;
+}
+
+void sensorsGetTempStats(DsTempStats& out) {
+  out.found     = dsFound;
+  out.known     = 0;
+  for (const DsProbe &p : dsProbe) {
+    if (p.used) ++out.known;
+  }
+  out.convMs    = dsConvMs;
+  out.crcErrors = dsCrcErrors;
+  out.misses    = dsMisses;
+  out.readUsMax = dsReadUsMax;
+}
+
 float sensorsGetRtcTempC() {
   if (!FEAT_RTC_TEMP_TELEMETRY) {
     return NAN;
@@ -284,19 +1001,45 @@ float sensorsGetRtcTempC() {
   return rtcTempC;
 }
 
+// Milidetik dalam detik berjalan; dibatasi 999 agar tidak mendahului tepi SQW
+static uint16_t clockSubMs(uint32_t nowMs) {
+  uint32_t ms = nowMs - clkEdgeMs;
+  return (uint16_t)(ms > 999 ? 999 : ms);
+}
+
+bool sensorsGetTime(uint32_t& epochOut, uint16_t& msOut) {
+  if (!clkValid) return false;
+  epochOut = clkEpoch;
+  msOut    = clockSubMs(millis());
+  return true;
+}
+
 bool sensorsGetTimeISO(char* out, size_t n) {
   if (!out || n == 0) return false;
-  if (!rtcReady) {
+  if (!clkValid) {
     out[0] = '\0';
     return false;
   }
-  DateTime now = rtc.now();
-  snprintf(out, n, "%04u-%02u-%02uT%02u:%02u:%02uZ",
-           now.year(), now.month(), now.day(),
-           now.hour(), now.minute(), now.second());
+  // String diformat ulang hanya saat detik berganti
+  if (clkIsoEpoch != clkEpoch) {
+    DateTime t(clkEpoch);
+    snprintf(clkIso, sizeof(clkIso), "%04u-%02u-%02uT%02u:%02u:%02uZ",
+             t.year(), t.month(), t.day(), t.hour(), t.minute(), t.second());
+    clkIsoEpoch = clkEpoch;
+  }
+  strlcpy(out, clkIso, n);
   return true;
 }
 
+void sensorsGetClockStats(RtcClockStats& out) {
+  out.valid     = clkValid;
+  out.sqwOk     = clkSqwOk;
+  out.edges     = clkEdgesSeen;
+  out.rtcReads  = clkRtcReads;
+  out.sqwLost   = clkSqwLost;
+  out.lastStepS = clkLastStepS;
+}
+
 bool sensorsSqwConsumeTick() {
   if (rtcSqwTick) {
     rtcSqwTick = false;
@@ -308,37 +1051,37 @@ bool sensorsSqwConsumeTick() {
 // Salin band analyzer (0..255)
 void analyzerGetBytes(uint8_t outBands[], size_t nBands) {
   size_t n = (nBands < ANA_BANDS) ? nBands : ANA_BANDS;
+  portENTER_CRITICAL(&anaMux);
   for (size_t i = 0; i < n; ++i) outBands[i] = bandsOut[i];
+  portEXIT_CRITICAL(&anaMux);
 }
 
-// VU mono 0..255
+// VU mono 0..255 (frame FFT terakhir)
 void analyzerGetVu(uint8_t &monoVu) {
-  monoVu = computeVuMono();
+  portENTER_CRITICAL(&anaMux);
+  monoVu = vuOut;
+  portEXIT_CRITICAL(&anaMux);
 }
 
 // Enable/disable analyzer (hemat beban saat STANDBY)
 void sensorsSetAnalyzerEnabled(bool en) {
-  gAnalyzerEn = en;
-#if I2S_USE_BUILTIN_ADC
-  if (i2sReady) {
-    if (en) {
-      i2s_adc_enable(I2S_PORT);
-    } else {
-      i2s_adc_disable(I2S_PORT);
-    }
-  }
-#endif
+  // Diterapkan task analyzer (pemilik I2S); standby = task tidur penuh
+  anaWantEn = en;
+  tasksNotify(TaskId::Analyzer);
 }
 
 bool sensorsGetUnixTime(uint32_t& epochOut) {
-  if (!rtcReady) return false;
-  DateTime now = rtc.now();
-  epochOut = now.unixtime();
+  if (!clkValid) return false;
+  epochOut = clkEpoch;
   return true;
 }
 
 bool sensorsSetUnixTime(uint32_t epoch) {
   if (!rtcReady) return false;
-  rtc.adjust(DateTime(epoch));
+  if (!i2cBusRun(I2cDev::Rtc, rtcAdjustJob, epoch, 8)) return false;
+  // Tulis detik me-reset rantai pembagi DS3231 → tepi berikutnya ±1 s lagi
+  clockAnchor(epoch, millis());
+  clkLastReadMs = millis();
+  clkResync = true;
   return true;
 }
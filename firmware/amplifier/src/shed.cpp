@@ -0,0 +1,100 @@
+#include "shed.h"
+#include "config.h"
+#include "comms.h"
+
+#if LOG_ENABLE
+  #define LOGF(...)  do { Serial.printf(__VA_ARGS__); } while (0)
+#else
+  #define LOGF(...)  do {} while (0)
+#endif
+
+static const char* const kNames[(uint8_t)ShedLevel::Count] = {
+  "none", "oled", "telemetry"
+};
+
+// Dibaca task ui/analyzer tanpa lock (satu byte)
+static volatile uint8_t sLevel = 0;
+
+static uint32_t sWinStartMs  = 0;
+static uint32_t sWinMaxUs    = 0;
+static uint8_t  sWinOverruns = 0;
+static bool     sExcuse      = false;
+static uint8_t  sCleanWins   = 0;
+
+static uint32_t sOverruns    = 0;
+static uint32_t sExcused     = 0;
+static uint32_t sIterMaxUs   = 0;
+static uint32_t sEnters[(uint8_t)ShedLevel::Count] = {0};
+static uint32_t sExits[(uint8_t)ShedLevel::Count]  = {0};
+
+static void logDecision(const char *prefix, uint8_t lvl, const char *level) {
+  char msg[32];
+  snprintf(msg, sizeof(msg), "%s_%s", prefix, kNames[lvl]);
+  LOGF("[SHED] %s (win max %lu us)\n", msg, (unsigned long)sWinMaxUs);
+  commsLog(level, msg);
+}
+
+static void closeWindow() {
+  uint8_t lvl = sLevel;
+  if (sWinOverruns >= SHED_MIN_OVERRUNS) {
+    sCleanWins = 0;
+    if (lvl + 1 < (uint8_t)ShedLevel::Count) {
+      ++lvl;
+      sLevel = lvl;
+      ++sEnters[lvl];
+      logDecision("shed", lvl, "warn");
+    }
+    return;
+  }
+  if (lvl == 0) return;
+  if (sWinMaxUs * 100UL >= (uint32_t)SHED_LOOP_BUDGET_US * SHED_HEADROOM_PCT) {
+    sCleanWins = 0;     // di bawah anggaran tapi belum lega → tahan level
+    return;
+  }
+  if (++sCleanWins < SHED_RESTORE_WINDOWS) return;
+  sCleanWins = 0;
+  ++sExits[lvl];
+  logDecision("restore", lvl, "info");
+  sLevel = lvl - 1;
+}
+
+void shedExcuseIter() {
+  sExcuse = true;
+}
+
+void shedLoopSample(uint32_t now, uint32_t iterUs) {
+  if (iterUs > sIterMaxUs) sIterMaxUs = iterUs;
+  if (sExcuse) {
+    sExcuse = false;
+    ++sExcused;
+  } else {
+    if (iterUs > sWinMaxUs) sWinMaxUs = iterUs;
+    if (iterUs > SHED_LOOP_BUDGET_US) {
+      ++sOverruns;
+      if (sWinOverruns < 255) ++sWinOverruns;
+    }
+  }
+  if (now - sWinStartMs < SHED_WINDOW_MS) return;
+  closeWindow();
+  sWinStartMs  = now;
+  sWinMaxUs    = 0;
+  sWinOverruns = 0;
+}
+
+ShedLevel shedLevel() {
+  return (ShedLevel)sLevel;
+}
+
+const char* shedLevelName(ShedLevel l) {
+  return (uint8_t)l < (uint8_t)ShedLevel::Count ? kNames[(uint8_t)l] : "?";
+}
+
+void shedGetStats(ShedStats &out) {
+  out.level     = (ShedLevel)sLevel;
+  out.budgetUs  = SHED_LOOP_BUDGET_US;
+  out.overruns  = sOverruns;
+  out.excused   = sExcused;
+  out.iterMaxUs = sIterMaxUs;
+  memcpy(out.enters, sEnters, sizeof(out.enters));
+  memcpy(out.exits, sExits, sizeof(out.exits));
+}
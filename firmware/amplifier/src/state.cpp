@@ -1,6 +1,12 @@
 #include "state.h"
 #include "config.h"
+#include "sched.h"
+#include "shed.h"
 #include <Preferences.h>
+#include <esp_rom_crc.h>
+#include <nvs.h>
+#include <stddef.h>
+#include <atomic>
 
 // Namespace NVS tunggal untuk semua setting
 static Preferences nv;
@@ -9,23 +15,83 @@ static Preferences nv;
 static bool gOn = false;
 static bool gStby = true;
 
+// -------- Settings blob (satu entri NVS "cfg") --------
+// Layout payload = ABI. Field baru HANYA ditambah di akhir + naikkan
+// SETTINGS_VERSION; blob versi lama otomatis diisi default untuk field baru.
+struct __attribute__((packed)) SettingsBlob {
+  uint8_t  spkBig;
+  uint8_t  spkPwr;
+  uint8_t  fanMode;
+  uint8_t  smpsBypass;
+  uint16_t fanDuty;
+  uint8_t  btEn;
+  uint8_t  reserved;
+  float    smpsCutV;
+  float    smpsRecV;
+  uint32_t btOffMs;
+  uint32_t rtcSyncTs;
+  // v2
+  uint8_t  fanPi;
+  uint8_t  fanCurveN;
+  uint8_t  fanCurveT[FAN_CURVE_MAX_POINTS];
+  uint16_t fanCurveD[FAN_CURVE_MAX_POINTS];
+};
+
+struct __attribute__((packed)) SettingsHdr {
+  uint16_t magic;     // SETTINGS_MAGIC
+  uint8_t  version;   // versi layout payload
+  uint8_t  length;    // sizeof(payload) saat ditulis
+  uint32_t crc;       // CRC32 payload
+};
+
+static constexpr uint16_t SETTINGS_MAGIC   = 0x4A41;  // "JA"
+static constexpr uint8_t  SETTINGS_VERSION = 2;
+static constexpr size_t   SETTINGS_MAX_BLOB = 96;
+
 // Cached persisted values (diisi saat stateInit)
-static bool     sSpeakerBig;
-static bool     sSpeakerPwr;
-static FanMode  sFanMode;
-static uint16_t sFanDuty;
+static SettingsBlob sCfg;
 
-static bool     sSmpsBypass;
-static float    sSmpsCutV;
-static float    sSmpsRecV;
+// Write-behind: setter menandai bit dirty; stateTick() menulis ulang blob
+enum : uint16_t {
+  D_SPK_BIG     = 1u << 0,
+  D_SPK_PWR     = 1u << 1,
+  D_FAN_MODE    = 1u << 2,
+  D_FAN_DUTY    = 1u << 3,
+  D_SMPS_BYPASS = 1u << 4,
+  D_SMPS_CUT    = 1u << 5,
+  D_SMPS_REC    = 1u << 6,
+  D_BT_EN       = 1u << 7,
+  D_BT_OFFMS    = 1u << 8,
+  D_RTC_SYNC    = 1u << 9,
+  D_FAN_CURVE   = 1u << 10,
+  D_FAN_PI      = 1u << 11,
+};
+static uint8_t  sBatchDepth   = 0;
+static uint8_t  sBatchNew     = 0;
+static uint16_t sDirty        = 0;
+static uint32_t sFirstDirtyMs = 0;   // perubahan pertama sejak commit terakhir
+static uint32_t sLastDirtyMs  = 0;   // perubahan terakhir (untuk debounce)
 
-static bool     sBtEn;
-static uint32_t sBtOffMs;
+static StateNvsStats sStats = {};
+static uint32_t      sEtag  = 0;
+// Seqlock kurva kipas (ditulis task comms, dibaca task safety): ganjil =
+// sedang ditulis; naik 2 per perubahan → power kompilasi ulang LUT
+static std::atomic<uint32_t> sFanCurveRev{0};
 
-static uint32_t sRtcSyncTs;
+static void fanCurveWriteBegin() {
+  sFanCurveRev.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+static void fanCurveWriteEnd() {
+  sFanCurveRev.fetch_add(1, std::memory_order_release);
+}
 
 // Helpers untuk key
 static constexpr const char* NS               = "jacktor_audio";
+static constexpr const char* K_CFG            = "cfg";
+
+// Key per-setting layout lama (≤ v0) — hanya dibaca saat migrasi lalu dihapus
 static constexpr const char* K_SPK_BIG        = "spk_big";
 static constexpr const char* K_SPK_PWR        = "spk_pwr";
 static constexpr const char* K_FAN_MODE       = "fan_mode";
@@ -37,21 +103,160 @@ static constexpr const char* K_BT_EN          = "bt_en";
 static constexpr const char* K_BT_OFFMS       = "bt_off";
 static constexpr const char* K_RTC_SYNC       = "rtc_sync";
 
-static void loadFromNvs() {
-  sSpeakerBig  = nv.getBool  (K_SPK_BIG,  SPK_DEFAULT_BIG);
-  sSpeakerPwr  = nv.getBool  (K_SPK_PWR,  false);
+static uint32_t settingsCrc(const SettingsBlob &c) {
+  return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&c), sizeof(c));
+}
+
+// rtcSyncTs bukan setting host → tidak ikut etag (field sebelum + sesudahnya)
+static void updateEtag() {
+  const uint8_t *p = reinterpret_cast<const uint8_t*>(&sCfg);
+  constexpr size_t tail = offsetof(SettingsBlob, fanPi);
+  sEtag = esp_rom_crc32_le(0, p, offsetof(SettingsBlob, rtcSyncTs));
+  sEtag = esp_rom_crc32_le(sEtag, p + tail, sizeof(SettingsBlob) - tail);
+}
+
+static void fanCurveToCfg(const FanCurve &c) {
+  memset(sCfg.fanCurveT, 0, sizeof(sCfg.fanCurveT));
+  memset(sCfg.fanCurveD, 0, sizeof(sCfg.fanCurveD));
+  sCfg.fanCurveN = c.n;
+  for (uint8_t i = 0; i < c.n; ++i) {
+    sCfg.fanCurveT[i] = c.tC[i];
+    sCfg.fanCurveD[i] = c.duty[i];
+  }
+}
 
-  sFanMode     = (FanMode) nv.getUChar (K_FAN_MODE, (uint8_t)FanMode::AUTO);
-  sFanDuty     = nv.getUShort(K_FAN_DUTY, FAN_CUSTOM_DUTY);
+static void loadDefaults() {
+  memset(&sCfg, 0, sizeof(sCfg));
+  sCfg.spkBig     = SPK_DEFAULT_BIG ? 1 : 0;
+  sCfg.spkPwr     = 0;
+  sCfg.fanMode    = (uint8_t)FanMode::AUTO;
+  sCfg.fanDuty    = FAN_CUSTOM_DUTY;
+  sCfg.smpsBypass = SMPS_PROTECT_BYPASS ? 1 : 0;
+  sCfg.smpsCutV   = SMPS_CUT_V;
+  sCfg.smpsRecV   = SMPS_REC_V;
+  sCfg.btEn       = (FEAT_BT_ENABLE_AT_BOOT != 0) ? 1 : 0;
+  sCfg.btOffMs    = BT_AUTO_OFF_IDLE_MS;
+  sCfg.rtcSyncTs  = 0;
+  sCfg.fanPi      = 0;
+  FanCurve def;
+  fanCurveDefault(def);
+  fanCurveToCfg(def);
+}
+
+static const char* const LEGACY_KEYS[] = {
+  K_SPK_BIG, K_SPK_PWR, K_FAN_MODE, K_FAN_DUTY, K_SMPS_BYPASS,
+  K_SMPS_CUT, K_SMPS_REC, K_BT_EN, K_BT_OFFMS, K_RTC_SYNC
+};
+
+static bool hasLegacyKeys() {
+  for (const char *k : LEGACY_KEYS) {
+    if (nv.isKey(k)) return true;
+  }
+  return false;
+}
 
-  sSmpsBypass  = nv.getBool  (K_SMPS_BYPASS, SMPS_PROTECT_BYPASS);
-  sSmpsCutV    = nv.getFloat (K_SMPS_CUT,    SMPS_CUT_V);
-  sSmpsRecV    = nv.getFloat (K_SMPS_REC,    SMPS_REC_V);
+// Migrasi layout per-key lama → struct (nilai yang hilang = default)
+static void loadLegacy() {
+  sCfg.spkBig     = nv.getBool  (K_SPK_BIG,  sCfg.spkBig) ? 1 : 0;
+  sCfg.spkPwr     = nv.getBool  (K_SPK_PWR,  sCfg.spkPwr) ? 1 : 0;
+  sCfg.fanMode    = nv.getUChar (K_FAN_MODE, sCfg.fanMode);
+  sCfg.fanDuty    = nv.getUShort(K_FAN_DUTY, sCfg.fanDuty);
+  sCfg.smpsBypass = nv.getBool  (K_SMPS_BYPASS, sCfg.smpsBypass) ? 1 : 0;
+  sCfg.smpsCutV   = nv.getFloat (K_SMPS_CUT,    sCfg.smpsCutV);
+  sCfg.smpsRecV   = nv.getFloat (K_SMPS_REC,    sCfg.smpsRecV);
+  sCfg.btEn       = nv.getBool  (K_BT_EN,    sCfg.btEn) ? 1 : 0;
+  sCfg.btOffMs    = nv.getULong (K_BT_OFFMS, sCfg.btOffMs);
+  sCfg.rtcSyncTs  = nv.getULong (K_RTC_SYNC, sCfg.rtcSyncTs);
+}
+
+// Satu putBytes = commit atomik seluruh setting
+static bool writeBlob() {
+  uint8_t buf[sizeof(SettingsHdr) + sizeof(SettingsBlob)];
+  SettingsHdr hdr;
+  hdr.magic   = SETTINGS_MAGIC;
+  hdr.version = SETTINGS_VERSION;
+  hdr.length  = (uint8_t)sizeof(SettingsBlob);
+  hdr.crc     = settingsCrc(sCfg);
+  memcpy(buf, &hdr, sizeof(hdr));
+  memcpy(buf + sizeof(hdr), &sCfg, sizeof(sCfg));
+  shedExcuseIter();   // commit flash: lama & dianggarkan, bukan overrun
+  bool ok = nv.putBytes(K_CFG, buf, sizeof(buf)) == sizeof(buf);
+  if (ok) ++sStats.writes;
+  return ok;
+}
 
-  sBtEn        = nv.getBool  (K_BT_EN,   FEAT_BT_ENABLE_AT_BOOT != 0);
-  sBtOffMs     = nv.getULong (K_BT_OFFMS, BT_AUTO_OFF_IDLE_MS);
+// Return sumber setting (StateLoadSrc)
+static StateLoadSrc readBlob() {
+  size_t len = nv.getBytesLength(K_CFG);
+  if (len < sizeof(SettingsHdr) || len > SETTINGS_MAX_BLOB) return StateLoadSrc::None;
+
+  uint8_t buf[SETTINGS_MAX_BLOB];
+  if (nv.getBytes(K_CFG, buf, len) != len) return StateLoadSrc::Corrupt;
+
+  SettingsHdr hdr;
+  memcpy(&hdr, buf, sizeof(hdr));
+  size_t payload = len - sizeof(hdr);
+  if (hdr.magic != SETTINGS_MAGIC || hdr.length != payload || hdr.version == 0 ||
+      hdr.version > SETTINGS_VERSION) {
+    return StateLoadSrc::Corrupt;
+  }
+  if (esp_rom_crc32_le(0, buf + sizeof(hdr), payload) != hdr.crc) return StateLoadSrc::Corrupt;
+
+  // Versi lama (payload lebih pendek) → field baru tetap default
+  memcpy(&sCfg, buf + sizeof(hdr), payload < sizeof(sCfg) ? payload : sizeof(sCfg));
+  sStats.blobVersion = hdr.version;
+  return hdr.version == SETTINGS_VERSION ? StateLoadSrc::Blob : StateLoadSrc::Migrated;
+}
+
+static void loadFromNvs() {
+  uint32_t t0 = micros();
+  fanCurveWriteBegin();   // loadDefaults/readBlob menimpa seluruh sCfg
+  loadDefaults();
+  StateLoadSrc src = readBlob();
+  if (src == StateLoadSrc::None && hasLegacyKeys()) {
+    loadLegacy();
+    src = StateLoadSrc::Legacy;
+  }
+  FanCurve cv;
+  stateGetFanCurve(cv);
+  if (!fanCurveValid(cv)) {
+    fanCurveDefault(cv);
+    fanCurveToCfg(cv);
+  }
+  fanCurveWriteEnd();
+  sStats.loadUs  = micros() - t0;
+  sStats.loadSrc = src;
 
-  sRtcSyncTs   = nv.getULong (K_RTC_SYNC, 0);
+  // Simpan ulang dalam format terbaru; key lama dihapus agar entri NVS lega
+  if (src == StateLoadSrc::Legacy || src == StateLoadSrc::Migrated || src == StateLoadSrc::Corrupt) {
+    if (writeBlob() && src == StateLoadSrc::Legacy) {
+      for (const char *k : LEGACY_KEYS) nv.remove(k);
+    }
+    sStats.blobVersion = SETTINGS_VERSION;
+  }
+  updateEtag();
+}
+
+// Dipanggil setter SETELAH cache berubah. Key yang sudah dirty cukup
+// digabung (tidak ada put tambahan) → dihitung sebagai write yang dihindari.
+static void persist(uint16_t bit) {
+  ++sStats.setCalls;
+  updateEtag();
+  uint32_t now = millis();
+  if (sDirty & bit) {
+    ++sStats.avoided;
+  } else {
+    if (sDirty == 0) sFirstDirtyMs = now;
+    sDirty |= bit;
+    if (sBatchDepth > 0) ++sBatchNew;
+  }
+  sLastDirtyMs = now;
+}
+
+// Setter dipanggil dengan nilai yang sama → tidak ada yang perlu ditulis
+static inline void persistSkip() {
+  ++sStats.setCalls;
+  ++sStats.avoided;
 }
 
 void stateInit() {
@@ -61,73 +266,182 @@ void stateInit() {
   // Default runtime: standby di boot dingin
   gOn = false;
   gStby = true;
+  schedEvery("nvs", stateTick, SCHED_NVS_MS, SCHED_NVS_BUDGET_US);
 }
 
 void stateFactoryReset() {
+  sDirty = 0;  // perubahan tertunda ikut dibuang
   nv.clear();
   loadFromNvs();
 }
 
+uint32_t stateSettingsEtag() { return sEtag; }
+
 // ----------------- Persisted setters/getters -----------------
-bool stateSpeakerIsBig() { return sSpeakerBig; }
+bool stateSpeakerIsBig() { return sCfg.spkBig != 0; }
 void stateSetSpeakerIsBig(bool big) {
-  sSpeakerBig = big;
-  nv.putBool(K_SPK_BIG, big);
+  if (sCfg.spkBig == big) { persistSkip(); return; }
+  sCfg.spkBig = big;
+  persist(D_SPK_BIG);
 }
 
-bool stateSpeakerPowerOn() { return sSpeakerPwr; }
+bool stateSpeakerPowerOn() { return sCfg.spkPwr != 0; }
 void stateSetSpeakerPowerOn(bool on) {
-  sSpeakerPwr = on;
-  nv.putBool(K_SPK_PWR, on);
+  if (sCfg.spkPwr == on) { persistSkip(); return; }
+  sCfg.spkPwr = on;
+  persist(D_SPK_PWR);
 }
 
-FanMode stateGetFanMode() { return sFanMode; }
+FanMode stateGetFanMode() { return (FanMode)sCfg.fanMode; }
 void stateSetFanMode(FanMode m) {
-  sFanMode = m;
-  nv.putUChar(K_FAN_MODE, (uint8_t)m);
+  if (sCfg.fanMode == (uint8_t)m) { persistSkip(); return; }
+  sCfg.fanMode = (uint8_t)m;
+  persist(D_FAN_MODE);
 }
 
-uint16_t stateGetFanCustomDuty() { return sFanDuty; }
+uint16_t stateGetFanCustomDuty() { return sCfg.fanDuty; }
 void     stateSetFanCustomDuty(uint16_t d) {
   if (d > 1023) d = 1023;
-  sFanDuty = d;
-  nv.putUShort(K_FAN_DUTY, d);
+  if (sCfg.fanDuty == d) { persistSkip(); return; }
+  sCfg.fanDuty = d;
+  persist(D_FAN_DUTY);
 }
 
-bool  stateSmpsBypass() { return sSmpsBypass; }
+bool  stateSmpsBypass() { return sCfg.smpsBypass != 0; }
 void  stateSetSmpsBypass(bool en) {
-  sSmpsBypass = en;
-  nv.putBool(K_SMPS_BYPASS, en);
+  if (sCfg.smpsBypass == en) { persistSkip(); return; }
+  sCfg.smpsBypass = en;
+  persist(D_SMPS_BYPASS);
 }
 
-float stateSmpsCutoffV() { return sSmpsCutV; }
+float stateSmpsCutoffV() { return sCfg.smpsCutV; }
 void  stateSetSmpsCutoffV(float v) {
-  sSmpsCutV = v;
-  nv.putFloat(K_SMPS_CUT, v);
+  if (sCfg.smpsCutV == v) { persistSkip(); return; }
+  sCfg.smpsCutV = v;
+  persist(D_SMPS_CUT);
 }
 
-float stateSmpsRecoveryV() { return sSmpsRecV; }
+float stateSmpsRecoveryV() { return sCfg.smpsRecV; }
 void  stateSetSmpsRecoveryV(float v) {
-  sSmpsRecV = v;
-  nv.putFloat(K_SMPS_REC, v);
+  if (sCfg.smpsRecV == v) { persistSkip(); return; }
+  sCfg.smpsRecV = v;
+  persist(D_SMPS_REC);
 }
 
-bool  stateBtEnabled() { return sBtEn; }
+bool  stateBtEnabled() { return sCfg.btEn != 0; }
 void  stateSetBtEnabled(bool en) {
-  sBtEn = en;
-  nv.putBool(K_BT_EN, en);
+  if (sCfg.btEn == en) { persistSkip(); return; }
+  sCfg.btEn = en;
+  persist(D_BT_EN);
 }
 
-uint32_t stateBtAutoOffMs() { return sBtOffMs; }
+uint32_t stateBtAutoOffMs() { return sCfg.btOffMs; }
 void     stateSetBtAutoOffMs(uint32_t ms) {
-  sBtOffMs = ms;
-  nv.putULong(K_BT_OFFMS, ms);
+  if (sCfg.btOffMs == ms) { persistSkip(); return; }
+  sCfg.btOffMs = ms;
+  persist(D_BT_OFFMS);
+}
+
+void stateGetFanCurve(FanCurve &out) {
+  memset(&out, 0, sizeof(out));
+  out.n = sCfg.fanCurveN > FAN_CURVE_MAX_POINTS ? FAN_CURVE_MAX_POINTS : sCfg.fanCurveN;
+  for (uint8_t i = 0; i < out.n; ++i) {
+    out.tC[i]   = sCfg.fanCurveT[i];
+    out.duty[i] = sCfg.fanCurveD[i];
+  }
 }
 
-uint32_t stateLastRtcSync() { return sRtcSyncTs; }
+bool stateSetFanCurve(const FanCurve &c) {
+  if (!fanCurveValid(c)) return false;
+  FanCurve cur;
+  stateGetFanCurve(cur);
+  bool same = cur.n == c.n &&
+              memcmp(cur.tC, c.tC, c.n) == 0 &&
+              memcmp(cur.duty, c.duty, c.n * sizeof(c.duty[0])) == 0;
+  if (same) { persistSkip(); return true; }
+  fanCurveWriteBegin();
+  fanCurveToCfg(c);
+  fanCurveWriteEnd();
+  persist(D_FAN_CURVE);
+  return true;
+}
+
+uint32_t stateFanCurveRev() { return sFanCurveRev.load(std::memory_order_acquire); }
+
+bool stateSnapshotFanCurve(FanCurve &out, uint32_t &rev) {
+  uint32_t r0 = sFanCurveRev.load(std::memory_order_acquire);
+  if (r0 & 1u) return false;
+  stateGetFanCurve(out);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (sFanCurveRev.load(std::memory_order_relaxed) != r0) return false;
+  rev = r0;
+  return fanCurveValid(out);
+}
+
+bool stateFanPi() { return sCfg.fanPi != 0; }
+void stateSetFanPi(bool en) {
+  if (sCfg.fanPi == en) { persistSkip(); return; }
+  sCfg.fanPi = en;
+  persist(D_FAN_PI);
+}
+
+uint32_t stateLastRtcSync() { return sCfg.rtcSyncTs; }
 void     stateSetLastRtcSync(uint32_t t) {
-  sRtcSyncTs = t;
-  nv.putULong(K_RTC_SYNC, t);
+  if (sCfg.rtcSyncTs == t) { persistSkip(); return; }
+  sCfg.rtcSyncTs = t;
+  persist(D_RTC_SYNC);
+}
+
+// ----------------- Write-behind commit -----------------
+// Gagal tulis → key tetap dirty; stateTick mencoba lagi setelah
+// NVS_WRITE_DEBOUNCE_MS (jam debounce diulang dari sekarang)
+bool stateFlush() {
+  if (sDirty == 0) return true;
+  uint32_t t0 = micros();
+  bool ok = writeBlob();
+  uint32_t dt = micros() - t0;
+  ++sStats.flushes;
+  if (dt > sStats.flushMaxUs) sStats.flushMaxUs = dt;
+  if (ok) {
+    sDirty = 0;
+  } else {
+    ++sStats.writeFails;
+    sFirstDirtyMs = sLastDirtyMs = millis();
+  }
+  return ok;
+}
+
+bool stateDirty() { return sDirty != 0; }
+
+void stateBatchBegin() {
+  if (sBatchDepth == 0) sBatchNew = 0;
+  if (sBatchDepth < 255) ++sBatchDepth;
+}
+
+uint8_t stateBatchEnd() {
+  if (sBatchDepth == 0) return 0;
+  --sBatchDepth;
+  return sBatchNew;
+}
+
+void stateGetNvsStats(StateNvsStats &out) {
+  out = sStats;
+  out.dirtyMask = sDirty;
+  nvs_stats_t st;
+  if (nvs_get_stats(NULL, &st) == ESP_OK) {
+    out.entriesUsed = (uint32_t)st.used_entries;
+    out.entriesFree = (uint32_t)st.free_entries;
+  }
+}
+
+const char* stateLoadSrcToStr(StateLoadSrc src) {
+  switch (src) {
+    case StateLoadSrc::Blob:     return "blob";
+    case StateLoadSrc::Migrated: return "migrated";
+    case StateLoadSrc::Legacy:   return "legacy";
+    case StateLoadSrc::Corrupt:  return "corrupt";
+    default:                     return "default";
+  }
 }
 
 // ----------------- Runtime power flags -----------------
@@ -138,8 +452,13 @@ void powerSetOn(bool on) {
   gStby = !on;
 }
 
-void stateTick() {
-  // Placeholder untuk future housekeeping; saat ini tidak ada pekerjaan periodik.
+void stateTick(uint32_t now) {
+  if (sDirty == 0 || sBatchDepth > 0) return;
+  bool quiet   = (now - sLastDirtyMs)  >= NVS_WRITE_DEBOUNCE_MS;
+  bool overdue = (now - sFirstDirtyMs) >= NVS_WRITE_MAX_DELAY_MS;
+  if (quiet || overdue) {
+    stateFlush();
+  }
 }
 
 bool stateSafeModeSoft() {
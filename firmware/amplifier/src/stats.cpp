@@ -0,0 +1,176 @@
+#include "stats.h"
+#include "config.h"
+#include "state.h"
+#include "sched.h"
+#include "shed.h"
+#include <Preferences.h>
+#include <esp_rom_crc.h>
+
+// Namespace terpisah dari setting → selamat dari nv.clear() factory reset
+static Preferences sNv;
+static constexpr const char* NS     = "jacktor_stats";
+static constexpr const char* K_LIFE = "life";
+
+struct __attribute__((packed)) StatsHdr {
+  uint16_t magic;     // STATS_MAGIC
+  uint8_t  version;
+  uint8_t  reserved;
+  uint16_t length;    // sizeof(LifetimeStats) saat ditulis
+  uint16_t pad;
+  uint32_t crc;       // CRC32 payload
+};
+
+static constexpr uint16_t STATS_MAGIC   = 0x4A53;  // "JS"
+static constexpr uint8_t  STATS_VERSION = 1;
+
+static LifetimeStats sStats = {};
+static bool     sDirty       = false;
+static bool     sRelayOn     = false;
+static uint16_t sFanDuty     = 0;
+static uint32_t sLastTickMs  = 0;
+static uint32_t sUptimeMs    = 0;   // sisa < 1 s yang belum masuk uptimeS
+static uint32_t sOnMs        = 0;
+static uint32_t sLastSaveMs  = 0;
+// Counter juga ditulis dari task safety (relay/trip/protector, prio lebih
+// tinggi di core yang sama) → semua mutasi sStats & snapshot lewat sStatsMux
+static portMUX_TYPE sStatsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Index bin: 0 = < min, n-1 = ≥ min + (n-2)*step
+static uint8_t binOf(float v, float minV, float step, uint8_t bins) {
+  if (v < minV) return 0;
+  int idx = 1 + (int)((v - minV) / step);
+  if (idx > bins - 1) idx = bins - 1;
+  return (uint8_t)idx;
+}
+
+static bool saveBlob() {
+  uint8_t buf[sizeof(StatsHdr) + sizeof(LifetimeStats)];
+  // Snapshot dulu, CRC dihitung atas salinan (bukan struct yang masih hidup)
+  portENTER_CRITICAL(&sStatsMux);
+  ++sStats.saves;
+  memcpy(buf + sizeof(StatsHdr), &sStats, sizeof(sStats));
+  sDirty = false;
+  portEXIT_CRITICAL(&sStatsMux);
+  StatsHdr hdr = {};
+  hdr.magic   = STATS_MAGIC;
+  hdr.version = STATS_VERSION;
+  hdr.length  = (uint16_t)sizeof(LifetimeStats);
+  hdr.crc     = esp_rom_crc32_le(0, buf + sizeof(hdr), sizeof(LifetimeStats));
+  memcpy(buf, &hdr, sizeof(hdr));
+  shedExcuseIter();   // commit flash: lama & dianggarkan, bukan overrun
+  return sNv.putBytes(K_LIFE, buf, sizeof(buf)) == sizeof(buf);
+}
+
+// Blob rusak / layout bin berubah (length beda) → mulai dari nol
+static void loadBlob() {
+  memset(&sStats, 0, sizeof(sStats));
+  uint8_t buf[sizeof(StatsHdr) + sizeof(LifetimeStats)];
+  if (sNv.getBytesLength(K_LIFE) != sizeof(buf)) return;
+  if (sNv.getBytes(K_LIFE, buf, sizeof(buf)) != sizeof(buf)) return;
+  StatsHdr hdr;
+  memcpy(&hdr, buf, sizeof(hdr));
+  if (hdr.magic != STATS_MAGIC || hdr.version != STATS_VERSION ||
+      hdr.length != sizeof(LifetimeStats)) {
+    return;
+  }
+  if (esp_rom_crc32_le(0, buf + sizeof(hdr), sizeof(LifetimeStats)) != hdr.crc) return;
+  memcpy(&sStats, buf + sizeof(hdr), sizeof(sStats));
+}
+
+void statsInit() {
+  sNv.begin(NS, /*readOnly=*/false);
+  loadBlob();
+  ++sStats.boots;
+  sDirty = true;
+  sLastTickMs = millis();
+  sLastSaveMs = sLastTickMs;
+  schedEvery("stats", statsTick, SCHED_STATS_MS, SCHED_STATS_BUDGET_US);
+}
+
+void statsTick(uint32_t now) {
+  uint32_t dt = now - sLastTickMs;
+  sLastTickMs = now;
+  sUptimeMs += dt;
+  if (sRelayOn) sOnMs += dt;
+  portENTER_CRITICAL(&sStatsMux);
+  if (sUptimeMs >= 1000) {
+    sStats.uptimeS += sUptimeMs / 1000;
+    sUptimeMs %= 1000;
+    sDirty = true;
+  }
+  if (sOnMs >= 1000) {
+    sStats.onS += sOnMs / 1000;
+    sOnMs %= 1000;
+  }
+  portEXIT_CRITICAL(&sStatsMux);
+  // Hindari tulis flash bersamaan dengan commit setting (stateTick)
+  if (sDirty && now - sLastSaveMs >= STATS_SAVE_INTERVAL_MS && !stateDirty()) {
+    statsFlush();
+  }
+}
+
+void statsFlush(bool force) {
+  if (!sDirty) return;
+  if (!force && millis() - sLastSaveMs < STATS_FLUSH_MIN_GAP_MS) return;
+  saveBlob();   // sDirty di-clear bersama snapshot
+  sLastSaveMs = millis();
+}
+
+void statsReset() {
+  portENTER_CRITICAL(&sStatsMux);
+  memset(&sStats, 0, sizeof(sStats));
+  sUptimeMs = 0;
+  sOnMs = 0;
+  sDirty = true;
+  portEXIT_CRITICAL(&sStatsMux);
+  statsFlush();
+}
+
+void statsGet(LifetimeStats &out) {
+  portENTER_CRITICAL(&sStatsMux);
+  out = sStats;
+  portEXIT_CRITICAL(&sStatsMux);
+}
+
+void statsOnRelay(bool on) {
+  portENTER_CRITICAL(&sStatsMux);
+  if (on && !sRelayOn) {
+    ++sStats.relayCycles;
+    sDirty = true;
+  }
+  sRelayOn = on;
+  portEXIT_CRITICAL(&sStatsMux);
+}
+
+void statsOnSmpsTrip() {
+  portENTER_CRITICAL(&sStatsMux);
+  ++sStats.smpsTrips;
+  sDirty = true;
+  portEXIT_CRITICAL(&sStatsMux);
+}
+
+void statsOnSpkFault() {
+  portENTER_CRITICAL(&sStatsMux);
+  ++sStats.spkFaults;
+  sDirty = true;
+  portEXIT_CRITICAL(&sStatsMux);
+}
+
+void statsOnFanDuty(uint16_t duty) {
+  sFanDuty = duty;
+}
+
+void statsOnSensors1Hz(float heatC, float smpsV) {
+  uint8_t hb = isnan(heatC) ? 0xFF
+             : binOf(heatC, STATS_HEAT_MIN_C, STATS_HEAT_STEP_C, STATS_HEAT_BINS);
+  uint8_t vb = smpsV > 0.0f
+             ? binOf(smpsV, STATS_VOLT_MIN_V, STATS_VOLT_STEP_V, STATS_VOLT_BINS) : 0xFF;
+  uint8_t fb = (uint8_t)(sFanDuty / (1024 / STATS_FAN_BINS));
+  if (fb >= STATS_FAN_BINS) fb = STATS_FAN_BINS - 1;
+  portENTER_CRITICAL(&sStatsMux);
+  if (hb != 0xFF) ++sStats.heatS[hb];
+  if (sRelayOn && vb != 0xFF) ++sStats.voltS[vb];
+  ++sStats.fanS[fb];
+  sDirty = true;
+  portEXIT_CRITICAL(&sStatsMux);
+}
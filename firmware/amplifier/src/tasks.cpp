@@ -0,0 +1,175 @@
+#include "tasks.h"
+#include "config.h"
+
+#include <esp_task_wdt.h>
+
+#include "power.h"
+#include "sensors.h"
+#include "buzzer.h"
+#include "ui.h"
+#include "i2c_bus.h"
+#include "perf.h"
+#include "shed.h"
+
+struct TaskSlot {
+  const char  *name;
+  uint8_t      core;
+  uint8_t      prio;
+  TaskHandle_t handle;
+  // jendela beban
+  uint32_t winStartMs;
+  uint32_t winBusyUs;
+  uint8_t  loadPct;
+  uint32_t maxUs;
+  uint32_t lateMaxUs;
+  uint32_t overruns;
+};
+
+static TaskSlot sTasks[(uint8_t)TaskId::Count] = {
+  { "safety",   SAFETY_TASK_CORE, SAFETY_TASK_PRIO, nullptr, 0, 0, 0, 0, 0, 0 },
+  { "comms",    1,                1,                nullptr, 0, 0, 0, 0, 0, 0 },
+  { "ui",       UI_TASK_CORE,     UI_TASK_PRIO,     nullptr, 0, 0, 0, 0, 0, 0 },
+  { "analyzer", ANA_TASK_CORE,    ANA_TASK_PRIO,    nullptr, 0, 0, 0, 0, 0, 0 },
+};
+static bool sRunning = false;
+
+static inline TaskSlot& slot(TaskId id) { return sTasks[(uint8_t)id]; }
+
+void tasksIterDone(TaskId id, uint32_t busyUs) {
+  TaskSlot &t = slot(id);
+  if (busyUs > t.maxUs) t.maxUs = busyUs;
+  t.winBusyUs += busyUs;
+  uint32_t now = millis();
+  uint32_t winMs = now - t.winStartMs;
+  if (winMs >= TASK_LOAD_WINDOW_MS) {
+    uint32_t pct = t.winBusyUs / (winMs * 10);
+    t.loadPct    = (uint8_t)(pct > 100 ? 100 : pct);
+    t.winBusyUs  = 0;
+    t.winStartMs = now;
+  }
+  if (sRunning) esp_task_wdt_reset();
+}
+
+// ---- Safety: periodik tetap, tidak pernah menunggu comms/ui ----------------
+static void safetyTask(void*) {
+  esp_task_wdt_add(nullptr);
+  const TickType_t period = pdMS_TO_TICKS(SAFETY_PERIOD_MS) > 0 ? pdMS_TO_TICKS(SAFETY_PERIOD_MS) : 1;
+  TickType_t wake = xTaskGetTickCount();
+  uint32_t   dueUs = micros();
+  for (;;) {
+    vTaskDelayUntil(&wake, period);
+    uint32_t t0 = micros();
+    dueUs += SAFETY_PERIOD_MS * 1000UL;
+    int32_t lateUs = (int32_t)(t0 - dueUs);
+    TaskSlot &t = slot(TaskId::Safety);
+    if (lateUs > 0 && (uint32_t)lateUs > t.lateMaxUs) t.lateMaxUs = (uint32_t)lateUs;
+    // Tertinggal > 1 periode (mis. flash write memblok cache) → fase ulang
+    if (lateUs > (int32_t)(SAFETY_PERIOD_MS * 1000UL)) dueUs = t0;
+
+    { PERF_SCOPE(PowerSafety); powerSafetyTick(millis()); }
+
+    uint32_t us = micros() - t0;
+    if (us > SAFETY_PERIOD_MS * 1000UL) ++t.overruns;
+    tasksIterDone(TaskId::Safety, us);
+  }
+}
+
+// ---- UI: OLED per frame, buzzer menunggu perintah di antara frame ----------
+static void uiTask(void*) {
+  esp_task_wdt_add(nullptr);
+  uint32_t nextFrameMs = millis();
+  for (;;) {
+    uint32_t t0  = micros();
+    uint32_t now = millis();
+    { PERF_SCOPE(BuzzTick); buzzTick(now); }
+    if ((int32_t)(now - nextFrameMs) >= 0) {
+      { PERF_SCOPE(UiTick); uiTick(now); }
+      // Load shedding level oled: setengah frame rate
+      uint32_t frameMs = shedLevel() >= ShedLevel::Oled ? UI_FRAME_MS * 2 : UI_FRAME_MS;
+      nextFrameMs += frameMs;
+      if ((int32_t)(now - nextFrameMs) >= 0) nextFrameMs = now + frameMs;
+    }
+    i2cBusTick(millis(), I2C_PRIO_NORMAL, I2C_PRIO_LOW);   // flush OLED, RTC
+    tasksIterDone(TaskId::Ui, micros() - t0);
+
+    now = millis();
+    uint32_t waitMs = (int32_t)(nextFrameMs - now) > 0 ? nextFrameMs - now : 0;
+    uint32_t buzzMs = buzzNextDueMs(now);
+    if (buzzMs < waitMs) waitMs = buzzMs;
+    if (i2cBusQueued() && waitMs > 1) waitMs = 1;
+    buzzWaitCmd(waitMs);
+  }
+}
+
+// ---- Analyzer: I2S blocking + FFT, tidur saat nonaktif ---------------------
+static void analyzerTask(void*) {
+  esp_task_wdt_add(nullptr);
+  for (;;) {
+    analyzerWait(ANA_TASK_WAIT_MS);
+    uint32_t t0 = micros();
+    { PERF_SCOPE(Analyzer); analyzerWork(millis()); }
+    tasksIterDone(TaskId::Analyzer, micros() - t0);
+  }
+}
+
+void tasksStart() {
+  esp_task_wdt_init(TASK_WDT_TIMEOUT_S, true);
+  uint32_t now = millis();
+  for (auto &t : sTasks) t.winStartMs = now;
+
+  TaskSlot &c = slot(TaskId::Comms);
+  c.handle = xTaskGetCurrentTaskHandle();
+  c.core   = (uint8_t)xPortGetCoreID();
+  c.prio   = (uint8_t)uxTaskPriorityGet(nullptr);
+  esp_task_wdt_add(nullptr);
+
+  // Handle dipasang sebelum task jalan: buzzPost/tasksIsCurrent membacanya
+  sRunning = true;
+  xTaskCreatePinnedToCore(safetyTask, "safety", SAFETY_TASK_STACK, nullptr,
+                          SAFETY_TASK_PRIO, &slot(TaskId::Safety).handle, SAFETY_TASK_CORE);
+  xTaskCreatePinnedToCore(uiTask, "ui", UI_TASK_STACK, nullptr,
+                          UI_TASK_PRIO, &slot(TaskId::Ui).handle, UI_TASK_CORE);
+  xTaskCreatePinnedToCore(analyzerTask, "analyzer", ANA_TASK_STACK, nullptr,
+                          ANA_TASK_PRIO, &slot(TaskId::Analyzer).handle, ANA_TASK_CORE);
+}
+
+bool tasksRunning() {
+  return sRunning;
+}
+
+bool tasksIsCurrent(TaskId id) {
+  TaskHandle_t h = slot(id).handle;
+  return h && h == xTaskGetCurrentTaskHandle();
+}
+
+TaskId tasksCurrent() {
+  if (xPortInIsrContext()) return TaskId::Count;
+  TaskHandle_t h = xTaskGetCurrentTaskHandle();
+  for (uint8_t i = 0; i < (uint8_t)TaskId::Count; ++i) {
+    if (sTasks[i].handle == h) return (TaskId)i;
+  }
+  return TaskId::Count;
+}
+
+void tasksNotify(TaskId id) {
+  TaskHandle_t h = slot(id).handle;
+  if (h) xTaskNotifyGive(h);
+}
+
+bool tasksGetStats(TaskId id, TaskStats &out) {
+  if ((uint8_t)id >= (uint8_t)TaskId::Count) return false;
+  const TaskSlot &t = slot(id);
+  out.name      = t.name;
+  out.core      = t.core;
+  out.prio      = t.prio;
+  out.loadPct   = t.loadPct;
+  out.stackFree = t.handle ? uxTaskGetStackHighWaterMark(t.handle) : 0;
+  out.maxUs     = t.maxUs;
+  out.lateMaxUs = t.lateMaxUs;
+  out.overruns  = t.overruns;
+  return true;
+}
+
+const char* taskName(TaskId id) {
+  return (uint8_t)id < (uint8_t)TaskId::Count ? slot(id).name : "?";
+}
@@ -0,0 +1,75 @@
+#include "trace.h"
+#include "tasks.h"
+
+#include <Arduino.h>
+#include <atomic>
+
+static_assert((TRACE_RECORDS & (TRACE_RECORDS - 1)) == 0, "TRACE_RECORDS harus pangkat 2");
+
+static TraceRec              sRing[TRACE_RECORDS];
+static std::atomic<uint32_t> sHead{0};       // total slot yang pernah diambil
+static std::atomic<bool>     sFrozen{false};
+static std::atomic<uint32_t> sDrops{0};
+
+// Snapshot saat dibekukan: record [sSnapStart, sSnapStart + sSnapCount)
+static uint32_t sSnapStart = 0;
+static uint16_t sSnapCount = 0;
+
+#if TRACE_ENABLE
+void traceEmit(TraceEv ev, uint16_t a, uint32_t b) {
+  if (sFrozen.load(std::memory_order_relaxed)) {
+    sDrops.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  uint32_t i = sHead.fetch_add(1, std::memory_order_relaxed);
+  TraceRec &r = sRing[i & (TRACE_RECORDS - 1)];
+  TaskId t = tasksCurrent();
+  r.tsUs = micros();
+  r.id   = (uint8_t)ev;
+  r.task = t == TaskId::Count ? TRACE_TASK_OTHER : (uint8_t)t;
+  r.a    = a;
+  r.b    = b;
+}
+
+void traceSpan(TraceEv ev, uint32_t t0Us, uint16_t a) {
+  traceEmit(ev, a, micros() - t0Us);
+}
+#endif
+
+void traceGetStats(TraceStats &out) {
+  uint32_t head = sHead.load(std::memory_order_relaxed);
+  out.written = head;
+  out.drops   = sDrops.load(std::memory_order_relaxed);
+  out.frozen  = sFrozen.load(std::memory_order_relaxed);
+  out.count   = out.frozen ? sSnapCount
+                           : (uint16_t)(head < TRACE_RECORDS ? head : TRACE_RECORDS);
+}
+
+void traceClear() {
+  sHead.store(0, std::memory_order_relaxed);
+  sDrops.store(0, std::memory_order_relaxed);
+  sSnapCount = 0;
+}
+
+// Penulis yang sudah lolos cek beku masih bisa menyelesaikan satu record;
+// dump mulai paling cepat satu tick comms kemudian, jadi slot itu sudah terisi
+void traceFreeze(bool frozen) {
+  if (frozen) {
+    sFrozen.store(true, std::memory_order_release);
+    uint32_t head = sHead.load(std::memory_order_acquire);
+    sSnapCount = (uint16_t)(head < TRACE_RECORDS ? head : TRACE_RECORDS);
+    sSnapStart = head - sSnapCount;
+  } else {
+    sFrozen.store(false, std::memory_order_release);
+  }
+}
+
+uint16_t traceRead(uint16_t off, TraceRec *out, uint16_t maxN) {
+  if (!sFrozen.load(std::memory_order_acquire) || off >= sSnapCount) return 0;
+  uint16_t n = sSnapCount - off;
+  if (n > maxN) n = maxN;
+  for (uint16_t k = 0; k < n; ++k) {
+    out[k] = sRing[(sSnapStart + off + k) & (TRACE_RECORDS - 1)];
+  }
+  return n;
+}
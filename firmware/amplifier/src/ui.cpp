@@ -3,6 +3,7 @@
 #include "state.h"
 #include "power.h"
 #include "sensors.h"
+#include "i2c_bus.h"
 
 #include <U8g2lib.h>
 #include <cstring>
@@ -25,7 +26,19 @@ enum class UiScene : uint8_t {
 };
 
 static UiScene gScene = UiScene::SPLASH;
-static char    gClock[9] = "00:00:00";
+static char    gClock[9] = "00:00:00";   // ditulis task comms → gClockMux
+static portMUX_TYPE gClockMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Render jalan di task ui; layar factory reset bisa datang dari task comms
+static SemaphoreHandle_t sUiLock = nullptr;
+
+static void uiLock() {
+  if (sUiLock) xSemaphoreTake(sUiLock, portMAX_DELAY);
+}
+
+static void uiUnlock() {
+  if (sUiLock) xSemaphoreGive(sUiLock);
+}
 
 static bool    gBtMode = false;     // true=BT, false=AUX
 static bool    gSpkBig = SPK_DEFAULT_BIG;
@@ -35,7 +48,134 @@ static uint8_t gBootRows = 0;
 static const uint8_t MAX_BOOT_ROWS = 6; // 6 baris muat di 128x64
 
 // Pace refresh
-static uint32_t lastDrawMs = 0;
+
+// ================= RETAINED MODE =================
+/*
+ * Nilai yang terikat ke layar. uiTick() hanya menggambar ulang bila model
+ * berubah; hasil gambar dibandingkan dengan shadow (isi panel terakhir) per
+ * page SSD1306 (8 baris) dan hanya rentang tile yang berubah dikirim lewat
+ * updateDisplayArea(). Jam standby → hanya page jam tiap detik.
+ */
+struct UiModel {
+  UiScene scene;
+  bool    bt;
+  bool    spkBig;
+  bool    fault;
+  int16_t v10;        // tegangan ×10 (resolusi teks)
+  int16_t t10;        // suhu ×10, INT16_MIN bila NAN
+  uint8_t vuW;        // lebar bar VU (px)
+  char    clock[9];
+};
+
+static constexpr uint8_t  UI_PAGES      = OLED_H / 8;
+static constexpr uint16_t UI_BUF_BYTES  = OLED_W * UI_PAGES;
+static constexpr uint8_t  UI_AREA_OVERHEAD = 7;   // byte perintah I2C per area (kolom/page + control)
+
+static UiModel  gModel;
+static bool     gModelValid = false;          // false → paksa gambar ulang
+static constexpr uint8_t  UI_TILES      = OLED_W / 8;
+static_assert(UI_TILES <= 16, "mask tile per page 16 bit");
+
+static uint8_t  gShadow[UI_BUF_BYTES];        // isi GDDRAM panel terakhir
+static uint16_t gStale[UI_PAGES];             // tile yang isi panelnya tidak diketahui
+static bool     gFlushPending = false;        // ada chunk gagal → ulang tick berikutnya
+
+// Seluruh panel tidak diketahui (boot, OLED tersambung lagi)
+static void shadowInvalidate() {
+  for (uint8_t p = 0; p < UI_PAGES; ++p) gStale[p] = 0xFFFF;
+}
+
+// Statistik I2C OLED
+static uint32_t gBytesTotal  = 0;
+static uint32_t gBytesWinStart = 0;
+static uint32_t gBytesWinMs  = 0;
+static uint32_t gBytesPerSec = 0;
+static uint32_t gRedraws     = 0;
+static uint32_t gChunksSent  = 0;
+static uint32_t gSkipped     = 0;             // tick tanpa perubahan model
+
+static bool     gOledLost    = false;         // job gagal → shadow tidak sinkron
+static bool     gOledWasOnline = true;
+
+// Satu transaksi OLED: tw tile mulai (tx, page). arg = tx | page<<8 | tw<<16
+// U8g2 tidak melaporkan NACK → probe alamat dulu.
+static bool oledAreaJob(uint32_t arg) {
+  if (!i2cBusProbe(OLED_I2C_ADDR)) {
+    gOledLost = true;
+    return false;
+  }
+  u8g2.updateDisplayArea((uint8_t)(arg & 0xFF), (uint8_t)((arg >> 8) & 0xFF),
+                         (uint8_t)((arg >> 16) & 0xFF), 1);
+  return true;
+}
+
+// Panel yang tersambung lagi bisa saja baru power-on → init ulang controller
+static bool oledInitJob(uint32_t) {
+  if (!i2cBusProbe(OLED_I2C_ADDR)) return false;
+  u8g2.initDisplay();
+  u8g2.setPowerSave(0);
+  return true;
+}
+
+// Kirim hanya page yang berubah, dipangkas ke rentang tile (8 kolom) kotor
+// dan dipecah per I2C_OLED_CHUNK_TILES. sync=false → job LOW di penjadwal
+// I2C (voltmeter tetap didahulukan); sync=true untuk layar yang langsung
+// diikuti delay/restart (boot, factory reset) saat loop belum/tidak jalan.
+// Chunk yang gagal disubmit tidak menyentuh shadow sehingga tile-nya tetap
+// kotor dan dikirim ulang tick berikutnya (gFlushPending), tanpa redraw penuh.
+static void flushDirty(bool sync) {
+  const uint8_t *buf = u8g2.getBufferPtr();
+  bool allOk = true;
+  for (uint8_t page = 0; page < UI_PAGES; ++page) {
+    const uint8_t *row = buf + page * OLED_W;
+    uint8_t *shadow = gShadow + page * OLED_W;
+    int first = -1;
+    int last = -1;
+    for (uint8_t t = 0; t < UI_TILES; ++t) {
+      if ((gStale[page] & (1u << t)) || memcmp(row + t * 8, shadow + t * 8, 8) != 0) {
+        if (first < 0) first = t;
+        last = t;
+      }
+    }
+    if (first < 0) continue;
+    for (int tx = first; tx <= last; tx += I2C_OLED_CHUNK_TILES) {
+      int tw = last - tx + 1;
+      if (tw > I2C_OLED_CHUNK_TILES) tw = I2C_OLED_CHUNK_TILES;
+      uint32_t arg = (uint32_t)tx | ((uint32_t)page << 8) | ((uint32_t)tw << 16);
+      uint16_t est = (uint16_t)(tw * 8 + UI_AREA_OVERHEAD);
+      bool ok = sync ? i2cBusRun(I2cDev::Oled, oledAreaJob, arg, est)
+                     : i2cBusSubmit(I2cDev::Oled, I2C_PRIO_LOW, oledAreaJob, arg, est);
+      if (!ok) {
+        allOk = false;
+        continue;
+      }
+      memcpy(shadow + tx * 8, row + tx * 8, tw * 8);
+      gStale[page] &= (uint16_t)~(((1u << tw) - 1) << tx);
+      gBytesTotal += est;
+      ++gChunksSent;
+    }
+  }
+  gFlushPending = !allOk;
+}
+
+static void buildModel(UiModel &m) {
+  memset(&m, 0, sizeof(m));  // padding ikut nol → memcmp aman
+  m.scene  = gScene;
+  m.fault  = powerSpkProtectFault();
+  float v  = getVoltageInstant();
+  m.v10    = (int16_t)lroundf(v * 10.0f);
+  portENTER_CRITICAL(&gClockMux);
+  memcpy(m.clock, gClock, sizeof(m.clock));
+  portEXIT_CRITICAL(&gClockMux);
+  if (gScene == UiScene::RUN) {
+    m.bt     = gBtMode;
+    m.spkBig = gSpkBig;
+    float t  = getHeatsinkC();
+    m.t10    = isnan(t) ? INT16_MIN : (int16_t)lroundf(t * 10.0f);
+    uint8_t vu = 0; analyzerGetVu(vu);
+    m.vuW    = (uint8_t)map(vu, 0, 255, 0, 120);
+  }
+}
 
 // ================= SMALL HELPERS =================
 static inline void drawHeader(const char* title) {
@@ -56,20 +196,17 @@ static void drawStandbyScreen() {
 
   // Jam besar
   u8g2.setFont(u8g2_font_logisoso22_tf);
-  u8g2.drawStr(6, 45, gClock);
+  u8g2.drawStr(6, 45, gModel.clock);
 
   // Tegangan kecil di bawah
   char vbuf[16];
-  float v = getVoltageInstant();
-  snprintf(vbuf, sizeof(vbuf), "V: %.1f", v);
+  snprintf(vbuf, sizeof(vbuf), "V: %.1f", gModel.v10 / 10.0f);
   u8g2.setFont(u8g2_font_6x12_tf);
   u8g2.drawStr(0, 62, vbuf);
 
-  if (powerSpkProtectFault()) {
+  if (gModel.fault) {
     u8g2.drawStr(70, 62, "SPK PROTECT FAIL");
   }
-
-  u8g2.sendBuffer();
 }
 
 static void drawRunScreen() {
@@ -78,35 +215,30 @@ static void drawRunScreen() {
 
   // Baris status input/speaker
   u8g2.setFont(u8g2_font_6x12_tf);
-  u8g2.drawStr(0, 24, gBtMode ? "IN: BT" : "IN: AUX");
-  u8g2.drawStr(64,24, gSpkBig ? "SPK: BIG" : "SPK: SMALL");
+  u8g2.drawStr(0, 24, gModel.bt ? "IN: BT" : "IN: AUX");
+  u8g2.drawStr(64,24, gModel.spkBig ? "SPK: BIG" : "SPK: SMALL");
 
   // Tegangan & Suhu
   char vbuf[16], tbuf[16];
-  float v = getVoltageInstant();
-  float t = getHeatsinkC();
-  snprintf(vbuf, sizeof(vbuf), "V: %.1f", v);
-  if (isnan(t)) snprintf(tbuf, sizeof(tbuf), "T: --.-C");
-  else          snprintf(tbuf, sizeof(tbuf), "T: %.1fC", t);
+  snprintf(vbuf, sizeof(vbuf), "V: %.1f", gModel.v10 / 10.0f);
+  if (gModel.t10 == INT16_MIN) snprintf(tbuf, sizeof(tbuf), "T: --.-C");
+  else                         snprintf(tbuf, sizeof(tbuf), "T: %.1fC", gModel.t10 / 10.0f);
 
   u8g2.drawStr(0, 38, vbuf);
   u8g2.drawStr(64,38, tbuf);
 
   // VU meter (mono; tinggi 18 px, lebar 120 px)
-  uint8_t vu = 0; analyzerGetVu(vu);           // 0..255
-  int vuW = map(vu, 0, 255, 0, 120);
+  int vuW = gModel.vuW;
   int vuX = 4, vuY = 60, vuH = 12;
   u8g2.drawFrame(vuX, vuY - vuH, 120, vuH);    // frame
   if (vuW > 0) u8g2.drawBox(vuX+1, vuY - vuH + 1, vuW, vuH - 2);
 
   // Jam kecil di pojok kanan bawah
-  u8g2.drawStr(92, 62, gClock);
+  u8g2.drawStr(92, 62, gModel.clock);
 
-  if (powerSpkProtectFault()) {
+  if (gModel.fault) {
     u8g2.drawStr(0, 52, "SPK PROTECT FAIL");
   }
-
-  u8g2.sendBuffer();
 }
 
 static void drawSplash(const char* title) {
@@ -116,7 +248,7 @@ static void drawSplash(const char* title) {
   u8g2.drawHLine(0, 12, 128);
   u8g2.setFont(u8g2_font_7x13B_tf);
   u8g2.drawStr(10, 40, "Booting...");
-  u8g2.sendBuffer();
+  flushDirty(true);
 }
 
 static void drawBootLogLine(const char* label, bool ok) {
@@ -133,7 +265,7 @@ static void drawError(const char* msg) {
   drawHeader("ERROR");
   u8g2.setFont(u8g2_font_6x12_tf);
   u8g2.drawStr(0, 28, msg ? msg : "Unknown error");
-  u8g2.sendBuffer();
+  flushDirty(true);
 }
 
 static void drawWarning(const char* msg) {
@@ -141,15 +273,19 @@ static void drawWarning(const char* msg) {
   drawHeader("NOTICE");
   u8g2.setFont(u8g2_font_6x12_tf);
   u8g2.drawStr(0, 28, msg ? msg : "Notice");
-  u8g2.sendBuffer();
+  flushDirty(true);
 }
 
 // ================= PUBLIC API =================
 void uiInit() {
+  u8g2.setBusClock(I2C_OLED_CLOCK_HZ);
   u8g2.begin();
   u8g2.setPowerSave(0);
   gScene = powerIsOn() ? UiScene::RUN : UiScene::STANDBY;
-  lastDrawMs = 0;
+  gModelValid = false;
+  gFlushPending = false;
+  shadowInvalidate();
+  if (!sUiLock) sUiLock = xSemaphoreCreateMutex();
 }
 
 void uiShowBoot(uint32_t holdMs) {
@@ -161,23 +297,21 @@ void uiShowBoot(uint32_t holdMs) {
 }
 
 void uiShowFactoryReset(const char* subtitle, uint32_t holdMs) {
+  uiLock();
   gScene = UiScene::WARN;
   u8g2.clearBuffer();
   drawHeader("FACTORY RESET");
   u8g2.setFont(u8g2_font_6x12_tf);
   const char *line = (subtitle && subtitle[0]) ? subtitle : "Menghapus NVS...";
   u8g2.drawStr(0, 32, line);
-  u8g2.sendBuffer();
+  flushDirty(true);
+  uiUnlock();
   if (holdMs > 0) {
     delay(holdMs);
   }
 }
 
-void uiTick(uint32_t now) {
-  // 30 FPS max agar hemat
-  if (now - lastDrawMs < 33) return;
-  lastDrawMs = now;
-
+static void uiRender(uint32_t now) {
   // Transisi scene berdasar power state:
   if (powerIsStandby() && gScene != UiScene::STANDBY) {
     gScene = UiScene::STANDBY;
@@ -185,14 +319,63 @@ void uiTick(uint32_t now) {
     gScene = UiScene::RUN;
   }
 
-  switch (gScene) {
-    case UiScene::SPLASH:   /* keep */ break; // hanya by call eksplisit
-    case UiScene::BOOTLOG:  u8g2.sendBuffer(); break; // baris ditulis per event
-    case UiScene::STANDBY:  drawStandbyScreen(); break;
-    case UiScene::RUN:      drawRunScreen(); break;
-    case UiScene::ERROR:    /* static */ break;
-    case UiScene::WARN:     /* static */ break;
+  // Jendela 1 detik untuk byte/detik
+  if (now - gBytesWinMs >= 1000) {
+    gBytesPerSec   = gBytesTotal - gBytesWinStart;
+    gBytesWinStart = gBytesTotal;
+    gBytesWinMs    = now;
+  }
+
+  // OLED offline: lewati render sama sekali (degradasi); penjadwal I2C yang
+  // mem-probe ulang dengan backoff
+  bool online = i2cBusDevOnline(I2cDev::Oled);
+  if (!online) {
+    gOledWasOnline = false;
+    return;
+  }
+  if (!gOledWasOnline) {
+    gOledWasOnline = true;
+    i2cBusRun(I2cDev::Oled, oledInitJob, 0, 32);
+    gOledLost = true;
   }
+  if (gOledLost) {
+    gOledLost    = false;
+    gModelValid  = false;
+    shadowInvalidate();
+  }
+
+  // Scene statis (splash, boot log, error, warn) sudah dikirim saat dibuat
+  if (gScene != UiScene::STANDBY && gScene != UiScene::RUN) return;
+
+  UiModel m;
+  buildModel(m);
+  if (gModelValid && memcmp(&m, &gModel, sizeof(m)) == 0) {
+    // Buffer U8g2 masih berisi frame terakhir: kirim sisa tile yang gagal
+    if (gFlushPending) flushDirty(false);
+    else               ++gSkipped;
+    return;
+  }
+  gModel = m;
+  gModelValid = true;
+  ++gRedraws;
+
+  if (gScene == UiScene::STANDBY) drawStandbyScreen();
+  else                            drawRunScreen();
+  flushDirty(false);
+}
+
+void uiTick(uint32_t now) {
+  uiLock();
+  uiRender(now);
+  uiUnlock();
+}
+
+void uiGetStats(UiStats &out) {
+  out.bytesPerSec = gBytesPerSec;
+  out.bytesTotal  = gBytesTotal;
+  out.redraws     = gRedraws;
+  out.chunksSent  = gChunksSent;
+  out.skipped     = gSkipped;
 }
 
 void uiShowSplash(const char* title) {
@@ -207,7 +390,7 @@ void uiBootLogLine(const char* label, bool ok) {
     drawHeader("BOOT LOG");
   }
   drawBootLogLine(label, ok);
-  u8g2.sendBuffer();
+  flushDirty(true);
 }
 
 void uiShowError(const char* msg) {
@@ -222,13 +405,18 @@ void uiShowWarning(const char* msg) {
 
 void uiShowStandby() {
   gScene = UiScene::STANDBY;
+  buildModel(gModel);
+  gModelValid = true;
   drawStandbyScreen();
+  flushDirty(false);
 }
 
 void uiSetClock(const char* hhmmss) {
   if (!hhmmss) return;
+  portENTER_CRITICAL(&gClockMux);
   strncpy(gClock, hhmmss, sizeof(gClock)-1);
   gClock[sizeof(gClock)-1] = '\0';
+  portEXIT_CRITICAL(&gClockMux);
 }
 
 void uiSetInputStatus(bool btMode, bool speakerBig) {
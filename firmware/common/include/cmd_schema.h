@@ -0,0 +1,150 @@
+#pragma once
+/*
+  Jacktor Audio — cmd_schema.h
+  ----------------------------
+  Skema tunggal command UART amplifier. Dipakai bersama oleh:
+   - firmware/amplifier : tabel dispatch handleJsonLine() (lookup terurut)
+   - firmware/panel     : builder CLI → JSON dan teks help
+
+  Format baris X-macro:
+    X(ident, key, arg, min, max, cli, hint, help)
+      ident : akhiran nama handler di amplifier (handleCmd<ident>)
+      key   : nama field di {"type":"cmd","cmd":{...}}
+      arg   : tipe nilai (lihat CmdArg)
+      min/max: rentang numerik (Float/Uint); diabaikan tipe lain
+      cli   : frasa CLI panel (nullptr = hanya via JSON/raw)
+      hint  : argumen CLI (untuk Enum = daftar pilihan "a|b|c")
+      help  : deskripsi singkat untuk help panel
+
+  Catatan penting:
+  - Baris WAJIB terurut menurut key (strcmp) karena amplifier memakai binary
+    search; urutan diverifikasi static_assert di bawah.
+  - Tambah command baru cukup di sini + handler di amplifier.
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+enum class CmdArg : uint8_t {
+  Bool,   // true|false          (CLI: on|off|true|false|enable|disable)
+  Flag,   // wajib true           (CLI: tanpa argumen)
+  Float,  // angka, cek min..max
+  Uint,   // angka bulat >= 0, cek min..max
+  Enum,   // string, salah satu dari hint
+  Str,    // string bebas         (CLI: sisa baris)
+  Any     // divalidasi handler sendiri (objek OTA, buzz, dll.)
+};
+
+struct CmdSpec {
+  const char *key;
+  CmdArg      arg;
+  float       min;
+  float       max;
+  const char *cli;
+  const char *hint;
+  const char *help;
+};
+
+#define JACKTOR_CMD_SCHEMA(X)                                                                                          \
+  X(Bt,           "bt",            Bool,  0.0f,  0.0f,       "bt",                   "on|off",               "Enable/disable modul Bluetooth")   \
+  X(BtAutoOff,    "bt_autooff",    Uint,  0.0f,  3600000.0f, "bt autooff",           "<ms>",                 "Auto-off BT saat AUX (0=mati)")     \
+  X(Buzz,         "buzz",          Any,   0.0f,  0.0f,       nullptr,                "{f,d,ms}",             "Nada buzzer kustom")                \
+  X(DispatchStats, "cmd_stats",    Flag,  0.0f,  0.0f,       "stats cmd",            "",                     "Biaya dispatch per command")        \
+  X(Diag,         "diag",          Flag,  0.0f,  0.0f,       "diag",                 "",                     "Counter diagnostik link/loop")      \
+  X(FactoryReset, "factory_reset", Flag,  0.0f,  0.0f,       nullptr,                "",                     "Factory reset (hanya standby)")     \
+  X(FanCurve,     "fan_curve",     Any,   0.0f,  0.0f,       nullptr,                "[[t_c,duty],..]",      "Kurva kipas AUTO 2..8 titik")       \
+  X(FanDuty,      "fan_duty",      Uint,  0.0f,  1023.0f,    "fan duty",             "<0..1023>",            "Duty kipas mode custom")            \
+  X(FanMode,      "fan_mode",      Enum,  0.0f,  0.0f,       "fan mode",             "auto|custom|failsafe", "Mode kipas")                        \
+  X(FanPi,        "fan_pi",        Bool,  0.0f,  0.0f,       "fan pi",               "on|off",               "Koreksi PI kipas mode auto")        \
+  X(NvDigest,     "nv_digest",     Any,   0.0f,  0.0f,       nullptr,                "<etag>|true",          "Etag setting (stale bila beda)")    \
+  X(NvGet,        "nv_get",        Flag,  0.0f,  0.0f,       nullptr,                "",                     "Snapshot setting + etag")           \
+  X(NvSet,        "nv_set",        Any,   0.0f,  0.0f,       nullptr,                "{etag,key,value|values}", "Set setting (If-Match etag)")    \
+  X(NvsReset,     "nvs_reset",     Flag,  0.0f,  0.0f,       nullptr,                "",                     "Reset konfigurasi NVS")             \
+  X(OtaAbort,     "ota_abort",     Any,   0.0f,  0.0f,       nullptr,                "",                     "Batalkan OTA")                      \
+  X(OtaBegin,     "ota_begin",     Any,   0.0f,  0.0f,       nullptr,                "{size,crc32}",         "Mulai OTA")                         \
+  X(OtaEnd,       "ota_end",       Any,   0.0f,  0.0f,       nullptr,                "{reboot}",             "Akhiri OTA")                        \
+  X(OtaWrite,     "ota_write",     Any,   0.0f,  0.0f,       nullptr,                "{seq,data_b64}",       "Tulis chunk OTA")                   \
+  X(Perf,         "perf",          Enum,  0.0f,  0.0f,       "perf",                 "show|hist|reset",      "Profiler siklus CPU per seksi")     \
+  X(Power,        "power",         Bool,  0.0f,  0.0f,       "power",                "on|off",               "Relay utama ON/OFF")                \
+  X(RtcSet,       "rtc_set",       Str,   0.0f,  0.0f,       "rtc set",              "YYYY-MM-DDTHH:MM:SS",  "Sync RTC (ISO8601)")                \
+  X(RtcSetEpoch,  "rtc_set_epoch", Uint,  0.0f,  4294967295.0f, "rtc epoch",         "<epoch>",              "Sync RTC (epoch detik)")            \
+  X(Scope,        "scope",         Any,   0.0f,  0.0f,       nullptr,                "arm|trigger|abort|status|dump|{arm,trig_v,pre,n,auto}", "Capture tegangan SMPS 860 SPS") \
+  X(SmpsBypass,   "smps_bypass",   Bool,  0.0f,  0.0f,       "smps bypass",          "on|off",               "Bypass proteksi SMPS")              \
+  X(SmpsCut,      "smps_cut",      Float, 30.0f, 70.0f,      "smps cut",             "<V>",                  "Tegangan cut-off (< smps_rec)")     \
+  X(SmpsRec,      "smps_rec",      Float, 30.0f, 80.0f,      "smps rec",             "<V>",                  "Tegangan recovery (> smps_cut)")    \
+  X(SpkPwr,       "spk_pwr",       Bool,  0.0f,  0.0f,       "set speaker-power",    "on|off",               "Suplai speaker protector")          \
+  X(SpkSel,       "spk_sel",       Enum,  0.0f,  0.0f,       "set speaker-selector", "big|small",            "Pilih speaker")    \
+  X(LifeStats,    "stats",         Enum,  0.0f,  0.0f,       "stats life",           "show|reset",           "Statistik seumur hidup (jam ON, trip, histogram)") \
+  X(Subscribe,    "sub",           Any,   0.0f,  0.0f,       nullptr,                "{topic:hz}|false",     "Langganan telemetri per topik")     \
+  X(Trace,        "trace",         Enum,  0.0f,  0.0f,       "trace",                "dump|status|clear",    "Trace event biner (dump → trace_chunk)")
+
+#define JACKTOR_CMD_SPEC_ROW(ident, key, arg, mn, mx, cli, hint, help) \
+  {key, CmdArg::arg, mn, mx, cli, hint, help},
+
+inline constexpr CmdSpec CMD_SPECS[] = {
+  JACKTOR_CMD_SCHEMA(JACKTOR_CMD_SPEC_ROW)
+};
+
+inline constexpr int CMD_SPEC_COUNT = (int)(sizeof(CMD_SPECS) / sizeof(CMD_SPECS[0]));
+
+#undef JACKTOR_CMD_SPEC_ROW
+
+// Index enum sejajar CMD_SPECS (CmdId::Power == index "power")
+#define JACKTOR_CMD_ID_ROW(ident, key, arg, mn, mx, cli, hint, help) ident,
+enum class CmdId : uint8_t {
+  JACKTOR_CMD_SCHEMA(JACKTOR_CMD_ID_ROW)
+  Count
+};
+#undef JACKTOR_CMD_ID_ROW
+
+static_assert((int)CmdId::Count == CMD_SPEC_COUNT, "CmdId harus sejajar dengan CMD_SPECS");
+
+// -------- Helpers (constexpr agar urutan bisa dicek saat compile) --------
+constexpr int cmdSchemaStrcmp(const char *a, const char *b) {
+  while (*a && *a == *b) { ++a; ++b; }
+  return (int)(unsigned char)*a - (int)(unsigned char)*b;
+}
+
+constexpr bool cmdSchemaIsSorted() {
+  for (int i = 1; i < CMD_SPEC_COUNT; ++i) {
+    if (cmdSchemaStrcmp(CMD_SPECS[i - 1].key, CMD_SPECS[i].key) >= 0) return false;
+  }
+  return true;
+}
+
+static_assert(cmdSchemaIsSorted(), "JACKTOR_CMD_SCHEMA harus terurut menurut key");
+
+// Binary search key → index (−1 jika tidak dikenal)
+inline int cmdSchemaFind(const char *key) {
+  if (!key) return -1;
+  int lo = 0;
+  int hi = CMD_SPEC_COUNT - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    int c = strcmp(key, CMD_SPECS[mid].key);
+    if (c == 0) return mid;
+    if (c < 0) hi = mid - 1;
+    else       lo = mid + 1;
+  }
+  return -1;
+}
+
+// Cek apakah s (case-insensitive) ada di daftar "a|b|c"
+inline bool cmdSchemaEnumHas(const char *choices, const char *s) {
+  if (!choices || !s || !*s) return false;
+  const char *p = choices;
+  while (*p) {
+    const char *q = s;
+    while (*p && *p != '|' && *q) {
+      char a = *p, b = *q;
+      if (a >= 'A' && a <= 'Z') a = (char)(a - 'A' + 'a');
+      if (b >= 'A' && b <= 'Z') b = (char)(b - 'A' + 'a');
+      if (a != b) break;
+      ++p; ++q;
+    }
+    if (*q == '\0' && (*p == '|' || *p == '\0')) return true;
+    while (*p && *p != '|') ++p;
+    if (*p == '|') ++p;
+  }
+  return false;
+}
@@ -0,0 +1,107 @@
+#pragma once
+/*
+  Jacktor Audio — link_flow.h
+  ---------------------------
+  Flow control berbasis kredit untuk link UART amplifier ↔ panel. Dipakai
+  identik di kedua sisi.
+
+  Protokol:
+    {"type":"credit","rx":<total byte dibaca>,"win":<kapasitas buffer RX>}
+  - Tiap sisi menghitung total byte yang ditulis (txBytes) dan dibaca
+    (rxBytes), termasuk frame credit itu sendiri.
+  - Pengirim boleh menulis frame len byte bila
+      (txBytes - peerRx) + len <= peerWin
+    yaitu byte "in flight" tidak melebihi ruang buffer RX peer.
+  - Frame credit selalu boleh dikirim (tanpa kredit); karena itu peer
+    mengiklankan win = ukuran buffer − LINK_CREDIT_RESERVE.
+  - Flow control baru aktif setelah frame credit pertama diterima, jadi
+    firmware lawan versi lama tetap bekerja tanpa throttling.
+  - Kumulatif (bukan delta) → frame credit yang hilang diperbaiki frame
+    berikutnya. rx mundur = peer reboot → sinkron ulang. Byte hilang di
+    kabel → in-flight macet. Peer yang sibuk (mis. USB/OTG panel) tidak
+    membaca dan juga tidak mengirim credit, jadi macet saja bukan bukti
+    hilang; sinkron ulang hanya bila peer terus mengiklankan rx yang sama
+    (buffer RX-nya kosong) LINK_CREDIT_LOSS_REPEATS kali berturut selagi
+    in-flight > 0 → txBytes disamakan dengan peerRx (dihitung di resyncs).
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LINK_CREDIT_RESERVE           256     // byte cadangan untuk frame credit
+#define LINK_CREDIT_REFRESH_MS        1000    // iklan ulang periodik saat idle
+#define LINK_CREDIT_MIN_GAP_MS        20      // jarak minimum antar iklan
+#define LINK_CREDIT_LOSS_REPEATS      2       // credit rx sama berturut → byte hilang
+
+struct LinkFlow {
+  bool     enabled;       // true setelah credit pertama dari peer
+  uint32_t txBytes;       // total byte ditulis ke peer
+  uint32_t peerRx;        // total byte yang sudah dibaca peer
+  uint32_t peerWin;       // kapasitas RX peer (byte)
+  uint32_t rxBytes;       // total byte dibaca dari peer
+  uint32_t rxAdvertised;  // rxBytes saat credit terakhir dikirim
+  uint32_t lastAdvMs;
+  uint8_t  lossRepeats;   // credit berturut dengan rx sama selagi in-flight > 0
+  // Counter diagnostik
+  uint32_t stalls;        // frame yang harus ditahan karena kredit habis
+  uint32_t resyncs;       // sinkron ulang (peer reboot / byte hilang)
+  uint32_t credits;       // frame credit diterima
+};
+
+inline uint32_t linkFlowInflight(const LinkFlow &f) {
+  return f.txBytes - f.peerRx;
+}
+
+// Cek kredit untuk frame len byte (termasuk terminator). Tanpa timer: kredit
+// hanya kembali lewat frame credit peer (lihat linkFlowOnCredit).
+inline bool linkFlowCanSend(LinkFlow &f, size_t len, uint32_t now) {
+  (void)now;
+  if (!f.enabled) return true;
+  return linkFlowInflight(f) + (uint32_t)len <= f.peerWin;
+}
+
+inline void linkFlowOnSent(LinkFlow &f, size_t len) {
+  f.txBytes += (uint32_t)len;
+}
+
+inline void linkFlowOnRead(LinkFlow &f, size_t len) {
+  f.rxBytes += (uint32_t)len;
+}
+
+inline void linkFlowOnCredit(LinkFlow &f, uint32_t rx, uint32_t win) {
+  ++f.credits;
+  if (!f.enabled || (int32_t)(rx - f.peerRx) < 0 || (int32_t)(f.txBytes - rx) < 0) {
+    // Credit pertama, peer reboot, atau kita yang reboot → mulai dari rx
+    if (f.enabled) ++f.resyncs;
+    f.txBytes = rx;
+    f.lossRepeats = 0;
+  } else if (rx == f.peerRx && f.txBytes != rx) {
+    // Peer hidup dan sudah membaca semua yang sampai, tapi byte kita belum
+    // juga terhitung → hilang di kabel
+    if (++f.lossRepeats >= LINK_CREDIT_LOSS_REPEATS) {
+      f.txBytes = rx;
+      f.lossRepeats = 0;
+      ++f.resyncs;
+    }
+  } else {
+    f.lossRepeats = 0;
+  }
+  f.enabled = true;
+  f.peerRx  = rx;
+  f.peerWin = win;
+}
+
+// Perlu kirim credit? Saat peer sudah memakai ≥ ¼ window sejak iklan
+// terakhir, atau refresh periodik.
+inline bool linkFlowShouldAdvertise(const LinkFlow &f, uint32_t win, uint32_t now) {
+  uint32_t since = now - f.lastAdvMs;
+  if (since < LINK_CREDIT_MIN_GAP_MS) return false;
+  if (f.rxBytes - f.rxAdvertised >= win / 4) return true;
+  if (f.rxBytes != f.rxAdvertised && since >= 100) return true;
+  return since >= LINK_CREDIT_REFRESH_MS;
+}
+
+inline void linkFlowMarkAdvertised(LinkFlow &f, uint32_t now) {
+  f.rxAdvertised = f.rxBytes;
+  f.lastAdvMs = now;
+}
@@ -48,6 +48,17 @@ static const size_t   OTG_BACKOFF_LEN          = 6;
 #define HOST_SERIAL_BAUD            921600
 #define AMP_SERIAL_BAUD             921600
 #define BRIDGE_MAX_FRAME            512
+#define AMP_MAX_FRAME               4096      // frame dari amplifier (telemetri penuh > 512 byte)
+#define AMP_RX_BUFFER_BYTES         8192      // buffer RX Serial2, diiklankan ke amplifier via credit
+#define AMP_TX_QUEUE_MAX            8         // frame ke amplifier yang ditahan saat kredit habis
+
+// --- Pipelining command amplifier (request id)
+#define AMP_INFLIGHT_MAX            8         // request ber-id yang boleh menunggu balasan
+#define AMP_REQ_TIMEOUT_MS          1500      // tanpa balasan → ack timeout ke host
+#define AMP_PANEL_REQ_ID_BASE       0x80000000UL  // id buatan CLI panel (host pakai < base)
+
+// --- Sinkron setting amplifier (etag)
+#define AMP_NV_REFETCH_MS           1000      // jarak minimum nv_get otomatis saat nv_etag berubah
 
 // --- Handshake JSON
 // UI host (desktop/android) wajib kirim {"type":"hello","who":"android|desktop","app_ver":"x.y.z","schema_ver":"1.1"}
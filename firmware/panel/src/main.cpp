@@ -5,6 +5,8 @@
 
 #include "config.h"
 #include "ota_panel.h"
+#include "cmd_schema.h"
+#include "link_flow.h"
 
 enum OtgState { IDLE, PROBE, WAIT_VBUS, WAIT_HANDSHAKE, HOST_ACTIVE, BACKOFF, COOLDOWN };
 enum LedPattern { LED_PATTERN_OFF, LED_PATTERN_SOLID, LED_PATTERN_BLINK_SLOW, LED_PATTERN_BLINK_FAST };
@@ -41,7 +43,10 @@ static uint32_t lastHelloMs = 0;
 
 static String hostRxBuffer;
 static String ampRxBuffer;
+static bool ampRxOverflow = false;
 static String lastAmpTelemetry;
+static String ampNvEtag;            // etag milik nvs{} di lastAmpTelemetry
+static uint32_t ampNvFetchMs = 0;
 
 static LedChannel redLed   = {LED_PATTERN_SOLID, true, 0, false};
 static LedChannel greenLed = {LED_PATTERN_OFF, false, 0, false};
@@ -51,6 +56,23 @@ static bool ampOtaActive = false;
 static uint32_t panelOtaCliSeq = 0;
 static uint32_t ampOtaCliSeq = 0;
 
+// Request amplifier ber-id yang menunggu balasan (ack/ota/log dengan id sama)
+struct PendingReq {
+  bool     used;
+  uint32_t id;
+  uint32_t sentMs;
+  char     cmd[20];
+};
+static PendingReq ampInflight[AMP_INFLIGHT_MAX];
+static uint32_t nextPanelReqId = AMP_PANEL_REQ_ID_BASE;
+
+// Flow control kredit ke/dari amplifier (lihat link_flow.h)
+static LinkFlow ampFlow = {};
+static String ampTxQueue[AMP_TX_QUEUE_MAX];
+static size_t ampTxqHead = 0;
+static size_t ampTxqCount = 0;
+static uint32_t ampTxqDrops = 0;
+
 static const char *stateName(OtgState state) {
   switch (state) {
     case IDLE: return "IDLE";
@@ -568,9 +590,118 @@ static void handlePanelOtaAbort() {
   sendAck(true, "panel_ota_abort");
 }
 
-static void sendJsonToAmp(const String &payload) {
+static void writeAmpLine(const String &payload) {
   Serial2.print(payload);
   Serial2.print('\n');
+  linkFlowOnSent(ampFlow, payload.length() + 1);
+}
+
+// Kirim bila kredit cukup; bila tidak, tahan di antrean (urutan dijaga).
+// Return false bila antrean penuh (frame tidak dikirim).
+static bool sendJsonToAmp(const String &payload) {
+  if (ampTxqCount == 0 && linkFlowCanSend(ampFlow, payload.length() + 1, millis())) {
+    writeAmpLine(payload);
+    return true;
+  }
+  if (ampTxqCount >= AMP_TX_QUEUE_MAX) {
+    ampTxqDrops++;
+    return false;
+  }
+  ampFlow.stalls++;
+  ampTxQueue[(ampTxqHead + ampTxqCount) % AMP_TX_QUEUE_MAX] = payload;
+  ampTxqCount++;
+  return true;
+}
+
+static void flushAmpTxQueue(uint32_t now) {
+  while (ampTxqCount > 0) {
+    String &out = ampTxQueue[ampTxqHead];
+    if (!linkFlowCanSend(ampFlow, out.length() + 1, now)) {
+      return;
+    }
+    writeAmpLine(out);
+    out = String();
+    ampTxqHead = (ampTxqHead + 1) % AMP_TX_QUEUE_MAX;
+    ampTxqCount--;
+  }
+}
+
+static void advertiseAmpCredit(uint32_t now) {
+  const uint32_t win = AMP_RX_BUFFER_BYTES - LINK_CREDIT_RESERVE;
+  if (!linkFlowShouldAdvertise(ampFlow, win, now)) {
+    return;
+  }
+  char buf[72];
+  snprintf(buf, sizeof(buf), "{\"type\":\"credit\",\"rx\":%lu,\"win\":%lu}",
+           static_cast<unsigned long>(ampFlow.rxBytes), static_cast<unsigned long>(win));
+  linkFlowMarkAdvertised(ampFlow, now);
+  writeAmpLine(String(buf));
+}
+
+// -------- In-flight request amplifier --------
+static size_t inflightCount() {
+  size_t n = 0;
+  for (const PendingReq &r : ampInflight) {
+    if (r.used) {
+      n++;
+    }
+  }
+  return n;
+}
+
+static bool inflightAdd(uint32_t id, const char *cmd, uint32_t now) {
+  PendingReq *slot = nullptr;
+  for (PendingReq &r : ampInflight) {
+    if (r.used && r.id == id) {
+      slot = &r;  // id dipakai ulang → perbarui entri lama
+      break;
+    }
+    if (!r.used && !slot) {
+      slot = &r;
+    }
+  }
+  if (!slot) {
+    return false;
+  }
+  slot->used = true;
+  slot->id = id;
+  slot->sentMs = now;
+  strlcpy(slot->cmd, cmd ? cmd : "cmd", sizeof(slot->cmd));
+  return true;
+}
+
+static void inflightResolve(uint32_t id) {
+  for (PendingReq &r : ampInflight) {
+    if (r.used && r.id == id) {
+      r.used = false;
+      return;
+    }
+  }
+}
+
+static void sendReqAck(bool ok, const char *cmd, uint32_t id, const char *error) {
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"] = "ack";
+  root["ok"] = ok;
+  root["id"] = id;
+  if (cmd && *cmd) {
+    root["cmd"] = cmd;
+  }
+  if (!ok && error) {
+    root["error"] = error;
+  }
+  serializeJson(doc, Serial);
+  Serial.println();
+}
+
+static void inflightTick(uint32_t now) {
+  for (PendingReq &r : ampInflight) {
+    if (r.used && now - r.sentMs >= AMP_REQ_TIMEOUT_MS) {
+      r.used = false;
+      sendReqAck(false, r.cmd, r.id, "timeout");
+    }
+  }
 }
 
 static bool beginAmpCmd(JsonDocument &doc, JsonObject &cmd, const char *ackCmd, bool allowDuringAmpOta = false) {
@@ -581,13 +712,26 @@ static bool beginAmpCmd(JsonDocument &doc, JsonObject &cmd, const char *ackCmd,
     sendAck(false, ackCmd, "amp_ota_active");
     return false;
   }
+  if (inflightCount() >= AMP_INFLIGHT_MAX) {
+    sendAck(false, ackCmd, "busy");
+    return false;
+  }
   JsonObject root = doc.to<JsonObject>();
   root["type"] = "cmd";
+  root["id"] = nextPanelReqId;
+  nextPanelReqId = (nextPanelReqId == 0xFFFFFFFFUL) ? AMP_PANEL_REQ_ID_BASE : nextPanelReqId + 1;
   cmd = root["cmd"].to<JsonObject>();
   return true;
 }
 
 static void transmitAmpCmd(JsonDocument &doc) {
+  JsonObjectConst cmd = doc["cmd"].as<JsonObjectConst>();
+  const char *first = "cmd";
+  for (JsonPairConst kv : cmd) {
+    first = kv.key().c_str();
+    break;
+  }
+  inflightAdd(doc["id"] | 0UL, first, millis());
   String out;
   serializeJson(doc, out);
   sendJsonToAmp(out);
@@ -759,6 +903,27 @@ static void sendPanelShowPanel() {
   sendPanelAckDoc(doc);
 }
 
+static void sendPanelShowLink() {
+  JsonDocument doc;
+  JsonObject root = doc.to<JsonObject>();
+  root["type"] = "ack";
+  root["ok"] = true;
+  root["cmd"] = "panel_show_link";
+  JsonObject data = root["data"].to<JsonObject>();
+  data["fc_enabled"] = ampFlow.enabled;
+  data["inflight"] = linkFlowInflight(ampFlow);
+  data["amp_win"] = ampFlow.peerWin;
+  data["tx_bytes"] = ampFlow.txBytes;
+  data["rx_bytes"] = ampFlow.rxBytes;
+  data["stalls"] = ampFlow.stalls;
+  data["resyncs"] = ampFlow.resyncs;
+  data["credits"] = ampFlow.credits;
+  data["txq"] = static_cast<uint32_t>(ampTxqCount);
+  data["txq_drops"] = ampTxqDrops;
+  data["req_inflight"] = static_cast<uint32_t>(inflightCount());
+  sendPanelAckDoc(doc);
+}
+
 static void sendPanelShowVersion() {
   JsonDocument doc;
   doc.reserve(256);
@@ -1018,6 +1183,10 @@ static void handlePanelCli(const std::vector<String> &tokens) {
       sendPanelOtgStatusAck("panel_show_otg");
       return;
     }
+    if (subject == "link") {
+      sendPanelShowLink();
+      return;
+    }
     sendAck(false, "panel_show", "unknown");
     return;
   }
@@ -1048,11 +1217,168 @@ static void handleAmpRaw(const String &payload) {
       }
     }
   }
-  sendJsonToAmp(trimmed);
+  if (!sendJsonToAmp(trimmed)) {
+    sendAck(false, "raw", "link_busy");
+    return;
+  }
   sendAck(true, "raw");
 }
 
-static void handleAmpCli(const std::vector<String> &tokens, const String &rawLine) {
+// -------- CLI amplifier dari skema (cmd_schema.h) --------
+// Cari frasa CLI terpanjang yang cocok dengan token awal; argIndex = index
+// token pertama setelah frasa.
+static int findCliSpec(const std::vector<String> &tokens, size_t &argIndex) {
+  int best = -1;
+  size_t bestWords = 0;
+  for (int i = 0; i < CMD_SPEC_COUNT; ++i) {
+    const char *p = CMD_SPECS[i].cli;
+    if (!p) {
+      continue;
+    }
+    size_t words = 0;
+    bool match = true;
+    while (*p) {
+      const char *sp = strchr(p, ' ');
+      size_t len = sp ? static_cast<size_t>(sp - p) : strlen(p);
+      if (words >= tokens.size() || tokens[words].length() != len ||
+          strncmp(tokens[words].c_str(), p, len) != 0) {
+        match = false;
+        break;
+      }
+      ++words;
+      p += len;
+      if (*p == ' ') {
+        ++p;
+      }
+    }
+    if (match && words > bestWords) {
+      best = i;
+      bestWords = words;
+    }
+  }
+  argIndex = bestWords;
+  return best;
+}
+
+static bool parseCliBool(const String &token, bool &out) {
+  if (token == "on" || token == "true" || token == "enable" || token == "1") {
+    out = true;
+    return true;
+  }
+  if (token == "off" || token == "false" || token == "disable" || token == "0") {
+    out = false;
+    return true;
+  }
+  return false;
+}
+
+static void handleSchemaCli(const CmdSpec &spec, const std::vector<String> &tokens, size_t argIndex) {
+  bool hasArg = argIndex < tokens.size();
+  if (spec.arg != CmdArg::Flag && !hasArg) {
+    sendAck(false, spec.key, "invalid");
+    return;
+  }
+  JsonDocument doc;
+  JsonObject cmdObj;
+  if (!beginAmpCmd(doc, cmdObj, spec.key)) {
+    return;
+  }
+  switch (spec.arg) {
+    case CmdArg::Flag:
+      cmdObj[spec.key] = true;
+      break;
+    case CmdArg::Bool: {
+      bool on = false;
+      if (!parseCliBool(tokens[argIndex], on)) {
+        sendAck(false, spec.key, "invalid_value");
+        return;
+      }
+      cmdObj[spec.key] = on;
+      break;
+    }
+    case CmdArg::Float: {
+      float value = 0.0f;
+      if (!parseFloat(tokens[argIndex], value)) {
+        sendAck(false, spec.key, "invalid_value");
+        return;
+      }
+      if (value < spec.min || value > spec.max) {
+        sendAck(false, spec.key, "range");
+        return;
+      }
+      cmdObj[spec.key] = value;
+      break;
+    }
+    case CmdArg::Uint: {
+      uint32_t value = 0;
+      if (!parseUint32(tokens[argIndex], value)) {
+        sendAck(false, spec.key, "invalid_value");
+        return;
+      }
+      if (static_cast<double>(value) < spec.min || static_cast<double>(value) > spec.max) {
+        sendAck(false, spec.key, "range");
+        return;
+      }
+      cmdObj[spec.key] = value;
+      break;
+    }
+    case CmdArg::Enum: {
+      String value = tokens[argIndex];
+      value.toLowerCase();
+      if (!cmdSchemaEnumHas(spec.hint, value.c_str())) {
+        sendAck(false, spec.key, "invalid_value");
+        return;
+      }
+      cmdObj[spec.key] = value;
+      break;
+    }
+    case CmdArg::Str: {
+      String value = tokens[argIndex];
+      for (size_t i = argIndex + 1; i < tokens.size(); ++i) {
+        value += ' ';
+        value += tokens[i];
+      }
+      cmdObj[spec.key] = value;
+      break;
+    }
+    case CmdArg::Any:
+    default:
+      sendAck(false, spec.key, "json_only");
+      return;
+  }
+  transmitAmpCmd(doc);
+  sendAck(true, spec.key);
+}
+
+static void printSchemaHelpLine(const CmdSpec &spec) {
+  String usage = spec.cli;
+  if (spec.hint && *spec.hint) {
+    usage += ' ';
+    usage += spec.hint;
+  }
+  Serial.printf("  %-32s- %s\n", usage.c_str(), spec.help);
+}
+
+// Cetak semua command skema yang kata pertamanya = topic (nullptr = semua)
+static bool printSchemaHelp(const char *topic) {
+  bool any = false;
+  size_t topicLen = topic ? strlen(topic) : 0;
+  for (int i = 0; i < CMD_SPEC_COUNT; ++i) {
+    const CmdSpec &spec = CMD_SPECS[i];
+    if (!spec.cli) {
+      continue;
+    }
+    if (topic && (strncmp(spec.cli, topic, topicLen) != 0 ||
+                  (spec.cli[topicLen] != ' ' && spec.cli[topicLen] != '\0'))) {
+      continue;
+    }
+    printSchemaHelpLine(spec);
+    any = true;
+  }
+  return any;
+}
+
+static void handleAmpCli(const std::vector<String> &tokens) {
   if (tokens.empty()) {
     return;
   }
@@ -1116,212 +1442,96 @@ static void handleAmpCli(const std::vector<String> &tokens, const String &rawLin
     return;
   }
 
-  if (cmd == "set") {
-    if (tokens.size() < 3) {
-      sendAck(false, "set", "invalid");
-      return;
-    }
-    const String &target = tokens[1];
-    if (target == "speaker-selector") {
-      if (tokens.size() < 3) {
-        sendAck(false, "set_speaker_selector", "invalid");
-        return;
-      }
-      const String &value = tokens[2];
-      if (value != "big" && value != "small") {
-        sendAck(false, "set_speaker_selector", "invalid_value");
-        return;
-      }
-      JsonDocument doc;
-      JsonObject cmdObj;
-      if (!beginAmpCmd(doc, cmdObj, "set_speaker_selector")) {
+  // Sintaks lama "fan auto|custom|failsafe [duty N]" → satu cmd berisi
+  // fan_mode (+ fan_duty). Bentuk baru "fan mode"/"fan duty" lewat skema.
+  if (cmd == "fan" && tokens.size() >= 2 && cmdSchemaEnumHas(CMD_SPECS[cmdSchemaFind("fan_mode")].hint, tokens[1].c_str())) {
+    const String &mode = tokens[1];
+    bool hasDuty = false;
+    uint32_t duty = 0;
+    if (mode == "custom" && tokens.size() >= 4 && tokens[2] == "duty") {
+      if (!parseUint32(tokens[3], duty) || duty > 1023) {
+        sendAck(false, "fan", "duty_range");
         return;
       }
-      cmdObj["spk_sel"] = value;
-      transmitAmpCmd(doc);
-      sendAck(true, "set_speaker_selector");
-      return;
+      hasDuty = true;
     }
-    if (target == "speaker-power") {
-      if (tokens.size() < 3) {
-        sendAck(false, "set_speaker_power", "invalid");
-        return;
-      }
-      const String &value = tokens[2];
-      bool on;
-      if (value == "on") {
-        on = true;
-      } else if (value == "off") {
-        on = false;
-      } else {
-        sendAck(false, "set_speaker_power", "invalid_value");
-        return;
-      }
-      JsonDocument doc;
-      JsonObject cmdObj;
-      if (!beginAmpCmd(doc, cmdObj, "set_speaker_power")) {
-        return;
-      }
-      cmdObj["spk_pwr"] = on;
-      transmitAmpCmd(doc);
-      sendAck(true, "set_speaker_power");
+    JsonDocument doc;
+    JsonObject cmdObj;
+    if (!beginAmpCmd(doc, cmdObj, "fan")) {
       return;
     }
-    sendAck(false, "set", "unknown_target");
+    cmdObj["fan_mode"] = mode;
+    if (hasDuty) {
+      cmdObj["fan_duty"] = duty;
+    }
+    transmitAmpCmd(doc);
+    sendAck(true, "fan");
     return;
   }
 
-  if (cmd == "bt") {
-    if (tokens.size() < 2) {
-      sendAck(false, "bt", "invalid");
-      return;
-    }
-    const String &state = tokens[1];
-    bool enable;
-    if (state == "on") {
-      enable = true;
-    } else if (state == "off") {
-      enable = false;
-    } else {
-      sendAck(false, "bt", "invalid_state");
+  // Sintaks lama "rtc set epoch:<int>"
+  if (cmd == "rtc" && tokens.size() >= 3 && tokens[1] == "set" && tokens[2].startsWith("epoch:")) {
+    String epochStr = tokens[2].substring(6);
+    uint32_t epoch = 0;
+    if (!parseUint32(epochStr, epoch)) {
+      sendAck(false, "rtc_set_epoch", "invalid_epoch");
       return;
     }
     JsonDocument doc;
     JsonObject cmdObj;
-    if (!beginAmpCmd(doc, cmdObj, "bt")) {
+    if (!beginAmpCmd(doc, cmdObj, "rtc_set_epoch")) {
       return;
     }
-    cmdObj["bt"] = enable;
+    cmdObj["rtc_set_epoch"] = epoch;
     transmitAmpCmd(doc);
-    sendAck(true, "bt");
+    sendAck(true, "rtc_set_epoch");
     return;
   }
 
-  if (cmd == "fan") {
-    if (tokens.size() < 2) {
-      sendAck(false, "fan", "invalid");
+  // "show perf [hist|reset]" → {"perf":"show|hist|reset"} (profiler amplifier)
+  if (cmd == "show" && tokens.size() >= 2 && tokens[1] == "perf") {
+    String act = tokens.size() >= 3 ? tokens[2] : String("show");
+    act.toLowerCase();
+    if (!cmdSchemaEnumHas(CMD_SPECS[cmdSchemaFind("perf")].hint, act.c_str())) {
+      sendAck(false, "perf", "invalid_value");
       return;
     }
-    const String &mode = tokens[1];
-    if (mode == "auto" || mode == "failsafe" || mode == "custom") {
-      bool hasDuty = false;
-      uint32_t duty = 0;
-      if (mode == "custom" && tokens.size() >= 4 && tokens[2] == "duty") {
-        if (!parseUint32(tokens[3], duty) || duty > 1023) {
-          sendAck(false, "fan", "duty_range");
-          return;
-        }
-        hasDuty = true;
-      }
-      JsonDocument doc;
-      JsonObject cmdObj;
-      if (!beginAmpCmd(doc, cmdObj, "fan")) {
-        return;
-      }
-      cmdObj["fan_mode"] = mode;
-      transmitAmpCmd(doc);
-      if (mode == "custom" && hasDuty) {
-        JsonDocument docDuty;
-        JsonObject cmdDuty;
-        if (!beginAmpCmd(docDuty, cmdDuty, "fan")) {
-          return;
-        }
-        cmdDuty["fan_duty"] = duty;
-        transmitAmpCmd(docDuty);
-      }
-      sendAck(true, "fan");
+    JsonDocument doc;
+    JsonObject cmdObj;
+    if (!beginAmpCmd(doc, cmdObj, "perf")) {
       return;
     }
-    sendAck(false, "fan", "invalid_mode");
+    cmdObj["perf"] = act;
+    transmitAmpCmd(doc);
+    sendAck(true, "perf");
     return;
   }
 
-  if (cmd == "smps") {
-    if (tokens.size() < 3) {
-      sendAck(false, "smps", "invalid");
-      return;
-    }
-    const String &action = tokens[1];
-    if (action == "cut" || action == "rec") {
-      float value = 0.0f;
-      if (!parseFloat(tokens[2], value)) {
-        sendAck(false, action == "cut" ? "smps_cut" : "smps_rec", "invalid_value");
-        return;
-      }
-      const char *ackCmd = action == "cut" ? "smps_cut" : "smps_rec";
-      JsonDocument doc;
-      JsonObject cmdObj;
-      if (!beginAmpCmd(doc, cmdObj, ackCmd)) {
-        return;
-      }
-      cmdObj[action == "cut" ? "smps_cut" : "smps_rec"] = value;
-      transmitAmpCmd(doc);
-      sendAck(true, ackCmd);
+  // Sinkron setting: "nv_digest? [etag]" dan "nv_get" (nv_set lihat handleNvSetCli)
+  if (cmd == "nv_digest?" || cmd == "nv_digest") {
+    JsonDocument doc;
+    JsonObject cmdObj;
+    if (!beginAmpCmd(doc, cmdObj, "nv_digest")) {
       return;
     }
-    if (action == "bypass") {
-      const String &value = tokens[2];
-      bool bypass;
-      if (value == "on") {
-        bypass = true;
-      } else if (value == "off") {
-        bypass = false;
-      } else {
-        sendAck(false, "smps_bypass", "invalid_value");
-        return;
-      }
-      JsonDocument doc;
-      JsonObject cmdObj;
-      if (!beginAmpCmd(doc, cmdObj, "smps_bypass")) {
-        return;
-      }
-      cmdObj["smps_bypass"] = bypass;
-      transmitAmpCmd(doc);
-      sendAck(true, "smps_bypass");
-      return;
+    if (tokens.size() >= 2) {
+      cmdObj["nv_digest"] = tokens[1];
+    } else {
+      cmdObj["nv_digest"] = true;
     }
-    sendAck(false, "smps", "unknown_cmd");
+    transmitAmpCmd(doc);
+    sendAck(true, "nv_digest");
     return;
   }
-
-  if (cmd == "rtc") {
-    if (tokens.size() < 3 || tokens[1] != "set") {
-      sendAck(false, "rtc", "invalid");
-      return;
-    }
-    int idx = rawLine.indexOf("set");
-    String value = idx >= 0 ? rawLine.substring(idx + 3) : tokens[2];
-    value.trim();
-    if (value.startsWith("epoch:")) {
-      String epochStr = value.substring(6);
-      epochStr.trim();
-      uint32_t epoch = 0;
-      if (!parseUint32(epochStr, epoch)) {
-        sendAck(false, "rtc_set_epoch", "invalid_epoch");
-        return;
-      }
-      JsonDocument doc;
-      JsonObject cmdObj;
-      if (!beginAmpCmd(doc, cmdObj, "rtc_set_epoch")) {
-        return;
-      }
-      cmdObj["rtc_set_epoch"] = epoch;
-      transmitAmpCmd(doc);
-      sendAck(true, "rtc_set_epoch");
-      return;
-    }
-    if (value.isEmpty()) {
-      sendAck(false, "rtc_set", "invalid");
-      return;
-    }
+  if (cmd == "nv_get") {
     JsonDocument doc;
     JsonObject cmdObj;
-    if (!beginAmpCmd(doc, cmdObj, "rtc_set")) {
+    if (!beginAmpCmd(doc, cmdObj, "nv_get")) {
       return;
     }
-    cmdObj["rtc_set"] = value;
+    cmdObj["nv_get"] = true;
     transmitAmpCmd(doc);
-    sendAck(true, "rtc_set");
+    sendAck(true, "nv_get");
     return;
   }
 
@@ -1351,9 +1561,34 @@ static void handleAmpCli(const std::vector<String> &tokens, const String &rawLin
     return;
   }
 
+  size_t argIndex = 0;
+  int specIdx = findCliSpec(tokens, argIndex);
+  if (specIdx >= 0) {
+    handleSchemaCli(CMD_SPECS[specIdx], tokens, argIndex);
+    return;
+  }
+
   sendAck(false, cmd.c_str(), "unknown_cmd");
 }
 
+// "nv_set {json}" → {"nv_set":{...}}; JSON bisa berisi spasi sehingga
+// diproses sebelum tokenize.
+static void handleNvSetCli(const String &payload) {
+  JsonDocument req;
+  if (deserializeJson(req, payload) != DeserializationError::Ok || !req.is<JsonObject>()) {
+    sendAck(false, "nv_set", "invalid");
+    return;
+  }
+  JsonDocument doc;
+  JsonObject cmdObj;
+  if (!beginAmpCmd(doc, cmdObj, "nv_set")) {
+    return;
+  }
+  cmdObj["nv_set"].set(req.as<JsonObjectConst>());
+  transmitAmpCmd(doc);
+  sendAck(true, "nv_set");
+}
+
 static void handlePanelJson(const JsonDocument &doc) {
   JsonObjectConst rootCmd = doc["cmd"].as<JsonObjectConst>();
   if (rootCmd.isNull()) {
@@ -1400,23 +1635,58 @@ static void trackAmpOtaFromJson(const JsonDocument &doc) {
   }
 }
 
+// Antrean TX ke amplifier penuh: batalkan request ber-id & kabari host
+static void rejectAmpBusy(const JsonDocument &doc) {
+  if (doc["id"].is<uint32_t>()) {
+    uint32_t id = doc["id"].as<uint32_t>();
+    inflightResolve(id);
+    sendReqAck(false, "cmd", id, "link_busy");
+  } else {
+    sendAck(false, "cmd", "link_busy");
+  }
+}
+
 static void forwardCmdJsonToAmp(const String &line, const JsonDocument &doc) {
   if (panelOtaIsActive()) {
     sendAck(false, "cmd", "panel_ota_active");
     return;
   }
   JsonObjectConst cmd = doc["cmd"].as<JsonObjectConst>();
-  if (cmd.isNull()) {
+  bool isBatch = cmd.isNull() && doc["batch"].is<JsonArrayConst>();
+  if (cmd.isNull() && !isBatch) {
     sendAck(false, "cmd", "invalid");
     return;
   }
+  // Request ber-id dicatat agar host bisa pipelining; balasan amplifier
+  // membawa id yang sama, tanpa balasan → ack "timeout" dari panel.
+  if (doc["id"].is<uint32_t>()) {
+    uint32_t id = doc["id"].as<uint32_t>();
+    const char *first = "batch";
+    for (JsonPairConst kv : cmd) {
+      first = kv.key().c_str();
+      break;
+    }
+    if (!inflightAdd(id, first, millis())) {
+      sendReqAck(false, first, id, "busy");
+      return;
+    }
+  }
+  if (isBatch) {
+    // Batch preset: {"type":"cmd","batch":[{...},{...}]} diteruskan apa adanya
+    if (!sendJsonToAmp(line)) {
+      rejectAmpBusy(doc);
+    }
+    return;
+  }
   if (cmd["ota_begin"].is<JsonObject>()) {
     ampOtaActive = true;
     ampOtaCliSeq = 0;
   } else if (cmd["ota_end"].is<JsonObject>() || cmd["ota_abort"].is<bool>()) {
     ampOtaActive = false;
   }
-  sendJsonToAmp(line);
+  if (!sendJsonToAmp(line)) {
+    rejectAmpBusy(doc);
+  }
 }
 
 static void handleHostJsonLine(const String &line, uint32_t now) {
@@ -1481,6 +1751,10 @@ static void handleHostCliLine(const String &line) {
     handleAmpRaw(payload);
     return;
   }
+  if (trimmed.startsWith("nv_set ")) {
+    handleNvSetCli(trimmed.substring(7));
+    return;
+  }
   std::vector<String> tokens = tokenize(trimmed);
   if (tokens.empty()) {
     return;
@@ -1488,7 +1762,7 @@ static void handleHostCliLine(const String &line) {
   if (tokens[0] == "panel") {
     handlePanelCli(tokens);
   } else {
-    handleAmpCli(tokens, trimmed);
+    handleAmpCli(tokens);
   }
 }
 
@@ -1502,21 +1776,21 @@ static void printHelp() {
   Serial.println(F("  panel power-wake                - Pulse Android power button"));
   Serial.println(F("  panel led r|g on|off|auto       - Override LED outputs"));
   Serial.println(F("  panel ota begin/write/end/abort - OTA update panel firmware"));
-  Serial.println(F("  show telemetry|panel|nvs|version|time|otg|errors"));
+  Serial.println(F("  show telemetry|panel|nvs|version|time|otg|errors|link"));
   Serial.println(F("  reset nvs --force               - Reset panel configuration"));
   Serial.println();
   Serial.println(F("Forwarded to amplifier (panel builds JSON):"));
-  Serial.println(F("  set speaker-selector big|small"));
-  Serial.println(F("  set speaker-power on|off"));
-  Serial.println(F("  bt on|off"));
+  printSchemaHelp(nullptr);
   Serial.println(F("  fan auto|custom|failsafe [duty <0..1023>]"));
-  Serial.println(F("  smps cut <V>|rec <V>|bypass on|off"));
-  Serial.println(F("  rtc set YYYY-MM-DDTHH:MM:SS | epoch:<int>"));
+  Serial.println(F("  rtc set epoch:<int>"));
+  Serial.println(F("  show perf [hist|reset]          - Profiler siklus CPU amplifier"));
   Serial.println(F("  reset nvs --force"));
+  Serial.println(F("  nv_digest? [etag] | nv_get      - Etag / snapshot setting amplifier"));
+  Serial.println(F("  nv_set {etag,key,value|values}  - Set setting (If-Match etag)"));
   Serial.println(F("  ota begin/write/end/abort       - OTA amplifier firmware"));
   Serial.println(F("  raw {json}                      - Send raw JSON to amplifier"));
   Serial.println(F("-------------------------------------"));
-  Serial.println(F("Topics: panel, otg, ota, amp, fan, smps, rtc, reset, raw"));
+  Serial.println(F("Topics: panel, otg, ota, amp, power, bt, fan, smps, rtc, set, stats, reset, raw"));
 }
 
 static void printHelpTopic(const String &topic) {
@@ -1545,29 +1819,18 @@ static void printHelpTopic(const String &topic) {
   }
   if (topic == "amp") {
     Serial.println(F("[help amp] Amplifier control shortcuts"));
-    Serial.println(F("  set speaker-selector big|small"));
-    Serial.println(F("  set speaker-power on|off"));
-    Serial.println(F("  bt on|off"));
-    Serial.println(F("  fan auto|custom|failsafe [duty]"));
+    printSchemaHelp(nullptr);
     return;
   }
   if (topic == "fan") {
     Serial.println(F("[help fan] Cooling control"));
-    Serial.println(F("  fan auto           -> use firmware policy"));
-    Serial.println(F("  fan custom duty N  -> set PWM duty 0..1023"));
-    Serial.println(F("  fan failsafe       -> force maximum cooling"));
-    return;
-  }
-  if (topic == "smps") {
-    Serial.println(F("[help smps] SMPS guardband"));
-    Serial.println(F("  smps cut <V>       -> set cut-off voltage"));
-    Serial.println(F("  smps rec <V>       -> set recovery voltage"));
-    Serial.println(F("  smps bypass on|off -> bypass SMPS monitoring"));
+    printSchemaHelp("fan");
+    Serial.println(F("  fan custom duty N  -> sintaks lama (mode + duty sekaligus)"));
     return;
   }
   if (topic == "rtc") {
     Serial.println(F("[help rtc] Clock synchronisation"));
-    Serial.println(F("  rtc set YYYY-MM-DDTHH:MM:SS"));
+    printSchemaHelp("rtc");
     Serial.println(F("  rtc set epoch:<int>"));
     Serial.println(F("  Telemetry exposes rtc_c (temperature) and time."));
     return;
@@ -1584,7 +1847,10 @@ static void printHelpTopic(const String &topic) {
     Serial.println(F("  Use responsibly; no validation performed."));
     return;
   }
-  Serial.println(F("Unknown topic. Available: panel, otg, ota, amp, fan, smps, rtc, reset, raw"));
+  if (printSchemaHelp(topic.c_str())) {
+    return;
+  }
+  Serial.println(F("Unknown topic. Available: panel, otg, ota, amp, power, bt, fan, smps, rtc, set, stats, reset, raw"));
   printHelp();
 }
 
@@ -1605,7 +1871,63 @@ static void handleHostFrame(const String &line, uint32_t now) {
   }
 }
 
+// Frame telemetri parsial (langganan topik) hanya berisi sebagian field;
+// gabungkan ke snapshot terakhir agar perintah "show"/"amp status" tetap utuh.
+static void mergeAmpTelemetry(const JsonDocument &frame) {
+  JsonDocument merged;
+  if (lastAmpTelemetry.isEmpty() || deserializeJson(merged, lastAmpTelemetry) != DeserializationError::Ok) {
+    merged.clear();
+    merged["ver"] = "1";
+    merged["type"] = "telemetry";
+  }
+  JsonObject dst = merged["data"];
+  if (dst.isNull()) {
+    dst = merged["data"].to<JsonObject>();
+  }
+  for (JsonPairConst kv : frame["data"].as<JsonObjectConst>()) {
+    dst[kv.key()] = kv.value();
+  }
+  lastAmpTelemetry = "";
+  serializeJson(merged, lastAmpTelemetry);
+}
+
+// Setelah host sinkron etag, telemetri amplifier hanya membawa nv_etag.
+// Simpan payload nv_get ke snapshot, dan minta nv_get sendiri bila etag
+// berubah agar "show nvs" tetap akurat tanpa blok nvs{} periodik.
+static void storeAmpNvPayload(const JsonDocument &frame) {
+  JsonDocument part;
+  JsonObject data = part["data"].to<JsonObject>();
+  data["nv_etag"] = frame["etag"];
+  data["nvs"] = frame["payload"];
+  mergeAmpTelemetry(part);
+  ampNvEtag = frame["etag"] | "";
+}
+
+static void trackAmpNvEtag(const JsonDocument &frame, uint32_t now) {
+  const char *etag = frame["data"]["nv_etag"] | "";
+  if (!*etag) {
+    return;
+  }
+  if (!frame["data"]["nvs"].isNull()) {
+    ampNvEtag = etag;
+    return;
+  }
+  if (ampNvEtag == etag || ampOtaActive || now - ampNvFetchMs < AMP_NV_REFETCH_MS) {
+    return;
+  }
+  ampNvFetchMs = now;
+  sendJsonToAmp(String("{\"type\":\"cmd\",\"cmd\":{\"nv_get\":true}}"));
+}
+
 static void handleAmpFrame(const String &line, bool forwardToHost) {
+  // Frame credit milik link, tidak diteruskan ke host
+  if (line.startsWith("{\"type\":\"credit\"")) {
+    JsonDocument credit;
+    if (deserializeJson(credit, line) == DeserializationError::Ok) {
+      linkFlowOnCredit(ampFlow, credit["rx"] | 0UL, credit["win"] | 0UL);
+    }
+    return;
+  }
   if (forwardToHost) {
     Serial.print(line);
     Serial.print('\n');
@@ -1613,9 +1935,20 @@ static void handleAmpFrame(const String &line, bool forwardToHost) {
   JsonDocument doc;
   if (deserializeJson(doc, line) == DeserializationError::Ok) {
     trackAmpOtaFromJson(doc);
+    if (doc["id"].is<uint32_t>()) {
+      inflightResolve(doc["id"].as<uint32_t>());
+    }
     const char *type = doc["type"] | "";
     if (strcmp(type, "telemetry") == 0) {
-      lastAmpTelemetry = line;
+      // Frame tanpa nvs{} digabung agar snapshot nvs terakhir tidak hilang
+      if ((doc["partial"] | false) || doc["data"]["nvs"].isNull()) {
+        mergeAmpTelemetry(doc);
+      } else {
+        lastAmpTelemetry = line;
+      }
+      trackAmpNvEtag(doc, millis());
+    } else if (strcmp(type, "nv_get") == 0) {
+      storeAmpNvPayload(doc);
     }
   }
 }
@@ -1638,14 +1971,22 @@ static void serviceHostSerial(uint32_t now) {
 static void serviceAmpSerial(bool forwardToHost) {
   while (Serial2.available()) {
     char c = static_cast<char>(Serial2.read());
+    linkFlowOnRead(ampFlow, 1);
     if (c == '\r') {
       continue;
     }
     if (c == '\n') {
-      handleAmpFrame(ampRxBuffer, forwardToHost);
+      if (ampRxOverflow) {
+        logEvent("amp_frame_overflow");
+        ampRxOverflow = false;
+      } else if (!ampRxBuffer.isEmpty()) {
+        handleAmpFrame(ampRxBuffer, forwardToHost);
+      }
       ampRxBuffer = "";
-    } else if (ampRxBuffer.length() < BRIDGE_MAX_FRAME - 1) {
+    } else if (ampRxBuffer.length() < AMP_MAX_FRAME - 1) {
       ampRxBuffer += c;
+    } else {
+      ampRxOverflow = true;  // buang frame terpotong, jangan teruskan setengah
     }
   }
 }
@@ -1676,6 +2017,7 @@ void setup() {
   digitalWrite(PIN_AMP_GPIO0, HIGH);
 
   Serial.begin(HOST_SERIAL_BAUD);
+  Serial2.setRxBufferSize(AMP_RX_BUFFER_BYTES);
   Serial2.begin(AMP_SERIAL_BAUD, SERIAL_8N1, PIN_UART2_RX, PIN_UART2_TX);
 
   panelOtaInit();
@@ -1691,7 +2033,7 @@ void setup() {
   }
 
   hostRxBuffer.reserve(BRIDGE_MAX_FRAME);
-  ampRxBuffer.reserve(BRIDGE_MAX_FRAME);
+  ampRxBuffer.reserve(AMP_MAX_FRAME);
 
   lastTick = millis();
   stateMs = 0;
@@ -1749,6 +2091,9 @@ void loop() {
   }
 
   serviceSerial(now);
+  flushAmpTxQueue(now);
+  advertiseAmpCredit(now);
+  inflightTick(now);
   panelOtaTick(now);
   updateLedOutputs(now);
 }
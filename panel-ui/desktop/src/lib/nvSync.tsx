@@ -48,8 +48,8 @@ export const NvSyncProvider: React.FC<React.PropsWithChildren> = ({ children })
   }, []);
 
   const refresh = useCallback(async () => {
-    await send('nv_digest?');
-  }, [send]);
+    await send(cache.etag ? `nv_digest? ${cache.etag}` : 'nv_digest?');
+  }, [cache.etag, send]);
 
   const setValue = useCallback(
     async (key: string, value: unknown) => {
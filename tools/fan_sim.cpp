@@ -0,0 +1,313 @@
+// Simulator termal heatsink + kontroler kipas amplifier (host, lebih cepat dari real time).
+//
+// Kontroler yang disimulasikan adalah kode firmware yang sama
+// (firmware/amplifier/src/fan_ctrl.cpp) dengan default dari config.h, jadi
+// tuning FAN_* dan kurva bisa dicoba di sini sebelum di-flash.
+//
+// Build (dari root repo):
+//   g++ -std=c++17 -O2 -I firmware/amplifier/include
+//     tools/fan_sim.cpp firmware/amplifier/src/fan_ctrl.cpp -o fan_sim
+//
+// Contoh:
+//   ./fan_sim --profile music --hours 2 --pi --csv run.csv
+//   ./fan_sim --curve 35:150,50:400,65:800,75:1023 --profile step
+//   ./fan_sim --check          # skenario regresi, exit 1 bila ada yang gagal
+//
+// Model: heatsink lumped C·dT/dt = P − G(airflow)·(T − Ta); airflow kipas
+// mengikuti duty dengan lag (kipas berhenti di bawah duty stall). Probe
+// DS18B20 punya lag termal, kuantisasi 1/8 °C (11 bit) dan dibaca 1 Hz;
+// kontroler dijalankan tiap FAN_CTRL_PERIOD_MS seperti di firmware.
+
+#include "config.h"
+#include "fan_ctrl.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+struct Model {
+  double ambientC   = 30.0;
+  double heatJPerK  = 600.0;   // ~0.7 kg aluminium
+  double gNatWPerK  = 0.4;     // konveksi alami
+  double gFanWPerK  = 2.6;     // tambahan pada duty penuh
+  double fanTauS    = 2.0;     // spin-up/down kipas
+  double stallDuty  = 150.0;   // di bawah ini kipas berhenti
+  double probeTauS  = 8.0;     // lag probe terhadap heatsink
+  double quantC     = 0.125;   // 11 bit
+};
+
+enum class Profile { Step, Music, Idle, Full };
+
+struct Options {
+  Profile  profile = Profile::Music;
+  double   hours   = 2.0;
+  double   dtS     = 0.01;
+  uint32_t seed    = 1;
+  bool     pi      = false;
+  bool     check   = false;
+  FanCurve curve   = {};
+  FanCtrlParams params = {};
+  const char *csv  = nullptr;
+  Model    model;
+};
+
+struct Result {
+  double   tMaxC    = -1e9;
+  double   tEndC    = 0;
+  double   dutyAvg  = 0;
+  double   overS    = 0;       // detik di atas batas
+  uint32_t writes   = 0;       // perubahan duty (tulis LEDC)
+  uint32_t reversals = 0;      // arah duty berbalik (hunting)
+};
+
+// LCG deterministik agar hasil --check stabil antar platform
+struct Rng {
+  uint32_t s;
+  explicit Rng(uint32_t seed) : s(seed ? seed : 1) {}
+  double next() {
+    s = s * 1664525u + 1013904223u;
+    return (s >> 8) / 16777216.0;
+  }
+};
+
+// Daya disipasi (W) sebagai fungsi waktu
+class PowerSource {
+ public:
+  PowerSource(Profile p, uint32_t seed) : prof_(p), rng_(seed) {}
+  double at(double t) {
+    switch (prof_) {
+      case Profile::Idle: return 8.0;
+      case Profile::Full: return 110.0;
+      case Profile::Step:
+        if (t < 60.0) return 8.0;
+        if (t < 2400.0) return 100.0;
+        return 20.0;
+      case Profile::Music:
+      default:
+        // Lagu 3..6 menit dengan level rata-rata acak, dinamika 2..20 s,
+        // jeda antar lagu 5 s
+        if (t >= songEnd_) {
+          songStart_ = songEnd_;
+          songEnd_   = songStart_ + 180.0 + 180.0 * rng_.next();
+          songLevel_ = 25.0 + 75.0 * rng_.next();
+        }
+        if (t < songStart_ + 5.0) return 8.0;
+        if (t >= burstEnd_) {
+          burstEnd_ = t + 2.0 + 18.0 * rng_.next();
+          burstW_   = songLevel_ * (0.5 + rng_.next());
+        }
+        return 8.0 + burstW_;
+    }
+  }
+
+ private:
+  Profile prof_;
+  Rng     rng_;
+  double  songStart_ = 0, songEnd_ = 0, songLevel_ = 0;
+  double  burstEnd_ = 0, burstW_ = 0;
+};
+
+FanCtrlParams defaultParams() {
+  FanCtrlParams p;
+  p.pi           = false;
+  p.setpointC    = FAN_PI_SETPOINT_C;
+  p.kp           = FAN_PI_KP;
+  p.ki           = FAN_PI_KI;
+  p.integMax     = FAN_PI_INTEG_MAX;
+  p.hystC        = FAN_HYST_C;
+  p.slewUpPerS   = FAN_SLEW_UP_PER_S;
+  p.slewDownPerS = FAN_SLEW_DOWN_PER_S;
+  p.deadband     = FAN_DUTY_DEADBAND;
+  p.failDuty     = FAN_SENSOR_FAIL_DUTY;
+  return p;
+}
+
+Result simulate(const Options &o, FILE *csv) {
+  const Model &m = o.model;
+  FanCtrlParams p = o.params;
+  p.pi = o.pi;
+  FanCtrl ctrl;
+  fanCtrlInit(ctrl, p, o.curve);
+
+  PowerSource power(o.profile, o.seed);
+  Result r;
+  double hsC = m.ambientC, probeC = m.ambientC, airflow = 0;
+  double readC = NAN;
+  uint16_t duty = 0;
+  int lastDir = 0;
+  double dutySum = 0;
+  uint64_t steps = 0;
+
+  const double endS   = o.hours * 3600.0;
+  const double ctrlS  = FAN_CTRL_PERIOD_MS / 1000.0;
+  const double limitC = FAN_AUTO_T3_C;
+  double nextCtrl = 0, nextRead = 0, nextLog = 0;
+
+  for (double t = 0; t < endS; t += o.dtS, ++steps) {
+    double w = power.at(t);
+
+    // Aliran udara mengikuti duty (stall di bawah ambang)
+    double want = duty < m.stallDuty ? 0.0 : duty / 1023.0;
+    airflow += (want - airflow) * (o.dtS / m.fanTauS);
+    double g = m.gNatWPerK + m.gFanWPerK * std::pow(airflow, 0.8);
+    hsC    += (w - g * (hsC - m.ambientC)) * o.dtS / m.heatJPerK;
+    probeC += (hsC - probeC) * (o.dtS / m.probeTauS);
+
+    if (t >= nextRead) {
+      nextRead += DS18B20_PERIOD_MS / 1000.0;
+      readC = std::round(probeC / m.quantC) * m.quantC;
+    }
+    if (t >= nextCtrl) {
+      nextCtrl += ctrlS;
+      uint16_t d = fanCtrlStep(ctrl, (float)readC, (float)ctrlS);
+      if (d != duty) {
+        int dir = d > duty ? 1 : -1;
+        if (lastDir != 0 && dir != lastDir) ++r.reversals;
+        lastDir = dir;
+        duty = d;
+        ++r.writes;
+      }
+    }
+
+    if (hsC > r.tMaxC) r.tMaxC = hsC;
+    if (hsC > limitC) r.overS += o.dtS;
+    dutySum += duty;
+
+    if (csv && t >= nextLog) {
+      nextLog += 1.0;
+      std::fprintf(csv, "%.0f,%.1f,%.2f,%.3f,%u\n", t, w, hsC, readC, duty);
+    }
+  }
+  r.tEndC   = hsC;
+  r.dutyAvg = steps ? dutySum / steps : 0;
+  return r;
+}
+
+bool parseCurve(const char *s, FanCurve &c) {
+  std::memset(&c, 0, sizeof(c));
+  std::string str(s);
+  size_t pos = 0;
+  while (pos < str.size() && c.n < FAN_CURVE_MAX_POINTS) {
+    size_t comma = str.find(',', pos);
+    std::string pt = str.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+    int t = 0, d = 0;
+    if (std::sscanf(pt.c_str(), "%d:%d", &t, &d) != 2 || t < 0 || t > 255) return false;
+    c.tC[c.n]   = (uint8_t)t;
+    c.duty[c.n] = (uint16_t)d;
+    ++c.n;
+    if (comma == std::string::npos) break;
+    pos = comma + 1;
+  }
+  return fanCurveValid(c);
+}
+
+const char *profileName(Profile p) {
+  switch (p) {
+    case Profile::Step:  return "step";
+    case Profile::Idle:  return "idle";
+    case Profile::Full:  return "full";
+    default:             return "music";
+  }
+}
+
+void printResult(const char *label, const Options &o, const Result &r) {
+  std::printf("%-14s %-5s pi=%-3s  Tmax %6.2f °C  Tend %6.2f °C  duty avg %6.1f  "
+              "writes/h %6.0f  reversal/h %5.1f  >%.0f°C %5.0f s\n",
+              label, profileName(o.profile), o.pi ? "on" : "off", r.tMaxC, r.tEndC, r.dutyAvg,
+              r.writes / o.hours, r.reversals / o.hours, (double)FAN_AUTO_T3_C, r.overS);
+}
+
+// Skenario regresi: heatsink tidak boleh lewat batas kurva, kipas tidak
+// boleh "hunting" (arah duty bolak-balik terus)
+int runChecks(Options base) {
+  struct Case { Profile prof; bool pi; double maxC; double maxRevPerH; };
+  const Case cases[] = {
+    { Profile::Step,  false, FAN_AUTO_T3_C, 5.0 },
+    { Profile::Step,  true,  FAN_AUTO_T3_C, 5.0 },
+    { Profile::Music, false, FAN_AUTO_T3_C, 30.0 },
+    { Profile::Music, true,  FAN_AUTO_T3_C, 30.0 },
+    { Profile::Full,  false, FAN_AUTO_T3_C, 2.0 },
+    { Profile::Idle,  false, FAN_AUTO_T1_C, 2.0 },
+  };
+  int fails = 0;
+  for (const Case &c : cases) {
+    Options o = base;
+    o.profile = c.prof;
+    o.pi      = c.pi;
+    Result r = simulate(o, nullptr);
+    bool ok = r.tMaxC <= c.maxC && r.reversals / o.hours <= c.maxRevPerH;
+    printResult(ok ? "✅" : "❌", o, r);
+    if (!ok) ++fails;
+  }
+  return fails ? 1 : 0;
+}
+
+void usage() {
+  std::puts("fan_sim [--profile step|music|idle|full] [--hours H] [--pi] [--curve T:D,..]\n"
+            "        [--kp X] [--ki X] [--setpoint C] [--hyst C] [--slew-up X] [--slew-down X]\n"
+            "        [--deadband D]\n"
+            "        [--ambient C] [--seed N] [--csv FILE] [--check]");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options o;
+  fanCurveDefault(o.curve);
+  o.params = defaultParams();
+
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    auto val = [&]() -> const char * {
+      if (i + 1 >= argc) { usage(); std::exit(2); }
+      return argv[++i];
+    };
+    if (a == "--profile") {
+      std::string p = val();
+      o.profile = p == "step" ? Profile::Step : p == "idle" ? Profile::Idle
+                : p == "full" ? Profile::Full : Profile::Music;
+    } else if (a == "--hours")     o.hours = std::atof(val());
+    else if (a == "--pi")          o.pi = true;
+    else if (a == "--check")       o.check = true;
+    else if (a == "--kp")          o.params.kp = (float)std::atof(val());
+    else if (a == "--ki")          o.params.ki = (float)std::atof(val());
+    else if (a == "--setpoint")    o.params.setpointC = (float)std::atof(val());
+    else if (a == "--hyst")        o.params.hystC = (float)std::atof(val());
+    else if (a == "--slew-up")     o.params.slewUpPerS = (float)std::atof(val());
+    else if (a == "--slew-down")   o.params.slewDownPerS = (float)std::atof(val());
+    else if (a == "--deadband")    o.params.deadband = (float)std::atof(val());
+    else if (a == "--ambient")     o.model.ambientC = std::atof(val());
+    else if (a == "--seed")        o.seed = (uint32_t)std::strtoul(val(), nullptr, 10);
+    else if (a == "--csv")         o.csv = val();
+    else if (a == "--curve") {
+      if (!parseCurve(val(), o.curve)) {
+        std::fprintf(stderr, "❌ kurva tidak valid (2..%d titik T:D, suhu naik ketat)\n", FAN_CURVE_MAX_POINTS);
+        return 2;
+      }
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  if (o.check) return runChecks(o);
+
+  FILE *csv = nullptr;
+  if (o.csv) {
+    csv = std::fopen(o.csv, "w");
+    if (!csv) {
+      std::perror(o.csv);
+      return 2;
+    }
+    std::fputs("t_s,power_w,heatsink_c,sensor_c,duty\n", csv);
+  }
+  Result r = simulate(o, csv);
+  if (csv) std::fclose(csv);
+  printResult("sim", o, r);
+  return 0;
+}
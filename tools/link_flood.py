@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""Uji banjir command ke amplifier lewat panel, lalu cek latensi proteksi SMPS.
+
+Alur:
+  1. Kirim `diag` untuk me-reset puncak `loop.prot_gap_max_us`.
+  2. Kirim N command campuran secepat mungkin (fan_duty, spk_sel, batch
+     preset, buzz) tanpa menunggu ACK.
+  3. Tunggu link tenang, kirim `diag` lagi, bandingkan puncak jarak antar
+     cek proteksi dengan batas --max-gap-us.
+
+Exit code 0 = lulus, 1 = latensi melebihi batas, 2 = tidak ada balasan diag.
+Butuh pyserial (`pip install pyserial`).
+"""
+import argparse, json, sys, time
+
+try:
+    import serial
+except ImportError:
+    raise SystemExit("❌ pyserial belum terpasang: pip install pyserial")
+
+
+def send(port, obj):
+    port.write((json.dumps(obj, separators=(",", ":")) + "\n").encode())
+
+
+def flood_frames(count, with_ids):
+    frames = []
+    for i in range(count):
+        kind = i % 4
+        if kind == 0:
+            cmd = {"fan_duty": (i * 37) % 1024}
+        elif kind == 1:
+            cmd = {"spk_sel": "big" if i % 8 == 1 else "small"}
+        elif kind == 2:
+            cmd = {"fan_mode": "custom", "fan_duty": (i * 13) % 1024}
+        else:
+            cmd = {"buzz": {"f": 2000, "d": 256, "ms": 10}}
+        frame = {"type": "cmd", "cmd": cmd}
+        if with_ids:
+            frame["id"] = i + 1
+        frames.append(frame)
+    return frames
+
+
+def read_diag(port, timeout_s):
+    deadline = time.monotonic() + timeout_s
+    while time.monotonic() < deadline:
+        line = port.readline().decode(errors="replace").strip()
+        if not line.startswith("{"):
+            continue
+        try:
+            doc = json.loads(line)
+        except json.JSONDecodeError:
+            continue
+        if doc.get("type") == "diag":
+            return doc
+    return None
+
+
+def request_diag(port, timeout_s):
+    port.reset_input_buffer()
+    send(port, {"type": "cmd", "cmd": {"diag": True}})
+    return read_diag(port, timeout_s)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", help="port serial panel, mis. /dev/ttyUSB0 atau COM5")
+    ap.add_argument("--baud", type=int, default=921600)
+    ap.add_argument("--count", type=int, default=400, help="jumlah command banjir")
+    ap.add_argument("--with-ids", action="store_true", help="sertakan request id (dibatasi tabel in-flight panel)")
+    ap.add_argument("--max-gap-us", type=int, default=20000, help="batas jarak antar cek proteksi SMPS")
+    ap.add_argument("--settle", type=float, default=2.0, help="detik menunggu link tenang")
+    args = ap.parse_args()
+
+    with serial.Serial(args.port, args.baud, timeout=0.2) as port:
+        time.sleep(0.5)
+        if request_diag(port, 2.0) is None:
+            print("❌ amplifier tidak membalas diag")
+            return 2
+
+        print(f"🌊 flood {args.count} command ...")
+        t0 = time.monotonic()
+        for frame in flood_frames(args.count, args.with_ids):
+            send(port, frame)
+        print(f"   terkirim dalam {time.monotonic() - t0:.2f} s")
+
+        # Jeda > LINK_LOW_PRIO_MIN_MS agar diag tidak kena rate-limit
+        time.sleep(args.settle)
+        diag = request_diag(port, 3.0)
+        if diag is None:
+            print("❌ amplifier tidak membalas diag setelah flood")
+            return 2
+
+    gap = diag.get("loop", {}).get("prot_gap_max_us", 0)
+    rx = diag.get("rx", {})
+    link = diag.get("link", {})
+    print(f"📊 prot_gap_max_us={gap} (batas {args.max_gap_us})")
+    print(f"   rx={json.dumps(rx)}")
+    print(f"   link={json.dumps(link)}")
+    if gap > args.max_gap_us:
+        print("❌ latensi proteksi melebihi batas")
+        return 1
+    print("✅ lulus")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
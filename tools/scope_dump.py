@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""Arm scope mode tegangan SMPS di amplifier lewat panel, tunggu capture, simpan CSV.
+
+Alur:
+  1. Kirim {"scope":{"arm":true,...}} (auto dump aktif).
+  2. Tunggu frame `scope` state=done lalu kumpulkan semua `scope_chunk`.
+  3. Decode int16 little-endian → volt (kode × v_per_lsb), tulis CSV
+     `t_ms,volt` dengan t=0 di sampel trigger.
+
+Exit code 0 = capture tersimpan, 1 = chunk hilang/rusak, 2 = timeout.
+Butuh pyserial (`pip install pyserial`).
+"""
+import argparse, base64, csv, json, struct, sys, time
+
+try:
+    import serial
+except ImportError:
+    raise SystemExit("❌ pyserial belum terpasang: pip install pyserial")
+
+
+def send(port, obj):
+    port.write((json.dumps(obj, separators=(",", ":")) + "\n").encode())
+
+
+def read_frames(port, deadline):
+    while time.monotonic() < deadline:
+        line = port.readline().decode(errors="replace").strip()
+        if not line.startswith("{"):
+            continue
+        try:
+            yield json.loads(line)
+        except json.JSONDecodeError:
+            continue
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", help="port serial panel, mis. /dev/ttyUSB0 atau COM5")
+    ap.add_argument("--baud", type=int, default=921600)
+    ap.add_argument("--trig-v", type=float, default=None, help="ambang trigger (V); 0 = manual saja")
+    ap.add_argument("--pre", type=int, default=512, help="sampel sebelum trigger")
+    ap.add_argument("--n", type=int, default=2048, help="total sampel")
+    ap.add_argument("--manual", action="store_true", help="langsung kirim scope:trigger setelah arm")
+    ap.add_argument("--timeout", type=float, default=60.0, help="detik menunggu trigger + dump")
+    ap.add_argument("-o", "--out", default="scope.csv")
+    args = ap.parse_args()
+
+    arm = {"arm": True, "pre": args.pre, "n": args.n, "auto": True}
+    if args.trig_v is not None:
+        arm["trig_v"] = args.trig_v
+
+    header, chunks = None, {}
+    with serial.Serial(args.port, args.baud, timeout=0.2) as port:
+        time.sleep(0.5)
+        port.reset_input_buffer()
+        send(port, {"type": "cmd", "cmd": {"scope": arm}})
+        if args.manual:
+            # Beri waktu pre-trigger terisi (≈ pre / 860 s)
+            time.sleep(args.pre / 860.0 + 0.2)
+            send(port, {"type": "cmd", "cmd": {"scope": "trigger"}})
+        print(f"⏳ armed (pre={args.pre}, n={args.n}), menunggu capture ...")
+
+        for doc in read_frames(port, time.monotonic() + args.timeout):
+            t = doc.get("type")
+            if t == "ack" and doc.get("ok") is False:
+                print(f"❌ ditolak: {json.dumps(doc)}")
+                return 2
+            if t == "scope" and doc.get("state") == "done":
+                header, chunks = doc, {}
+            elif t == "scope_chunk" and header is not None:
+                chunks[doc["off"]] = base64.b64decode(doc["data_b64"])
+                if doc.get("last"):
+                    break
+        else:
+            print("❌ timeout")
+            return 2
+
+    raw = b"".join(chunks[k] for k in sorted(chunks))
+    codes = struct.unpack(f"<{len(raw) // 2}h", raw)
+    if len(codes) != header["n"]:
+        print(f"❌ sampel {len(codes)} dari {header['n']}")
+        return 1
+
+    lsb, pre, period = header["v_per_lsb"], header["pre"], header["period_us"]
+    with open(args.out, "w", newline="") as f:
+        w = csv.writer(f)
+        w.writerow(["t_ms", "volt"])
+        for i, c in enumerate(codes):
+            w.writerow([f"{(i - pre) * period / 1000.0:.3f}", f"{c * lsb:.3f}"])
+
+    volts = [c * lsb for c in codes]
+    print(f"✅ {len(codes)} sampel → {args.out} (trigger {header['trig']}, period {period} µs, "
+          f"max gap {header['max_gap_us']} µs)")
+    print(f"   min {min(volts):.2f} V  max {max(volts):.2f} V")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
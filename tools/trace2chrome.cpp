@@ -0,0 +1,256 @@
+// Konverter trace event amplifier → JSON Chrome/Perfetto (host).
+//
+// Tangkap output panel setelah command "trace dump" (frame "trace" lalu
+// "trace_chunk" sampai last=true), simpan ke file, lalu:
+//
+// Build (dari root repo):
+//   g++ -std=c++17 -O2 -I firmware/amplifier/include -I firmware/common/include
+//     tools/trace2chrome.cpp -o trace2chrome
+//
+// Contoh:
+//   ./trace2chrome capture.log -o trace.json     # buka di ui.perfetto.dev
+//   ./trace2chrome < capture.log > trace.json    # chrome://tracing
+//
+// Tabel event (nama, jenis) diambil dari TRACE_EVENTS di trace.h dan nama
+// command dari cmd_schema.h, sama dengan firmware. Baris non-JSON di log
+// diabaikan; bila ada beberapa dump, yang terakhir lengkap yang dipakai.
+// Exit code 0 = OK, 1 = chunk hilang/rusak, 2 = argumen/IO.
+
+#include "trace.h"
+#include "cmd_schema.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Cari `"key":` dalam baris JSON ringkas (ArduinoJson tanpa spasi)
+const char *field(const std::string &line, const char *key) {
+  std::string pat = std::string("\"") + key + "\":";
+  size_t p = line.find(pat);
+  return p == std::string::npos ? nullptr : line.c_str() + p + pat.size();
+}
+
+bool fieldUint(const std::string &line, const char *key, uint32_t &out) {
+  const char *p = field(line, key);
+  if (!p) return false;
+  char *end = nullptr;
+  unsigned long v = std::strtoul(p, &end, 10);
+  if (end == p) return false;
+  out = (uint32_t)v;
+  return true;
+}
+
+bool fieldStr(const std::string &line, const char *key, std::string &out) {
+  const char *p = field(line, key);
+  if (!p || *p != '"') return false;
+  const char *e = std::strchr(p + 1, '"');
+  if (!e) return false;
+  out.assign(p + 1, e);
+  return true;
+}
+
+bool fieldTrue(const std::string &line, const char *key) {
+  const char *p = field(line, key);
+  return p && std::strncmp(p, "true", 4) == 0;
+}
+
+// ["a","b",..] → daftar string
+std::vector<std::string> fieldStrArray(const std::string &line, const char *key) {
+  std::vector<std::string> out;
+  const char *p = field(line, key);
+  if (!p || *p != '[') return out;
+  ++p;
+  while (*p && *p != ']') {
+    if (*p == '"') {
+      const char *e = std::strchr(p + 1, '"');
+      if (!e) break;
+      out.emplace_back(p + 1, e);
+      p = e + 1;
+    } else {
+      ++p;
+    }
+  }
+  return out;
+}
+
+int b64val(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '+') return 62;
+  if (c == '/') return 63;
+  return -1;
+}
+
+bool b64decode(const std::string &in, std::vector<uint8_t> &out) {
+  uint32_t acc = 0;
+  int bits = 0;
+  for (char c : in) {
+    if (c == '=') break;
+    int v = b64val(c);
+    if (v < 0) return false;
+    acc = (acc << 6) | (uint32_t)v;
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      out.push_back((uint8_t)(acc >> bits));
+    }
+  }
+  return true;
+}
+
+uint32_t le32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+struct Dump {
+  std::vector<std::string> tasks;
+  uint32_t expect = 0;                // n di header
+  uint32_t nextOff = 0;
+  std::vector<uint8_t> bytes;
+  bool complete = false;
+  bool broken   = false;
+};
+
+void usage() {
+  std::fprintf(stderr, "pakai: trace2chrome [log] [-o out.json]\n");
+}
+
+void writeJson(FILE *f, const Dump &d) {
+  const size_t n = d.bytes.size() / sizeof(TraceRec);
+  std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+  std::fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"amplifier\"}}", f);
+  // tid = index task + 1; 0 = ISR/task lain
+  for (size_t t = 0; t <= d.tasks.size(); ++t) {
+    std::string name = t == 0 ? "other" : d.tasks[t - 1];
+    std::fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+                 t, name.c_str());
+  }
+
+  uint64_t t64 = 0;
+  uint32_t prev = 0;
+  for (size_t i = 0; i < n; ++i) {
+    const uint8_t *p = d.bytes.data() + i * sizeof(TraceRec);
+    uint32_t ts   = le32(p);
+    uint8_t  id   = p[4];
+    uint8_t  task = p[5];
+    uint16_t a    = (uint16_t)(p[6] | (p[7] << 8));
+    uint32_t b    = le32(p + 8);
+    // micros() 32 bit: selisih bertanda → wrap ±35 menit & urutan antar task
+    // yang sedikit bertukar tetap benar
+    if (i == 0) t64 = 1000000;   // ruang untuk span pertama
+    else        t64 = (uint64_t)((int64_t)t64 + (int32_t)(ts - prev));
+    prev = ts;
+    if (id >= (uint8_t)TraceEv::Count) continue;
+
+    const TraceEvInfo &ev = TRACE_EV_INFO[id];
+    unsigned tid = (task == TRACE_TASK_OTHER || task >= d.tasks.size()) ? 0u : (unsigned)task + 1;
+    std::string name = ev.name;
+    if ((TraceEv)id == TraceEv::Cmd && a < CMD_SPEC_COUNT) name += std::string(":") + CMD_SPECS[a].key;
+
+    switch (ev.kind) {
+      case TraceKind::Counter:
+        std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%llu,\"pid\":1,\"args\":{\"value\":%u}}",
+                     name.c_str(), (unsigned long long)t64, a);
+        break;
+      case TraceKind::Span:
+        std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%u,\"pid\":1,\"tid\":%u,\"args\":{\"a\":%u}}",
+                     name.c_str(), (unsigned long long)(t64 > b ? t64 - b : 0), b, tid, a);
+        break;
+      case TraceKind::Instant:
+      default:
+        std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%llu,\"pid\":1,\"tid\":%u,\"args\":{\"a\":%u,\"b\":%u}}",
+                     name.c_str(), (unsigned long long)t64, tid, a, b);
+        break;
+    }
+  }
+  std::fputs("\n]}\n", f);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const char *inPath = nullptr;
+  const char *outPath = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      outPath = argv[++i];
+    } else if (argv[i][0] == '-') {
+      usage();
+      return 2;
+    } else {
+      inPath = argv[i];
+    }
+  }
+
+  FILE *in = inPath ? std::fopen(inPath, "r") : stdin;
+  if (!in) {
+    std::perror(inPath);
+    return 2;
+  }
+
+  Dump cur, done;
+  bool haveDone = false;
+  std::string line;
+  int c;
+  for (;;) {
+    line.clear();
+    while ((c = std::fgetc(in)) != EOF && c != '\n') line.push_back((char)c);
+    if (line.empty() && c == EOF) break;
+
+    std::string type;
+    if (!fieldStr(line, "type", type)) continue;
+    if (type == "trace") {
+      // Header baru (status/dump) memulai tangkapan baru
+      cur = Dump();
+      cur.tasks = fieldStrArray(line, "tasks");
+      fieldUint(line, "n", cur.expect);
+    } else if (type == "trace_chunk") {
+      uint32_t off = 0, n = 0;
+      std::string b64;
+      if (!fieldUint(line, "off", off) || !fieldUint(line, "n", n) || !fieldStr(line, "data_b64", b64)) {
+        cur.broken = true;
+        continue;
+      }
+      std::vector<uint8_t> raw;
+      if (off != cur.nextOff || !b64decode(b64, raw) || raw.size() != n * sizeof(TraceRec)) {
+        std::fprintf(stderr, "⚠️  chunk off=%u rusak/hilang (harap off=%u)\n", off, cur.nextOff);
+        cur.broken = true;
+      } else {
+        cur.bytes.insert(cur.bytes.end(), raw.begin(), raw.end());
+        cur.nextOff += n;
+      }
+      if (fieldTrue(line, "last")) {
+        cur.complete = !cur.broken && cur.nextOff == cur.expect;
+        if (cur.complete || !haveDone) {
+          done = cur;
+          haveDone = true;
+        }
+      }
+    }
+    if (c == EOF) break;
+  }
+  if (in != stdin) std::fclose(in);
+
+  if (!haveDone) {
+    std::fprintf(stderr, "❌ tidak ada dump trace (frame trace_chunk last=true)\n");
+    return 1;
+  }
+
+  FILE *out = outPath ? std::fopen(outPath, "w") : stdout;
+  if (!out) {
+    std::perror(outPath);
+    return 2;
+  }
+  writeJson(out, done);
+  if (out != stdout) std::fclose(out);
+
+  size_t n = done.bytes.size() / sizeof(TraceRec);
+  std::fprintf(stderr, "%s %zu record (header n=%u)\n", done.complete ? "✅" : "⚠️ ", n, done.expect);
+  return done.complete ? 0 : 1;
+}